@@ -0,0 +1,928 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <tuple>
+#include <vector>
+#include "mapGen.h"
+#include "aStar.h"
+#include "jps.h"
+#include "hierarchicalSearch.h"
+#include "dstarLite.h"
+#include "bidirectional.h"
+#include "idaStar.h"
+#include "araStar.h"
+#include "landmarks.h"
+#include "pathDatabase.h"
+#include "navGrid.h"
+#include "dial.h"
+#include "clearance.h"
+#include "thetaStar.h"
+#include "roomGraph.h"
+#include "portalHierarchy.h"
+#include "whcaStar.h"
+#include "flowField.h"
+#include "components.h"
+
+// Headless comparison of the navigation searches on seeded map sets.
+// usage: nav_benchmark [--maps N] [--queries N] [--size N] [--seed N] [--ida-budget N] [--agents N] [--turns N]
+
+struct Settings
+{
+  size_t maps = 5;
+  size_t queries = 200;
+  size_t size = 100;
+  unsigned seed = 1;
+  size_t idaBudget = 100000; // plain IDA* gives up on the long winding drunk queries, see the fail column
+  size_t agents = 128;
+  size_t turns = 100;
+};
+
+struct Corpus
+{
+  const char *name;
+  std::function<void(bench::Rng &, char *, size_t, size_t)> gen;
+};
+
+struct Query
+{
+  nav::GridPos from;
+  nav::GridPos to;
+  float cost;
+};
+
+// state of all variants, reused between queries like the demo does
+struct BenchState
+{
+  nav::SearchContext ctx;
+  nav::JumpTable jumpTable;
+  nav::DungeonPortals portals;
+  nav::HierarchicalContext hierCtx;
+  nav::DStarLite dstar;
+  nav::BidirectionalContext bidirCtx;
+  nav::IdaStarContext idaCtx;
+  nav::AraStarContext araCtx;
+  nav::LandmarkTable landmarks;
+  nav::PathDatabase pathDb;
+  nav::NavGrid navGrid;
+  nav::CostLayer costLayer;
+  nav::DialContext dialCtx;
+  nav::ClearanceMap clearance;
+  nav::RoomGraph rooms;
+  nav::RoomContext roomCtx;
+  nav::PortalHierarchy hierarchy;
+  nav::PortalHierarchyContext hierarchyCtx;
+  bool uniformCost = true;
+};
+
+struct Variant
+{
+  const char *name;
+  bool optimal;
+  // per map preprocessing, timed separately
+  std::function<void(BenchState &, const nav::GridView &)> prepare;
+  std::function<std::vector<nav::GridPos>(BenchState &, const nav::GridView &, nav::GridPos, nav::GridPos)> find;
+  std::function<size_t(const BenchState &)> expanded;
+  std::function<size_t(const BenchState &)> memory;
+};
+
+struct VariantStats
+{
+  std::vector<double> timesUs;
+  size_t expanded = 0;
+  size_t failed = 0;
+  size_t invalid = 0;
+  double costRatio = 0.0;
+  size_t solved = 0;
+  double prepMs = 0.0;
+  size_t memory = 0;
+};
+
+template<typename T>
+static size_t vec_bytes(const std::vector<T> &v)
+{
+  return v.capacity() * sizeof(T);
+}
+
+static size_t ctx_bytes(const nav::SearchContext &ctx)
+{
+  return vec_bytes(ctx.g) + vec_bytes(ctx.prev) + vec_bytes(ctx.seenGen) + vec_bytes(ctx.closedGen) +
+         vec_bytes(ctx.open);
+}
+
+static size_t portals_bytes(const nav::DungeonPortals &dp)
+{
+  return vec_bytes(dp.startX) + vec_bytes(dp.startY) + vec_bytes(dp.endX) + vec_bytes(dp.endY) +
+         vec_bytes(dp.portalClearance) + vec_bytes(dp.connStart) + vec_bytes(dp.conns) + vec_bytes(dp.clusterStart) +
+         vec_bytes(dp.clusterPortals) + vec_bytes(dp.clearance.clearance);
+}
+
+static size_t rooms_bytes(const nav::RoomGraph &rg)
+{
+  size_t res = vec_bytes(rg.roomOf) + vec_bytes(rg.roomRects) + vec_bytes(rg.roomDoors) + vec_bytes(rg.doors);
+  for (const std::vector<uint32_t> &doors : rg.roomDoors)
+    res += vec_bytes(doors);
+  for (const nav::RoomDoor &door : rg.doors)
+    res += vec_bytes(door.tiles[0]) + vec_bytes(door.tiles[1]) + vec_bytes(door.links[0]) +
+           vec_bytes(door.links[1]);
+  res += vec_bytes(rg.linkPaths);
+  for (const std::vector<uint32_t> &path : rg.linkPaths)
+    res += vec_bytes(path);
+  return res;
+}
+
+static size_t hierarchy_bytes(const nav::PortalHierarchy &ph)
+{
+  size_t res = vec_bytes(ph.levels);
+  for (const nav::PortalLevel &lv : ph.levels)
+    res += vec_bytes(lv.entryStart) + vec_bytes(lv.entries) + vec_bytes(lv.matrixStart) + vec_bytes(lv.distances) +
+           vec_bytes(lv.entryOf[0]) + vec_bytes(lv.entryOf[1]);
+  return res;
+}
+
+static size_t dstar_bytes(const nav::DStarLite &ds)
+{
+  return vec_bytes(ds.g) + vec_bytes(ds.rhs) + vec_bytes(ds.openKey) + vec_bytes(ds.inOpen) + vec_bytes(ds.open);
+}
+
+static size_t landmarks_bytes(const nav::LandmarkTable &table)
+{
+  return vec_bytes(table.landmarks) + vec_bytes(table.fromDist) + vec_bytes(table.toDist);
+}
+
+static size_t path_db_bytes(const nav::PathDatabase &db)
+{
+  return vec_bytes(db.rank) + vec_bytes(db.component) + vec_bytes(db.rowStart) + vec_bytes(db.runs);
+}
+
+static size_t dial_bytes(const nav::DialContext &dctx)
+{
+  size_t res = ctx_bytes(dctx.tiles) + vec_bytes(dctx.open.buckets);
+  for (const std::vector<uint32_t> &bucket : dctx.open.buckets)
+    res += vec_bytes(bucket);
+  return res;
+}
+
+static std::vector<Variant> make_variants()
+{
+  auto noPrepare = [](BenchState &, const nav::GridView &) {};
+  auto ctxExpanded = [](const BenchState &bs) { return bs.ctx.expanded; };
+  auto ctxMemory = [](const BenchState &bs) { return ctx_bytes(bs.ctx); };
+  auto weighted = [](float weight)
+  {
+    return [weight](BenchState &bs, const nav::GridView &grid, nav::GridPos from, nav::GridPos to)
+    {
+      return nav::find_path_a_star(bs.ctx, grid, from, to, weight);
+    };
+  };
+  std::vector<Variant> res;
+  res.push_back({"A*", true, noPrepare, weighted(1.f), ctxExpanded, ctxMemory});
+  auto buildLandmarks = [](BenchState &bs, const nav::GridView &grid) { bs.landmarks = nav::build_landmarks(grid); };
+  res.push_back({"A* ALT", true, buildLandmarks,
+                 [](BenchState &bs, const nav::GridView &grid, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::find_path_a_star(bs.ctx, grid, from, to, bs.landmarks);
+                 }, ctxExpanded,
+                 [](const BenchState &bs) { return ctx_bytes(bs.ctx) + landmarks_bytes(bs.landmarks); }});
+  res.push_back({"A* NavGrid", true,
+                 [](BenchState &bs, const nav::GridView &grid) { bs.navGrid = nav::build_nav_grid(grid); },
+                 [](BenchState &bs, const nav::GridView &, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::find_path_a_star(bs.ctx, bs.navGrid, from, to);
+                 }, ctxExpanded,
+                 [](const BenchState &bs) { return ctx_bytes(bs.ctx) + vec_bytes(bs.navGrid.bits) + vec_bytes(bs.navGrid.costs); }});
+  // any-angle paths are shorter than any grid path, the cost column shows by how much
+  res.push_back({"Theta*", false,
+                 [](BenchState &bs, const nav::GridView &grid) { bs.navGrid = nav::build_nav_grid(grid); },
+                 [](BenchState &bs, const nav::GridView &, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::find_path_theta_star(bs.ctx, bs.navGrid, from, to);
+                 }, ctxExpanded,
+                 [](const BenchState &bs) { return ctx_bytes(bs.ctx) + vec_bytes(bs.navGrid.bits); }});
+  res.push_back({"lazy Theta*", false,
+                 [](BenchState &bs, const nav::GridView &grid) { bs.navGrid = nav::build_nav_grid(grid); },
+                 [](BenchState &bs, const nav::GridView &, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::find_path_lazy_theta_star(bs.ctx, bs.navGrid, from, to);
+                 }, ctxExpanded,
+                 [](const BenchState &bs) { return ctx_bytes(bs.ctx) + vec_bytes(bs.navGrid.bits); }});
+  res.push_back({"A* string pulled", false,
+                 [](BenchState &bs, const nav::GridView &grid) { bs.navGrid = nav::build_nav_grid(grid); },
+                 [](BenchState &bs, const nav::GridView &, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::string_pull(bs.navGrid, nav::find_path_a_star(bs.ctx, bs.navGrid, from, to));
+                 }, ctxExpanded,
+                 [](const BenchState &bs) { return ctx_bytes(bs.ctx) + vec_bytes(bs.navGrid.bits); }});
+  res.push_back({"weighted A* 1.5", false, noPrepare, weighted(1.5f), ctxExpanded, ctxMemory});
+  res.push_back({"weighted A* 3", false, noPrepare, weighted(3.f), ctxExpanded, ctxMemory});
+  res.push_back({"Dijkstra", true, noPrepare, weighted(0.f), ctxExpanded, ctxMemory});
+  auto buildCostLayer = [](BenchState &bs, const nav::GridView &grid) { bs.costLayer = nav::build_cost_layer(grid); };
+  auto dialExpanded = [](const BenchState &bs) { return bs.dialCtx.tiles.expanded; };
+  auto dialMemory = [](const BenchState &bs) { return dial_bytes(bs.dialCtx) + vec_bytes(bs.costLayer.costs); };
+  res.push_back({"Dial Dijkstra", true, buildCostLayer,
+                 [](BenchState &bs, const nav::GridView &, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::find_path_dial_dijkstra(bs.dialCtx, bs.costLayer, from, to);
+                 }, dialExpanded, dialMemory});
+  res.push_back({"Dial A*", true, buildCostLayer,
+                 [](BenchState &bs, const nav::GridView &, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::find_path_dial_a_star(bs.dialCtx, bs.costLayer, from, to);
+                 }, dialExpanded, dialMemory});
+  res.push_back({"JPS", true,
+                 [](BenchState &bs, const nav::GridView &grid) { bs.uniformCost = nav::has_uniform_cost(grid); },
+                 [](BenchState &bs, const nav::GridView &grid, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::find_path_jps(bs.ctx, grid, bs.uniformCost, from, to);
+                 }, ctxExpanded, ctxMemory});
+  res.push_back({"JPS+", true,
+                 [](BenchState &bs, const nav::GridView &grid) { bs.jumpTable = nav::build_jump_table(grid); },
+                 [](BenchState &bs, const nav::GridView &grid, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::find_path_jps_plus(bs.ctx, grid, bs.jumpTable, from, to);
+                 }, ctxExpanded,
+                 [](const BenchState &bs) { return ctx_bytes(bs.ctx) + vec_bytes(bs.jumpTable.dist); }});
+  res.push_back({"JPS+ ALT", true,
+                 [](BenchState &bs, const nav::GridView &grid)
+                 {
+                   bs.jumpTable = nav::build_jump_table(grid);
+                   bs.landmarks = nav::build_landmarks(grid);
+                 },
+                 [](BenchState &bs, const nav::GridView &grid, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::find_path_jps_plus(bs.ctx, grid, bs.jumpTable, bs.landmarks, from, to);
+                 }, ctxExpanded,
+                 [](const BenchState &bs)
+                 {
+                   return ctx_bytes(bs.ctx) + vec_bytes(bs.jumpTable.dist) + landmarks_bytes(bs.landmarks);
+                 }});
+  res.push_back({"HPA*", false,
+                 [](BenchState &bs, const nav::GridView &grid) { bs.portals = nav::build_portals(grid, 10); },
+                 [](BenchState &bs, const nav::GridView &grid, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::find_path_hierarchical(bs.hierCtx, grid, bs.portals, from, to);
+                 },
+                 [](const BenchState &bs) { return bs.hierCtx.tileCtx.expanded + bs.hierCtx.portalCtx.expanded; },
+                 [](const BenchState &bs)
+                 {
+                   return ctx_bytes(bs.hierCtx.tileCtx) + ctx_bytes(bs.hierCtx.portalCtx) + portals_bytes(bs.portals);
+                 }});
+  res.push_back({"multilevel HPA*", false,
+                 [](BenchState &bs, const nav::GridView &grid)
+                 {
+                   bs.portals = nav::build_portals(grid, 10);
+                   bs.hierarchy = nav::build_portal_hierarchy(grid, bs.portals);
+                 },
+                 [](BenchState &bs, const nav::GridView &grid, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::find_path_multilevel(bs.hierarchyCtx, grid, bs.portals, bs.hierarchy, from, to);
+                 },
+                 [](const BenchState &bs)
+                 {
+                   return bs.hierarchyCtx.hierCtx.tileCtx.expanded + bs.hierarchyCtx.hierCtx.portalCtx.expanded;
+                 },
+                 [](const BenchState &bs)
+                 {
+                   const nav::PortalHierarchyContext &ctx = bs.hierarchyCtx;
+                   return ctx_bytes(ctx.hierCtx.tileCtx) + ctx_bytes(ctx.hierCtx.portalCtx) + vec_bytes(ctx.via) +
+                          portals_bytes(bs.portals) + hierarchy_bytes(bs.hierarchy);
+                 }});
+  res.push_back({"room HPA*", false,
+                 [](BenchState &bs, const nav::GridView &grid) { bs.rooms = nav::build_room_graph(grid); },
+                 [](BenchState &bs, const nav::GridView &grid, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::find_path_rooms(bs.roomCtx, grid, bs.rooms, from, to);
+                 },
+                 [](const BenchState &bs) { return bs.roomCtx.tileCtx.expanded + bs.roomCtx.doorCtx.expanded; },
+                 [](const BenchState &bs)
+                 {
+                   const nav::RoomContext &ctx = bs.roomCtx;
+                   return ctx_bytes(ctx.tileCtx) + ctx_bytes(ctx.goalCtx) + ctx_bytes(ctx.doorCtx) +
+                          vec_bytes(ctx.allowed) + vec_bytes(ctx.anchors) + vec_bytes(ctx.route) + rooms_bytes(bs.rooms);
+                 }});
+  // large agents, costs are compared against the single tile reference so they are not checked for optimality
+  auto clearanceAStar = [](uint8_t agent_size)
+  {
+    return [agent_size](BenchState &bs, const nav::GridView &grid, nav::GridPos from, nav::GridPos to)
+    {
+      return nav::find_path_a_star(bs.ctx, nav::clearance_grid(grid, bs.clearance, agent_size), from, to);
+    };
+  };
+  auto buildClearance = [](BenchState &bs, const nav::GridView &grid) { bs.clearance = nav::build_clearance(grid); };
+  auto clearanceMemory = [](const BenchState &bs) { return ctx_bytes(bs.ctx) + vec_bytes(bs.clearance.clearance); };
+  res.push_back({"A* 2x2", false, buildClearance, clearanceAStar(2), ctxExpanded, clearanceMemory});
+  res.push_back({"A* 3x3", false, buildClearance, clearanceAStar(3), ctxExpanded, clearanceMemory});
+  auto hierarchical = [](uint8_t agent_size)
+  {
+    return [agent_size](BenchState &bs, const nav::GridView &grid, nav::GridPos from, nav::GridPos to)
+    {
+      return nav::find_path_hierarchical(bs.hierCtx, grid, bs.portals, from, to, agent_size);
+    };
+  };
+  auto buildPortals = [](BenchState &bs, const nav::GridView &grid) { bs.portals = nav::build_portals(grid, 10); };
+  auto hierExpanded = [](const BenchState &bs) { return bs.hierCtx.tileCtx.expanded + bs.hierCtx.portalCtx.expanded; };
+  auto hierMemory = [](const BenchState &bs)
+  {
+    return ctx_bytes(bs.hierCtx.tileCtx) + ctx_bytes(bs.hierCtx.portalCtx) + portals_bytes(bs.portals);
+  };
+  res.push_back({"HPA* 2x2", false, buildPortals, hierarchical(2), hierExpanded, hierMemory});
+  res.push_back({"HPA* 3x3", false, buildPortals, hierarchical(3), hierExpanded, hierMemory});
+  res.push_back({"D* Lite", true, noPrepare,
+                 [](BenchState &bs, const nav::GridView &grid, nav::GridPos from, nav::GridPos to)
+                 {
+                   nav::dstar_init(bs.dstar, grid, from, to);
+                   nav::dstar_compute(bs.dstar, grid);
+                   return nav::dstar_path(bs.dstar, grid);
+                 },
+                 [](const BenchState &bs) { return bs.dstar.expanded; },
+                 [](const BenchState &bs) { return dstar_bytes(bs.dstar); }});
+  res.push_back({"bidirectional A*", true, noPrepare,
+                 [](BenchState &bs, const nav::GridView &grid, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::find_path_bidirectional_a_star(bs.bidirCtx, grid, from, to);
+                 },
+                 [](const BenchState &bs) { return bs.bidirCtx.fwd.expanded + bs.bidirCtx.bwd.expanded; },
+                 [](const BenchState &bs) { return ctx_bytes(bs.bidirCtx.fwd) + ctx_bytes(bs.bidirCtx.bwd); }});
+  res.push_back({"bidirectional A* ALT", true, buildLandmarks,
+                 [](BenchState &bs, const nav::GridView &grid, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::find_path_bidirectional_a_star(bs.bidirCtx, grid, bs.landmarks, from, to);
+                 },
+                 [](const BenchState &bs) { return bs.bidirCtx.fwd.expanded + bs.bidirCtx.bwd.expanded; },
+                 [](const BenchState &bs)
+                 {
+                   return ctx_bytes(bs.bidirCtx.fwd) + ctx_bytes(bs.bidirCtx.bwd) + landmarks_bytes(bs.landmarks);
+                 }});
+  res.push_back({"bidirectional Dijkstra", true, noPrepare,
+                 [](BenchState &bs, const nav::GridView &grid, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::find_path_bidirectional_dijkstra(bs.bidirCtx, grid, from, to);
+                 },
+                 [](const BenchState &bs) { return bs.bidirCtx.fwd.expanded + bs.bidirCtx.bwd.expanded; },
+                 [](const BenchState &bs) { return ctx_bytes(bs.bidirCtx.fwd) + ctx_bytes(bs.bidirCtx.bwd); }});
+  res.push_back({"IDA*", true, noPrepare,
+                 [](BenchState &bs, const nav::GridView &grid, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::find_path_ida_star(bs.idaCtx, grid, from, to);
+                 },
+                 [](const BenchState &bs) { return bs.idaCtx.expanded; },
+                 [](const BenchState &bs)
+                 {
+                   return vec_bytes(bs.idaCtx.table) + vec_bytes(bs.idaCtx.onPath) + vec_bytes(bs.idaCtx.stack);
+                 }});
+  res.push_back({"IDA* ALT", true, buildLandmarks,
+                 [](BenchState &bs, const nav::GridView &grid, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::find_path_ida_star(bs.idaCtx, grid, bs.landmarks, from, to);
+                 },
+                 [](const BenchState &bs) { return bs.idaCtx.expanded; },
+                 [](const BenchState &bs)
+                 {
+                   return vec_bytes(bs.idaCtx.table) + vec_bytes(bs.idaCtx.onPath) + vec_bytes(bs.idaCtx.stack) +
+                          landmarks_bytes(bs.landmarks);
+                 }});
+  res.push_back({"CPD", true,
+                 [](BenchState &bs, const nav::GridView &grid) { bs.pathDb = nav::build_path_database(grid); },
+                 [](BenchState &bs, const nav::GridView &, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::cpd_path(bs.pathDb, from, to);
+                 },
+                 [](const BenchState &) { return size_t(0); },
+                 [](const BenchState &bs) { return path_db_bytes(bs.pathDb); }});
+  auto araStar = [](size_t budget_us)
+  {
+    return [budget_us](BenchState &bs, const nav::GridView &grid, nav::GridPos from, nav::GridPos to)
+    {
+      return nav::find_path_ara_star(bs.araCtx, grid, from, to, budget_us);
+    };
+  };
+  auto araExpanded = [](const BenchState &bs) { return bs.araCtx.expanded; };
+  auto araMemory = [](const BenchState &bs)
+  {
+    return ctx_bytes(bs.araCtx.ctx) + vec_bytes(bs.araCtx.closedPass) + vec_bytes(bs.araCtx.inconsPass) +
+           vec_bytes(bs.araCtx.incons);
+  };
+  res.push_back({"ARA* 50us", false, noPrepare, araStar(50), araExpanded, araMemory});
+  res.push_back({"ARA* 500us", false, noPrepare, araStar(500), araExpanded, araMemory});
+  res.push_back({"ARA* ALT 50us", false, buildLandmarks,
+                 [](BenchState &bs, const nav::GridView &grid, nav::GridPos from, nav::GridPos to)
+                 {
+                   return nav::find_path_ara_star(bs.araCtx, grid, bs.landmarks, from, to, 50);
+                 }, araExpanded,
+                 [araMemory](const BenchState &bs) { return araMemory(bs) + landmarks_bytes(bs.landmarks); }});
+  return res;
+}
+
+static std::vector<Corpus> make_corpora()
+{
+  return {
+    {"drunk", [](bench::Rng &rng, char *tiles, size_t w, size_t h)
+      {
+        bench::gen_drunk_dungeon(rng, tiles, w, h, 24, 100);
+      }},
+    {"drunk+water", [](bench::Rng &rng, char *tiles, size_t w, size_t h)
+      {
+        bench::gen_drunk_dungeon(rng, tiles, w, h, 24, 100);
+        bench::spill_drunk_water(rng, tiles, w, h, 8, 10);
+      }},
+    {"drunk cave", [](bench::Rng &rng, char *tiles, size_t w, size_t h)
+      {
+        bench::gen_drunk_dungeon(rng, tiles, w, h, 1, w * h / 2);
+      }},
+    {"inverse", [](bench::Rng &rng, char *tiles, size_t w, size_t h)
+      {
+        bench::gen_inv_dungeon(rng, tiles, w, h, w * h * 3 / 10, 3, 20);
+      }},
+    {"inverse rooms", [](bench::Rng &rng, char *tiles, size_t w, size_t h)
+      {
+        bench::gen_inv_room_dungeon(rng, tiles, w, h, w * h / 50, 3, 20);
+      }},
+    {"cellular", [](bench::Rng &rng, char *tiles, size_t w, size_t h)
+      {
+        bench::gen_cellular_dungeon(rng, tiles, w, h, 0.45f, 10);
+      }},
+  };
+}
+
+// flood fill labels, queries are only drawn inside one component
+static std::vector<uint32_t> label_components(const nav::GridView &grid)
+{
+  std::vector<uint32_t> labels(grid.size(), 0);
+  std::vector<size_t> stack;
+  uint32_t numLabels = 0;
+  for (size_t i = 0; i < grid.size(); ++i)
+  {
+    if (!grid.passable(i) || labels[i])
+      continue;
+    labels[i] = ++numLabels;
+    stack.push_back(i);
+    while (!stack.empty())
+    {
+      const nav::GridPos p = grid.pos(stack.back());
+      stack.pop_back();
+      for (const nav::GridPos &offs : nav::neighbour_offsets)
+      {
+        const nav::GridPos np{p.x + offs.x, p.y + offs.y};
+        if (!grid.in_bounds(np) || !grid.passable(grid.idx(np)) || labels[grid.idx(np)])
+          continue;
+        labels[grid.idx(np)] = numLabels;
+        stack.push_back(grid.idx(np));
+      }
+    }
+  }
+  return labels;
+}
+
+// longer steps are any-angle segments, they are measured as straight lines
+static float path_cost(const nav::GridView &grid, const std::vector<nav::GridPos> &path)
+{
+  float res = 0.f;
+  for (size_t i = 1; i < path.size(); ++i)
+    res += nav::manhattan(path[i - 1], path[i]) == 1.f ? grid.cost(grid.idx(path[i]))
+                                                        : nav::euclidean(path[i - 1], path[i]);
+  return res;
+}
+
+static bool is_valid_path(const nav::GridView &grid, const nav::NavGrid &lines, const std::vector<nav::GridPos> &path,
+                          const Query &q)
+{
+  if (path.empty() || path.front() != q.from || path.back() != q.to)
+    return false;
+  for (size_t i = 0; i < path.size(); ++i)
+  {
+    if (!grid.in_bounds(path[i]) || !grid.passable(grid.idx(path[i])))
+      return false;
+    if (i > 0 && nav::manhattan(path[i - 1], path[i]) != 1.f && !nav::has_clear_line(lines, path[i - 1], path[i]))
+      return false;
+  }
+  return true;
+}
+
+static std::vector<Query> make_queries(bench::Rng &rng, BenchState &bs, const nav::GridView &grid, size_t count)
+{
+  const std::vector<uint32_t> labels = label_components(grid);
+  std::vector<size_t> walkable;
+  for (size_t i = 0; i < grid.size(); ++i)
+    if (grid.passable(i))
+      walkable.push_back(i);
+  std::vector<Query> res;
+  if (walkable.size() < 2)
+    return res;
+  std::uniform_int_distribution<size_t> pick(0, walkable.size() - 1);
+  for (size_t attempt = 0; res.size() < count && attempt < count * 100; ++attempt)
+  {
+    const size_t from = walkable[pick(rng)];
+    const size_t to = walkable[pick(rng)];
+    if (from == to || labels[from] != labels[to])
+      continue;
+    const std::vector<nav::GridPos> path = nav::find_path_a_star(bs.ctx, grid, grid.pos(from), grid.pos(to), 0.f);
+    res.push_back(Query{grid.pos(from), grid.pos(to), path_cost(grid, path)});
+  }
+  return res;
+}
+
+static double percentile(const std::vector<double> &sorted, double q)
+{
+  if (sorted.empty())
+    return 0.0;
+  return sorted[std::min(sorted.size() - 1, size_t(q * double(sorted.size())))];
+}
+
+static bool print_corpus(const Corpus &corpus, const Settings &settings, const std::vector<Variant> &variants,
+                         std::vector<VariantStats> &stats)
+{
+  printf("\n%s: %zu maps %zux%zu, %zu queries\n", corpus.name, settings.maps, settings.size, settings.size,
+         stats.empty() ? size_t(0) : stats[0].timesUs.size());
+  printf("%-24s %7s %5s %5s %8s %12s %9s %9s %9s %9s %9s %9s %9s\n", "variant", "solved", "fail", "bad",
+         "cost", "expanded", "mean us", "p50 us", "p90 us", "p99 us", "max us", "prep ms", "mem KB");
+  bool ok = true;
+  for (size_t v = 0; v < variants.size(); ++v)
+  {
+    VariantStats &st = stats[v];
+    std::sort(st.timesUs.begin(), st.timesUs.end());
+    double total = 0.0;
+    for (double t : st.timesUs)
+      total += t;
+    const size_t n = std::max(st.timesUs.size(), size_t(1));
+    printf("%-24s %7zu %5zu %5zu %8.3f %12.1f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %9.1f\n", variants[v].name,
+           st.solved, st.failed, st.invalid, st.solved ? st.costRatio / double(st.solved) : 0.0,
+           double(st.expanded) / double(n), total / double(n), percentile(st.timesUs, 0.5),
+           percentile(st.timesUs, 0.9), percentile(st.timesUs, 0.99), st.timesUs.empty() ? 0.0 : st.timesUs.back(),
+           st.prepMs / double(std::max(settings.maps, size_t(1))), double(st.memory) / 1024.0);
+    ok &= st.invalid == 0;
+  }
+  return ok;
+}
+
+static bool run_corpus(const Corpus &corpus, const Settings &settings, const std::vector<Variant> &variants)
+{
+  using clock = std::chrono::steady_clock;
+  std::vector<VariantStats> stats(variants.size());
+  std::vector<char> tiles(settings.size * settings.size);
+  BenchState bs;
+  bs.idaCtx.budget = settings.idaBudget;
+  for (size_t m = 0; m < settings.maps; ++m)
+  {
+    // every map has its own seed, so a single map can be reproduced without the rest of the set
+    bench::Rng rng(unsigned(settings.seed * 7919u + m));
+    corpus.gen(rng, tiles.data(), settings.size, settings.size);
+    const nav::GridView grid{tiles.data(), settings.size, settings.size};
+    const std::vector<Query> queries = make_queries(rng, bs, grid, settings.queries);
+    const nav::NavGrid lines = nav::build_nav_grid(grid);
+    for (size_t v = 0; v < variants.size(); ++v)
+    {
+      const Variant &variant = variants[v];
+      VariantStats &st = stats[v];
+      const auto prepStart = clock::now();
+      variant.prepare(bs, grid);
+      st.prepMs += std::chrono::duration<double, std::milli>(clock::now() - prepStart).count();
+      for (const Query &q : queries)
+      {
+        const auto start = clock::now();
+        const std::vector<nav::GridPos> path = variant.find(bs, grid, q.from, q.to);
+        st.timesUs.push_back(std::chrono::duration<double, std::micro>(clock::now() - start).count());
+        st.expanded += variant.expanded(bs);
+        if (path.empty())
+        {
+          st.failed++;
+          continue;
+        }
+        const float cost = path_cost(grid, path);
+        // optimal variants must match the reference cost exactly
+        if (!is_valid_path(grid, lines, path, q) || (variant.optimal && std::abs(cost - q.cost) > 1e-3f))
+        {
+          st.invalid++;
+          continue;
+        }
+        st.solved++;
+        st.costRatio += double(cost) / double(std::max(q.cost, 1.f));
+      }
+      st.memory = std::max(st.memory, variant.memory(bs));
+    }
+  }
+  return print_corpus(corpus, settings, variants, stats);
+}
+
+// Agents walk to random goals inside one component, every turn is one joint
+// WHCA* plan and all agents take its first step at once, as the roguelike
+// turns do. Any two agents on one tile or swapping tiles is a failure.
+static bool run_crowd(const Corpus &corpus, const Settings &settings)
+{
+  using clock = std::chrono::steady_clock;
+  std::vector<char> tiles(settings.size * settings.size);
+  nav::CooperativeContext cctx;
+  std::vector<double> timesMs;
+  size_t expanded = 0;
+  size_t goalExpanded = 0;
+  size_t partial = 0;
+  size_t arrived = 0;
+  size_t collisions = 0;
+  size_t numAgents = 0;
+  for (size_t m = 0; m < settings.maps; ++m)
+  {
+    bench::Rng rng(unsigned(settings.seed * 7919u + m));
+    corpus.gen(rng, tiles.data(), settings.size, settings.size);
+    const nav::GridView grid{tiles.data(), settings.size, settings.size};
+    const nav::NavGrid ng = nav::build_nav_grid(grid);
+    const std::vector<uint32_t> labels = label_components(grid);
+    std::vector<size_t> labelSize(grid.size() + 1, 0);
+    for (uint32_t l : labels)
+      labelSize[l]++;
+    const uint32_t mainLabel = uint32_t(std::max_element(labelSize.begin() + 1, labelSize.end()) - labelSize.begin());
+    std::vector<size_t> walkable;
+    for (size_t i = 0; i < grid.size(); ++i)
+      if (labels[i] == mainLabel)
+        walkable.push_back(i);
+    std::shuffle(walkable.begin(), walkable.end(), rng);
+    std::vector<nav::CooperativeAgent> agents(std::min(settings.agents, walkable.size() / 2));
+    std::uniform_int_distribution<size_t> pick(0, walkable.size() - 1);
+    for (size_t a = 0; a < agents.size(); ++a)
+      agents[a] = nav::CooperativeAgent{grid.pos(walkable[a]), grid.pos(walkable[pick(rng)])};
+    numAgents = std::max(numAgents, agents.size());
+
+    std::vector<uint32_t> occupant(grid.size(), nav::no_agent);
+    for (size_t turn = 0; turn < settings.turns; ++turn)
+    {
+      const auto start = clock::now();
+      nav::plan_cooperative(cctx, ng, agents, {}, nav::CooperativeSettings{8, 512, agents.size()});
+      timesMs.push_back(std::chrono::duration<double, std::milli>(clock::now() - start).count());
+      expanded += cctx.expanded;
+      goalExpanded += cctx.goalExpanded;
+      partial += cctx.partial;
+
+      for (size_t a = 0; a < agents.size(); ++a)
+        occupant[grid.idx(agents[a].from)] = uint32_t(a);
+      for (size_t a = 0; a < agents.size(); ++a)
+      {
+        const nav::GridPos next = nav::planned_step(cctx, a);
+        const uint32_t other = occupant[grid.idx(next)];
+        if (other != nav::no_agent && other != a && nav::planned_step(cctx, other) == agents[a].from)
+          collisions++;
+      }
+      for (size_t a = 0; a < agents.size(); ++a)
+        occupant[grid.idx(agents[a].from)] = nav::no_agent;
+      for (size_t a = 0; a < agents.size(); ++a)
+      {
+        agents[a].from = nav::planned_step(cctx, a);
+        if (!grid.passable(grid.idx(agents[a].from)) || occupant[grid.idx(agents[a].from)] != nav::no_agent)
+          collisions++;
+        occupant[grid.idx(agents[a].from)] = uint32_t(a);
+        if (agents[a].from == agents[a].to)
+        {
+          arrived++;
+          agents[a].to = grid.pos(walkable[pick(rng)]);
+        }
+      }
+      for (size_t a = 0; a < agents.size(); ++a)
+        occupant[grid.idx(agents[a].from)] = nav::no_agent;
+    }
+  }
+  std::sort(timesMs.begin(), timesMs.end());
+  double total = 0.0;
+  for (double t : timesMs)
+    total += t;
+  const double n = double(std::max(timesMs.size(), size_t(1)));
+  printf("%-24s %zu agents, %zu turns: %.3f ms mean, %.3f ms p99, %.3f ms max per turn, %.0f expanded, "
+         "%.0f goal expanded, %.1f partial per turn, %zu arrived, %zu collisions\n",
+         "WHCA* crowd", numAgents, timesMs.size(), total / n, percentile(timesMs, 0.99),
+         timesMs.empty() ? 0.0 : timesMs.back(), double(expanded) / n, double(goalExpanded) / n,
+         double(partial) / n, arrived, collisions);
+  return collisions == 0;
+}
+
+using PortalExtent = std::array<uint32_t, 4>;
+// kind 0 is the portal itself, 1 its place in a cluster, 2 a link to the second portal
+using PortalFact = std::tuple<PortalExtent, int, PortalExtent, float, uint32_t, uint8_t>;
+
+// Portal indices depend on the order of repairs, so graphs are compared as
+// sorted facts that name every portal by its extent.
+static std::vector<PortalFact> portal_facts(const nav::DungeonPortals &dp)
+{
+  auto extent = [&](uint32_t idx) { return PortalExtent{dp.startX[idx], dp.startY[idx], dp.endX[idx], dp.endY[idx]}; };
+  std::vector<PortalFact> res;
+  for (uint32_t i = 0; i < nav::num_portals(dp); ++i)
+  {
+    res.emplace_back(extent(i), 0, extent(i), 0.f, 0, dp.portalClearance[i]);
+    for (const nav::PortalConnection &conn : nav::portal_conns(dp, i))
+      res.emplace_back(extent(i), 2, extent(conn.connIdx), conn.score, conn.cluster, conn.clearance);
+  }
+  for (uint32_t cluster = 0; cluster + 1 < dp.clusterStart.size(); ++cluster)
+    for (uint32_t idx : nav::cluster_portals(dp, cluster))
+      res.emplace_back(extent(idx), 1, extent(idx), 0.f, cluster, 0);
+  std::sort(res.begin(), res.end());
+  return res;
+}
+
+static bool same_portals(const nav::DungeonPortals &lhs, const nav::DungeonPortals &rhs)
+{
+  return lhs.tileSplit == rhs.tileSplit && lhs.numClustersX == rhs.numClustersX &&
+         lhs.numClustersY == rhs.numClustersY && lhs.clearance.width == rhs.clearance.width &&
+         lhs.clearance.height == rhs.clearance.height && lhs.clearance.clearance == rhs.clearance.clearance &&
+         portal_facts(lhs) == portal_facts(rhs);
+}
+
+static std::vector<char> read_file(const char *path)
+{
+  std::vector<char> res;
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return res;
+  char buf[4096];
+  for (size_t n = fread(buf, 1, sizeof(buf), f); n > 0; n = fread(buf, 1, sizeof(buf), f))
+    res.insert(res.end(), buf, buf + n);
+  fclose(f);
+  return res;
+}
+
+// a few tiles in one small patch get a random terrain, like an edit in the demo
+static void random_edits(bench::Rng &rng, char *tiles, const nav::GridView &grid, std::vector<nav::GridPos> &changed)
+{
+  constexpr char terrain[] = {' ', nav::wall_tile, nav::water_tile};
+  std::uniform_int_distribution<int> pickX(0, int(grid.width) - 1);
+  std::uniform_int_distribution<int> pickY(0, int(grid.height) - 1);
+  std::uniform_int_distribution<int> offs(-2, 2);
+  std::uniform_int_distribution<size_t> count(1, 8);
+  std::uniform_int_distribution<size_t> kind(0, 2);
+  changed.clear();
+  const nav::GridPos center{pickX(rng), pickY(rng)};
+  for (size_t n = count(rng); n > 0; --n)
+  {
+    const nav::GridPos p{center.x + offs(rng), center.y + offs(rng)};
+    if (!grid.in_bounds(p))
+      continue;
+    tiles[grid.idx(p)] = terrain[kind(rng)];
+    changed.push_back(p);
+  }
+}
+
+// Same costs as the fresh field. Directions may differ on ties, but every one
+// has to lead to a neighbour exactly that neighbour's entry cost closer.
+static bool same_flow_field(const nav::FlowField &ff, const nav::FlowField &fresh, const nav::GridView &grid)
+{
+  if (ff.cost != fresh.cost)
+    return false;
+  for (size_t idx = 0; idx < grid.size(); ++idx)
+  {
+    if ((ff.dir[idx] == nav::flow_none) != (fresh.dir[idx] == nav::flow_none))
+      return false;
+    if (ff.dir[idx] == nav::flow_none)
+      continue;
+    const nav::GridPos p = grid.pos(idx);
+    const nav::GridPos np{p.x + nav::neighbour_offsets[ff.dir[idx]].x, p.y + nav::neighbour_offsets[ff.dir[idx]].y};
+    if (!grid.in_bounds(np) || !grid.passable(grid.idx(np)) ||
+        ff.cost[idx] != ff.cost[grid.idx(np)] + grid.cost(grid.idx(np)))
+      return false;
+  }
+  return true;
+}
+
+// the same partition of the tiles with the same sizes, the roots may differ
+static bool same_components(const nav::ComponentMap &cm, const nav::ComponentMap &fresh, const nav::GridView &grid)
+{
+  constexpr uint32_t none = nav::ComponentMap::no_component;
+  std::vector<uint32_t> toFresh(grid.size(), none);
+  std::vector<uint32_t> fromFresh(grid.size(), none);
+  for (size_t idx = 0; idx < grid.size(); ++idx)
+  {
+    const uint32_t comp = nav::component_of(cm, grid.pos(idx));
+    const uint32_t freshComp = nav::component_of(fresh, grid.pos(idx));
+    if ((comp == none) != (freshComp == none))
+      return false;
+    if (comp == none)
+      continue;
+    if (toFresh[comp] == none && fromFresh[freshComp] == none)
+    {
+      if (cm.size[comp] != fresh.size[freshComp])
+        return false;
+      toFresh[comp] = freshComp;
+      fromFresh[freshComp] = comp;
+    }
+    else if (toFresh[comp] != freshComp || fromFresh[freshComp] != comp)
+      return false;
+  }
+  return true;
+}
+
+// Preprocessed data kept across runs or map edits has to equal a fresh build of the same map.
+static bool run_consistency(const Corpus &corpus, const Settings &settings)
+{
+  constexpr const char *portalsFile = "nav_benchmark_portals.bin";
+  constexpr size_t splitTiles = 10;
+  constexpr size_t editBatches = 20;
+  constexpr size_t goalMoves = 20;
+  std::vector<char> tiles(settings.size * settings.size);
+  nav::SearchContext ctx;
+  std::vector<nav::GridPos> changed;
+  size_t fileMismatches = 0;
+  size_t repairMismatches = 0;
+  size_t flowMismatches = 0;
+  size_t componentMismatches = 0;
+  nav::FlowField flow;
+  nav::FlowField freshFlow;
+  std::vector<size_t> passable;
+  for (size_t m = 0; m < settings.maps; ++m)
+  {
+    bench::Rng rng(unsigned(settings.seed * 7919u + m));
+    corpus.gen(rng, tiles.data(), settings.size, settings.size);
+    const nav::GridView grid{tiles.data(), settings.size, settings.size};
+
+    // the loaded graph saved again has to give the same bytes, so nothing but the graph is written
+    const nav::DungeonPortals fresh = nav::build_portals(grid, splitTiles);
+    nav::DungeonPortals loaded;
+    bool fileOk = nav::save_portals(fresh, grid, portalsFile);
+    const std::vector<char> saved = read_file(portalsFile);
+    fileOk = fileOk && nav::load_portals(loaded, grid, splitTiles, portalsFile) && same_portals(fresh, loaded);
+    fileOk = fileOk && nav::save_portals(loaded, grid, portalsFile) && read_file(portalsFile) == saved;
+    if (!fileOk)
+      fileMismatches++;
+
+    // the repaired graph is compared after every batch of edits
+    nav::DungeonPortals repaired = fresh;
+    nav::ComponentMap components = nav::build_components(grid);
+    for (size_t b = 0; b < editBatches; ++b)
+    {
+      random_edits(rng, tiles.data(), grid, changed);
+      nav::update_portals(ctx, repaired, grid, changed);
+      if (!same_portals(repaired, nav::build_portals(grid, splitTiles)))
+        repairMismatches++;
+      nav::update_components(components, grid, changed);
+      if (!same_components(components, nav::build_components(grid), grid))
+        componentMismatches++;
+    }
+
+    // the goal mostly steps to a neighbour tile, sometimes it jumps anywhere, another region included
+    passable.clear();
+    for (size_t i = 0; i < grid.size(); ++i)
+      if (grid.passable(i))
+        passable.push_back(i);
+    if (passable.empty())
+      continue;
+    std::uniform_int_distribution<size_t> pick(0, passable.size() - 1);
+    std::uniform_int_distribution<size_t> move(0, 4);
+    nav::GridPos goal = grid.pos(passable[pick(rng)]);
+    nav::build_flow_field(flow, grid, goal);
+    for (size_t i = 0; i < goalMoves; ++i)
+    {
+      const size_t dir = move(rng);
+      const nav::GridPos np = dir < 4 ? nav::GridPos{goal.x + nav::neighbour_offsets[dir].x,
+                                                     goal.y + nav::neighbour_offsets[dir].y}
+                                      : grid.pos(passable[pick(rng)]);
+      if (grid.in_bounds(np) && grid.passable(grid.idx(np)))
+        goal = np;
+      nav::update_flow_field(flow, grid, goal);
+      nav::build_flow_field(freshFlow, grid, goal);
+      if (!same_flow_field(flow, freshFlow, grid))
+        flowMismatches++;
+    }
+  }
+  remove(portalsFile);
+  printf("%-24s %zu maps saved and loaded, %zu mismatches\n", "portal file", settings.maps, fileMismatches);
+  printf("%-24s %zu edit batches, %zu mismatches\n", "portal repair", settings.maps * editBatches,
+         repairMismatches);
+  printf("%-24s %zu edit batches, %zu mismatches\n", "component update", settings.maps * editBatches,
+         componentMismatches);
+  printf("%-24s %zu goal moves, %zu mismatches\n", "flow field update", settings.maps * goalMoves, flowMismatches);
+  return fileMismatches == 0 && repairMismatches == 0 && componentMismatches == 0 && flowMismatches == 0;
+}
+
+int main(int argc, const char **argv)
+{
+  Settings settings;
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    const unsigned long value = strtoul(argv[i + 1], nullptr, 10);
+    if (!strcmp(argv[i], "--maps"))
+      settings.maps = value;
+    else if (!strcmp(argv[i], "--queries"))
+      settings.queries = value;
+    else if (!strcmp(argv[i], "--size"))
+      settings.size = std::max(value, 16ul);
+    else if (!strcmp(argv[i], "--seed"))
+      settings.seed = unsigned(value);
+    else if (!strcmp(argv[i], "--ida-budget"))
+      settings.idaBudget = value;
+    else if (!strcmp(argv[i], "--agents"))
+      settings.agents = value;
+    else if (!strcmp(argv[i], "--turns"))
+      settings.turns = value;
+    else
+    {
+      printf("unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+  const std::vector<Variant> variants = make_variants();
+  bool ok = true;
+  for (const Corpus &corpus : make_corpora())
+  {
+    ok &= run_corpus(corpus, settings, variants);
+    ok &= run_crowd(corpus, settings);
+    ok &= run_consistency(corpus, settings);
+  }
+  // non zero exit on wrong paths, so the benchmark doubles as a regression check
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,270 @@
+#include "mapGen.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring> // memset
+#include <limits>
+#include <vector>
+#include "gridTypes.h"
+
+constexpr char wall = nav::wall_tile;
+constexpr char floor_tile = ' ';
+constexpr char water = nav::water_tile;
+
+// inclusive, like raylib's GetRandomValue
+static size_t random_value(bench::Rng &rng, size_t min, size_t max)
+{
+  return std::uniform_int_distribution<size_t>(min, max)(rng);
+}
+
+static nav::GridPos find_walkable_tile(bench::Rng &rng, const char *tiles, size_t w, size_t h)
+{
+  std::vector<nav::GridPos> posList;
+  for (size_t y = 0; y < h; ++y)
+    for (size_t x = 0; x < w; ++x)
+      if (tiles[y * w + x] == floor_tile)
+        posList.push_back(nav::GridPos{int(x), int(y)});
+  if (posList.empty())
+    return nav::GridPos{0, 0};
+  return posList[random_value(rng, 0, posList.size() - 1)];
+}
+
+void bench::gen_drunk_dungeon(Rng &rng, char *tiles, size_t w, size_t h, size_t num_iter, size_t max_excavations)
+{
+  memset(tiles, wall, w * h);
+
+  std::vector<nav::GridPos> startPos;
+  for (size_t iter = 0; iter < num_iter; ++iter)
+  {
+    // select random point on map
+    size_t x = random_value(rng, 1, w - 2);
+    size_t y = random_value(rng, 1, h - 2);
+    startPos.push_back({int(x), int(y)});
+    size_t numExcavations = 0;
+    while (numExcavations < max_excavations)
+    {
+      if (tiles[y * w + x] == wall)
+      {
+        numExcavations++;
+        tiles[y * w + x] = floor_tile;
+      }
+      const nav::GridPos &dir = nav::neighbour_offsets[random_value(rng, 0, 3)];
+      x = size_t(std::clamp(int(x) + dir.x, 1, int(w) - 2));
+      y = size_t(std::clamp(int(y) + dir.y, 1, int(h) - 2));
+    }
+  }
+
+  // construct a path from start pos to the closest of the next start poses
+  for (size_t i = 0; i + 1 < startPos.size(); ++i)
+  {
+    const nav::GridPos &spos = startPos[i];
+    float closestDist = std::numeric_limits<float>::max();
+    nav::GridPos closestPos = spos;
+    for (size_t j = i + 1; j < startPos.size(); ++j)
+    {
+      const float dist = nav::euclidean(spos, startPos[j]);
+      if (dist < closestDist)
+      {
+        closestDist = dist;
+        closestPos = startPos[j];
+      }
+    }
+    nav::GridPos pos = spos;
+    while (pos != closestPos)
+    {
+      const nav::GridPos delta{closestPos.x - pos.x, closestPos.y - pos.y};
+      if (abs(delta.x) > abs(delta.y))
+        pos.x += delta.x > 0 ? 1 : -1;
+      else
+        pos.y += delta.y > 0 ? 1 : -1;
+      tiles[size_t(pos.y) * w + size_t(pos.x)] = floor_tile;
+    }
+  }
+}
+
+void bench::spill_drunk_water(Rng &rng, char *tiles, size_t w, size_t h, size_t num_iter, size_t max_spills)
+{
+  for (size_t iter = 0; iter < num_iter; ++iter)
+  {
+    const nav::GridPos p = find_walkable_tile(rng, tiles, w, h);
+    size_t x = size_t(p.x);
+    size_t y = size_t(p.y);
+    size_t numSpills = 0;
+    // bounded so a walled in start can't hang the generator
+    for (size_t steps = 0; numSpills < max_spills && steps < max_spills * 100; ++steps)
+    {
+      if (tiles[y * w + x] == floor_tile)
+      {
+        numSpills++;
+        tiles[y * w + x] = water;
+      }
+      const nav::GridPos &dir = nav::neighbour_offsets[random_value(rng, 0, 3)];
+      const size_t newX = size_t(std::clamp(int(x) + dir.x, 1, int(w) - 2));
+      const size_t newY = size_t(std::clamp(int(y) + dir.y, 1, int(h) - 2));
+      if (tiles[newY * w + newX] != wall)
+      {
+        x = newX;
+        y = newY;
+      }
+    }
+  }
+}
+
+static const int diag_dirs[8][2] = {{1, 0}, {0, 1}, {-1, 0}, {0, -1},
+                                    {1, 1}, {-1, 1}, {1, -1}, {-1, -1}};
+
+static void carve_initial_room(bench::Rng &rng, char *tiles, size_t w, size_t h, size_t init_sz)
+{
+  memset(tiles, wall, w * h);
+  const size_t sx = random_value(rng, init_sz + 1, w - init_sz - 1);
+  const size_t sy = random_value(rng, init_sz + 1, h - init_sz - 1);
+  for (size_t y = sy - init_sz; y < sy + init_sz; ++y)
+    for (size_t x = sx - init_sz; x < sx + init_sz; ++x)
+      tiles[y * w + x] = floor_tile;
+}
+
+// walks from a random tile in a random direction until something dug out is
+// adjacent to one of the pattern cells
+template<typename Touches>
+static void walk_to_excavation(bench::Rng &rng, size_t w, size_t h, size_t max_steps, size_t &x, size_t &y,
+                               Touches touches)
+{
+  while (true)
+  {
+    x = random_value(rng, 1, w - 2);
+    y = random_value(rng, 1, h - 2);
+    const size_t dir = random_value(rng, 0, 7);
+    for (size_t s = 0; s < max_steps; ++s)
+    {
+      x = size_t(std::clamp(int(x) + diag_dirs[dir][0], 1, int(w) - 2));
+      y = size_t(std::clamp(int(y) + diag_dirs[dir][1], 1, int(h) - 2));
+      if (touches(x, y))
+        return;
+    }
+  }
+}
+
+void bench::gen_inv_dungeon(Rng &rng, char *tiles, size_t w, size_t h, size_t max_excavations, size_t init_sz,
+                            size_t max_steps)
+{
+  carve_initial_room(rng, tiles, w, h, init_sz);
+  for (size_t i = 0; i < max_excavations; ++i)
+  {
+    size_t x = 0;
+    size_t y = 0;
+    walk_to_excavation(rng, w, h, max_steps, x, y, [&](size_t cx, size_t cy)
+    {
+      for (size_t yy = cy - 1; yy <= cy + 1; ++yy)
+        for (size_t xx = cx - 1; xx <= cx + 1; ++xx)
+          if (tiles[yy * w + xx] != wall)
+            return true;
+      return false;
+    });
+    tiles[y * w + x] = floor_tile;
+  }
+}
+
+void bench::gen_inv_room_dungeon(Rng &rng, char *tiles, size_t w, size_t h, size_t max_excavations, size_t init_sz,
+                                 size_t max_steps)
+{
+  static const char rooms[5][26] = {
+    "#####"
+    "#   #"
+    "#   #"
+    "#   #"
+    "#####",
+    "     "
+    " ### "
+    " # # "
+    " ### "
+    "     ",
+    "#####"
+    " ### "
+    " # # "
+    " # # "
+    "     ",
+    "#   #"
+    "## ##"
+    "## ##"
+    "## ##"
+    "#   #",
+    "#####"
+    "#####"
+    "     "
+    "#####"
+    "#####"
+  };
+  carve_initial_room(rng, tiles, w, h, init_sz);
+  auto inside = [w, h](size_t x, size_t y, int xx, int yy)
+  {
+    const int px = int(x) + xx;
+    const int py = int(y) + yy;
+    return px >= 0 && py >= 0 && px < int(w) && py < int(h);
+  };
+  for (size_t i = 0; i < max_excavations; ++i)
+  {
+    const char *room = rooms[random_value(rng, 0, 4)];
+    size_t x = 0;
+    size_t y = 0;
+    walk_to_excavation(rng, w, h, max_steps, x, y, [&](size_t cx, size_t cy)
+    {
+      for (int yy = -2; yy <= 2; ++yy)
+        for (int xx = -2; xx <= 2; ++xx)
+          if (room[(yy + 2) * 5 + xx + 2] != wall && inside(cx, cy, xx, yy) &&
+              tiles[size_t(int(cy) + yy) * w + size_t(int(cx) + xx)] != wall)
+            return true;
+      return false;
+    });
+    for (int yy = -2; yy <= 2; ++yy)
+      for (int xx = -2; xx <= 2; ++xx)
+      {
+        if (!inside(x, y, xx, yy))
+          continue;
+        char &tile = tiles[size_t(int(y) + yy) * w + size_t(int(x) + xx)];
+        if (tile == wall)
+          tile = room[(yy + 2) * 5 + xx + 2];
+      }
+  }
+}
+
+static void run_cellular(char *tiles, size_t w, size_t h, size_t num_iter)
+{
+  std::vector<char> scratch(tiles, tiles + w * h);
+  auto is_wall = [&](int x, int y)
+  {
+    return x < 0 || y < 0 || x >= int(w) || y >= int(h) || tiles[size_t(y) * w + size_t(x)] == wall;
+  };
+  for (size_t iter = 0; iter < num_iter; ++iter)
+  {
+    bool hasChanges = false;
+    for (int y = 0; y < int(h); ++y)
+      for (int x = 0; x < int(w); ++x)
+      {
+        size_t numWalls1 = 0;
+        size_t numWalls2 = 0;
+        for (int yy = y - 2; yy <= y + 2; ++yy)
+          for (int xx = x - 2; xx <= x + 2; ++xx)
+          {
+            const bool isWall = is_wall(xx, yy);
+            numWalls2 += isWall;
+            numWalls1 += isWall && abs(xx - x) <= 1 && abs(yy - y) <= 1;
+          }
+        const bool shouldBeWall = numWalls1 >= 5 || numWalls2 < 1;
+        const size_t idx = size_t(y) * w + size_t(x);
+        const bool shouldFlip = shouldBeWall != (tiles[idx] == wall);
+        if (shouldFlip)
+          scratch[idx] = shouldBeWall ? wall : floor_tile;
+        hasChanges |= shouldFlip;
+      }
+    memcpy(tiles, scratch.data(), w * h);
+    if (!hasChanges)
+      break;
+  }
+}
+
+void bench::gen_cellular_dungeon(Rng &rng, char *tiles, size_t w, size_t h, float fillrate, size_t num_iter)
+{
+  std::uniform_real_distribution<float> dis(0.f, 1.f);
+  for (size_t i = 0; i < w * h; ++i)
+    tiles[i] = dis(rng) < fillrate ? wall : floor_tile;
+  run_cellular(tiles, w, h, num_iter);
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef> // size_t
+#include <random>
+
+// Seeded copies of the pathfinding and w8 generators. The originals draw from
+// raylib's or a clock seeded generator, so map sets can't be reproduced with them.
+namespace bench
+{
+  using Rng = std::mt19937;
+
+  void gen_drunk_dungeon(Rng &rng, char *tiles, size_t w, size_t h, size_t num_iter, size_t max_excavations);
+  void spill_drunk_water(Rng &rng, char *tiles, size_t w, size_t h, size_t num_iter, size_t max_spills);
+
+  void gen_inv_dungeon(Rng &rng, char *tiles, size_t w, size_t h, size_t max_excavations, size_t init_sz,
+                       size_t max_steps);
+  void gen_inv_room_dungeon(Rng &rng, char *tiles, size_t w, size_t h, size_t max_excavations, size_t init_sz,
+                            size_t max_steps);
+  void gen_cellular_dungeon(Rng &rng, char *tiles, size_t w, size_t h, float fillrate, size_t num_iter);
+};
@@ -0,0 +1,42 @@
+#include "aStar.h"
+#include "landmarks.h"
+#include "navGrid.h"
+#include "clearance.h"
+
+std::vector<nav::GridPos> nav::find_path_a_star(SearchContext &ctx, const GridView &grid, GridPos from, GridPos to,
+                                                float weight)
+{
+  return find_path_a_star(ctx, grid, from, to, full_limits(grid), weight);
+}
+
+std::vector<nav::GridPos> nav::find_path_a_star(SearchContext &ctx, const GridView &grid, GridPos from, GridPos to,
+                                                const SearchLimits &lim, float weight)
+{
+  return find_path_a_star(ctx, grid, from, to, euclidean_to(grid, to, weight), lim);
+}
+
+std::vector<nav::GridPos> nav::find_path_a_star(SearchContext &ctx, const GridView &grid, GridPos from, GridPos to,
+                                                const LandmarkTable &landmarks, float weight)
+{
+  if (!can_use_landmarks(landmarks, grid, from, to))
+    return find_path_a_star(ctx, grid, from, to, weight);
+  return find_path_a_star(ctx, grid, from, to, alt_to(landmarks, grid, to, weight), full_limits(grid));
+}
+
+std::vector<nav::GridPos> nav::find_path_a_star(SearchContext &ctx, const NavGrid &grid, GridPos from, GridPos to,
+                                                float weight)
+{
+  return find_path_a_star(ctx, grid, from, to, euclidean_to(grid, to, weight), full_limits(grid));
+}
+
+std::vector<nav::GridPos> nav::find_path_a_star(SearchContext &ctx, const ClearanceGrid &grid, GridPos from, GridPos to,
+                                                float weight)
+{
+  // the plain search would still expand a start the agent does not fit on
+  if (!grid.in_bounds(from) || !grid.in_bounds(to) || !grid.passable(grid.idx(from)) || !grid.passable(grid.idx(to)))
+  {
+    begin_search(ctx, grid);
+    return std::vector<GridPos>();
+  }
+  return find_path_a_star(ctx, grid, from, to, euclidean_to(grid, to, weight), full_limits(grid));
+}
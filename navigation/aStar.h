@@ -0,0 +1,108 @@
+#pragma once
+#include <vector>
+#include "gridTypes.h"
+#include "searchContext.h"
+
+namespace nav
+{
+  struct LandmarkTable;
+  struct NavGrid;
+  struct ClearanceGrid;
+
+  template<typename Grid>
+  inline auto euclidean_to(const Grid &grid, GridPos to, float weight = 1.f)
+  {
+    const size_t width = grid.width;
+    return [width, to, weight](size_t idx)
+    {
+      return weight * euclidean(GridPos{int(idx % width), int(idx / width)}, to);
+    };
+  }
+
+  // Seeds a new query in ctx, more starts can be added before run_a_star.
+  template<typename Grid>
+  inline void begin_search(SearchContext &ctx, const Grid &grid)
+  {
+    ctx.reset(grid.width * grid.height);
+  }
+
+  inline void add_start(SearchContext &ctx, size_t idx, float g, float h)
+  {
+    if (ctx.relax(idx, SearchContext::no_prev, g))
+      ctx.push(idx, g, g + h);
+  }
+
+  // grids with a padded passable_at(x, y) skip the index division
+  template<typename Grid>
+  inline bool passable_tile(const Grid &grid, GridPos p, size_t idx)
+  {
+    if constexpr (requires { grid.passable_at(p.x, p.y); })
+      return grid.passable_at(p.x, p.y);
+    else
+      return grid.passable(idx);
+  }
+
+  // Grid has to provide width, height, passable(idx) and cost(idx) (cost of entering the tile).
+  // Returns the index of the first expanded goal tile or invalid_idx.
+  template<typename Grid, typename IsGoal, typename Heuristic>
+  size_t run_a_star(SearchContext &ctx, const Grid &grid, IsGoal is_goal, Heuristic heuristic,
+                    const SearchLimits &lim)
+  {
+    const size_t width = grid.width;
+    while (!ctx.open.empty())
+    {
+      const OpenNode cur = ctx.pop();
+      // lazy deletion: stale heap entries are skipped here instead of decrease-key
+      if (ctx.is_closed(cur.idx) || cur.g > ctx.g[cur.idx])
+        continue;
+      ctx.close(cur.idx);
+      if (is_goal(size_t(cur.idx)))
+        return cur.idx;
+      const GridPos p{int(cur.idx % width), int(cur.idx / width)};
+      for (const GridPos &offs : neighbour_offsets)
+      {
+        const GridPos np{p.x + offs.x, p.y + offs.y};
+        if (!in_limits(lim, np))
+          continue;
+        const size_t nidx = size_t(np.y) * width + size_t(np.x);
+        if (!passable_tile(grid, np, nidx) || ctx.is_closed(nidx))
+          continue;
+        const float gScore = cur.g + grid.cost(nidx);
+        if (ctx.relax(nidx, cur.idx, gScore))
+          ctx.push(nidx, gScore, gScore + heuristic(nidx));
+      }
+    }
+    return invalid_idx;
+  }
+
+  template<typename Grid, typename Heuristic>
+  std::vector<GridPos> find_path_a_star(SearchContext &ctx, const Grid &grid, GridPos from, GridPos to,
+                                        Heuristic heuristic, const SearchLimits &lim)
+  {
+    begin_search(ctx, grid);
+    if (!in_limits(lim, from) || !in_limits(lim, to))
+      return std::vector<GridPos>();
+    const size_t width = grid.width;
+    const size_t fromIdx = size_t(from.y) * width + size_t(from.x);
+    const size_t toIdx = size_t(to.y) * width + size_t(to.x);
+    add_start(ctx, fromIdx, 0.f, heuristic(fromIdx));
+    const size_t goal = run_a_star(ctx, grid, [toIdx](size_t idx) { return idx == toIdx; }, heuristic, lim);
+    if (goal == invalid_idx)
+      return std::vector<GridPos>();
+    return ctx.reconstruct_path(grid, goal);
+  }
+
+  std::vector<GridPos> find_path_a_star(SearchContext &ctx, const GridView &grid, GridPos from, GridPos to,
+                                        float weight = 1.f);
+  std::vector<GridPos> find_path_a_star(SearchContext &ctx, const GridView &grid, GridPos from, GridPos to,
+                                        const SearchLimits &lim, float weight = 1.f);
+  // ALT heuristic, see landmarks.h
+  std::vector<GridPos> find_path_a_star(SearchContext &ctx, const GridView &grid, GridPos from, GridPos to,
+                                        const LandmarkTable &landmarks, float weight = 1.f);
+  // same search over the bit-packed grid, see navGrid.h
+  std::vector<GridPos> find_path_a_star(SearchContext &ctx, const NavGrid &grid, GridPos from, GridPos to,
+                                        float weight = 1.f);
+  // only tiles with enough clearance for the agent, see clearance.h
+  std::vector<GridPos> find_path_a_star(SearchContext &ctx, const ClearanceGrid &grid, GridPos from, GridPos to,
+                                        float weight = 1.f);
+};
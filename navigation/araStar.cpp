@@ -0,0 +1,165 @@
+#include "araStar.h"
+#include <algorithm>
+#include <chrono>
+#include "aStar.h"
+#include "landmarks.h"
+
+using ara_clock = std::chrono::steady_clock;
+
+constexpr float no_path = std::numeric_limits<float>::max();
+
+static void begin_pass(nav::AraStarContext &actx)
+{
+  if (++actx.pass == 0)
+  {
+    std::fill(actx.closedPass.begin(), actx.closedPass.end(), 0);
+    std::fill(actx.inconsPass.begin(), actx.inconsPass.end(), 0);
+    actx.pass = 1;
+  }
+}
+
+static bool is_stale(const nav::AraStarContext &actx, const nav::OpenNode &node)
+{
+  return node.g > actx.ctx.g[node.idx] || actx.closedPass[node.idx] == actx.pass;
+}
+
+// moves incons into open and re-keys everything for the new epsilon
+template<typename Heuristic>
+static void rebuild_open(nav::AraStarContext &actx, float epsilon, Heuristic heuristic)
+{
+  nav::SearchContext &ctx = actx.ctx;
+  size_t count = 0;
+  for (const nav::OpenNode &node : ctx.open)
+    if (!is_stale(actx, node))
+      ctx.open[count++] = node;
+  ctx.open.resize(count);
+  for (uint32_t idx : actx.incons)
+    ctx.open.push_back(nav::OpenNode{0.f, ctx.g[idx], idx});
+  actx.incons.clear();
+  begin_pass(actx);
+  for (nav::OpenNode &node : ctx.open)
+    node.f = node.g + epsilon * heuristic(node.idx);
+  std::make_heap(ctx.open.begin(), ctx.open.end(), nav::open_node_less);
+}
+
+// bound on how far the goal g is from optimal, from the lowest unweighted f left
+template<typename Heuristic>
+static float suboptimality(const nav::AraStarContext &actx, float goal_g, float epsilon, Heuristic heuristic)
+{
+  float minF = no_path;
+  for (const nav::OpenNode &node : actx.ctx.open)
+    if (!is_stale(actx, node))
+      minF = std::min(minF, node.g + heuristic(node.idx));
+  for (uint32_t idx : actx.incons)
+    minF = std::min(minF, actx.ctx.g[idx] + heuristic(idx));
+  return minF >= goal_g ? 1.f : std::min(epsilon, goal_g / minF);
+}
+
+// returns false if the deadline cut the pass short
+template<typename Heuristic>
+static bool improve_path(nav::AraStarContext &actx, const nav::GridView &grid, size_t goal, float epsilon,
+                         Heuristic heuristic, bool has_deadline, ara_clock::time_point deadline)
+{
+  nav::SearchContext &ctx = actx.ctx;
+  while (!ctx.open.empty())
+  {
+    const nav::OpenNode &top = ctx.open.front();
+    if (is_stale(actx, top))
+    {
+      ctx.pop();
+      continue;
+    }
+    if (top.f >= ctx.get_g(goal))
+      break;
+    // the clock is only sampled every few expansions, it costs more than one
+    if (has_deadline && (actx.expanded & 63) == 0 && ara_clock::now() >= deadline)
+      return false;
+    const nav::OpenNode cur = ctx.pop();
+    actx.closedPass[cur.idx] = actx.pass;
+    actx.expanded++;
+    const nav::GridPos p = grid.pos(cur.idx);
+    for (const nav::GridPos &offs : nav::neighbour_offsets)
+    {
+      const nav::GridPos np{p.x + offs.x, p.y + offs.y};
+      if (!grid.in_bounds(np))
+        continue;
+      const size_t nidx = grid.idx(np);
+      if (!grid.passable(nidx))
+        continue;
+      const float gScore = cur.g + grid.cost(nidx);
+      if (!ctx.relax(nidx, cur.idx, gScore))
+        continue;
+      if (actx.closedPass[nidx] != actx.pass)
+        ctx.push(nidx, gScore, gScore + epsilon * heuristic(nidx));
+      else if (actx.inconsPass[nidx] != actx.pass)
+      {
+        actx.inconsPass[nidx] = actx.pass;
+        actx.incons.push_back(uint32_t(nidx));
+      }
+    }
+  }
+  return true;
+}
+
+template<typename Heuristic>
+static std::vector<nav::GridPos> ara_star(nav::AraStarContext &actx, const nav::GridView &grid, nav::GridPos from,
+                                          nav::GridPos to, size_t budget_us, float start_epsilon, float epsilon_step,
+                                          Heuristic heuristic)
+{
+  using namespace nav;
+  const ara_clock::time_point deadline = ara_clock::now() + std::chrono::microseconds(budget_us);
+  begin_search(actx.ctx, grid);
+  if (actx.closedPass.size() != grid.size())
+  {
+    actx.closedPass.assign(grid.size(), 0);
+    actx.inconsPass.assign(grid.size(), 0);
+    actx.pass = 0;
+  }
+  actx.incons.clear();
+  actx.passes = 0;
+  actx.expanded = 0;
+  actx.epsilon = 0.f;
+  if (!grid.in_bounds(from) || !grid.in_bounds(to))
+    return std::vector<GridPos>();
+  const size_t goal = grid.idx(to);
+  float epsilon = std::max(start_epsilon, 1.f);
+  begin_pass(actx);
+  add_start(actx.ctx, grid.idx(from), 0.f, epsilon * heuristic(grid.idx(from)));
+
+  std::vector<GridPos> res;
+  while (true)
+  {
+    // the first pass ignores the budget, an anytime planner has to answer something
+    const bool finished = improve_path(actx, grid, goal, epsilon, heuristic, actx.passes > 0, deadline);
+    if (!finished)
+      break;
+    actx.passes++;
+    const float goalG = actx.ctx.get_g(goal);
+    if (goalG == no_path)
+      break;
+    res = actx.ctx.reconstruct_path(grid, goal);
+    actx.epsilon = suboptimality(actx, goalG, epsilon, heuristic);
+    if (actx.epsilon <= 1.f || ara_clock::now() >= deadline)
+      break;
+    epsilon = std::max(1.f, std::min(epsilon, actx.epsilon) - epsilon_step);
+    rebuild_open(actx, epsilon, heuristic);
+  }
+  actx.ctx.expanded = actx.expanded;
+  return res;
+}
+
+std::vector<nav::GridPos> nav::find_path_ara_star(AraStarContext &actx, const GridView &grid, GridPos from,
+                                                  GridPos to, size_t budget_us, float start_epsilon,
+                                                  float epsilon_step)
+{
+  return ara_star(actx, grid, from, to, budget_us, start_epsilon, epsilon_step, euclidean_to(grid, to));
+}
+
+std::vector<nav::GridPos> nav::find_path_ara_star(AraStarContext &actx, const GridView &grid,
+                                                  const LandmarkTable &landmarks, GridPos from, GridPos to,
+                                                  size_t budget_us, float start_epsilon, float epsilon_step)
+{
+  if (!can_use_landmarks(landmarks, grid, from, to))
+    return find_path_ara_star(actx, grid, from, to, budget_us, start_epsilon, epsilon_step);
+  return ara_star(actx, grid, from, to, budget_us, start_epsilon, epsilon_step, alt_to(landmarks, grid, to));
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "gridTypes.h"
+#include "searchContext.h"
+
+namespace nav
+{
+  struct LandmarkTable;
+
+  // Anytime repairing A*: the first pass runs with a high epsilon, following
+  // passes lower it and continue from the previous open list instead of
+  // starting over. Tiles improved after being closed wait in incons for the
+  // next pass.
+  struct AraStarContext
+  {
+    SearchContext ctx; // g, prev and the open heap, its closed stamps are unused
+    std::vector<uint32_t> closedPass;
+    std::vector<uint32_t> inconsPass;
+    std::vector<uint32_t> incons;
+    uint32_t pass = 0;
+
+    // stats of the last query
+    float epsilon = 0.f; // suboptimality bound of the returned path
+    size_t passes = 0;
+    size_t expanded = 0;
+  };
+
+  // The first path is always produced, later passes only run while budget_us
+  // lasts. A pass cut short by the budget keeps the previous path.
+  std::vector<GridPos> find_path_ara_star(AraStarContext &actx, const GridView &grid, GridPos from, GridPos to,
+                                          size_t budget_us, float start_epsilon = 3.f, float epsilon_step = 0.5f);
+  // ALT heuristic: a tighter h gives a better first path and a lower bound sooner
+  std::vector<GridPos> find_path_ara_star(AraStarContext &actx, const GridView &grid, const LandmarkTable &landmarks,
+                                          GridPos from, GridPos to, size_t budget_us, float start_epsilon = 3.f,
+                                          float epsilon_step = 0.5f);
+};
@@ -0,0 +1,124 @@
+#include "bidirectional.h"
+#include "aStar.h"
+#include "landmarks.h"
+
+using namespace nav;
+
+// drops stale heap entries, returns the key of the best live node
+static float top_key(SearchContext &ctx)
+{
+  while (!ctx.open.empty())
+  {
+    const OpenNode &top = ctx.open.front();
+    if (!ctx.is_closed(top.idx) && top.g <= ctx.g[top.idx])
+      return top.f;
+    ctx.pop();
+  }
+  return std::numeric_limits<float>::max();
+}
+
+// to_end bounds the rest of the way from a tile to the end this side searches toward
+template<typename Potential, typename ToEnd>
+static void expand(BidirectionalContext &bctx, const GridView &grid, bool forward, Potential potential,
+                   ToEnd to_end)
+{
+  SearchContext &ctx = forward ? bctx.fwd : bctx.bwd;
+  const SearchContext &other = forward ? bctx.bwd : bctx.fwd;
+  const OpenNode cur = ctx.pop();
+  // queued before the best meeting got this cheap
+  if (cur.g + to_end(cur.idx) >= bctx.cost)
+    return;
+  ctx.close(cur.idx);
+  const GridPos p = grid.pos(cur.idx);
+  for (const GridPos &offs : neighbour_offsets)
+  {
+    const GridPos np{p.x + offs.x, p.y + offs.y};
+    if (!grid.in_bounds(np))
+      continue;
+    const size_t nidx = grid.idx(np);
+    if (!grid.passable(nidx) || ctx.is_closed(nidx))
+      continue;
+    const float gScore = cur.g + (forward ? grid.cost(nidx) : grid.cost(cur.idx));
+    // no path through this tile can beat the best meeting, nor can a meeting on it
+    if (gScore + to_end(nidx) >= bctx.cost)
+      continue;
+    if (ctx.relax(nidx, cur.idx, gScore))
+      ctx.push(nidx, gScore, gScore + (forward ? potential(nidx) : -potential(nidx)));
+    if (other.is_seen(nidx) && ctx.g[nidx] + other.g[nidx] < bctx.cost)
+    {
+      bctx.cost = ctx.g[nidx] + other.g[nidx];
+      bctx.meet = nidx;
+    }
+  }
+}
+
+// The potential is the average of the two end bounds, to_target for the
+// forward search and its negation for the backward one. On their own the
+// bounds prune tiles that cannot lead to a cheaper meeting than the best one.
+template<typename ToTarget, typename FromSource>
+static std::vector<GridPos> run_bidirectional(BidirectionalContext &bctx, const GridView &grid,
+                                              GridPos from, GridPos to, ToTarget to_target,
+                                              FromSource from_source)
+{
+  auto potential = [&](size_t idx) { return 0.5f * (to_target(idx) - from_source(idx)); };
+  begin_search(bctx.fwd, grid);
+  begin_search(bctx.bwd, grid);
+  bctx.meet = invalid_idx;
+  bctx.cost = std::numeric_limits<float>::max();
+  if (!grid.in_bounds(from) || !grid.in_bounds(to))
+    return std::vector<GridPos>();
+  const size_t fromIdx = grid.idx(from);
+  const size_t toIdx = grid.idx(to);
+  if (fromIdx == toIdx)
+  {
+    bctx.meet = fromIdx;
+    bctx.cost = 0.f;
+    return std::vector<GridPos>{from};
+  }
+  add_start(bctx.fwd, fromIdx, 0.f, potential(fromIdx));
+  add_start(bctx.bwd, toIdx, 0.f, -potential(toIdx));
+  while (true)
+  {
+    const float topF = top_key(bctx.fwd);
+    const float topB = top_key(bctx.bwd);
+    // an exhausted side has already seen every path through its tiles
+    if (bctx.fwd.open.empty() || bctx.bwd.open.empty() || topF + topB >= bctx.cost)
+      break;
+    // expand the smaller frontier
+    if (bctx.fwd.open.size() <= bctx.bwd.open.size())
+      expand(bctx, grid, true, potential, to_target);
+    else
+      expand(bctx, grid, false, potential, from_source);
+  }
+  if (bctx.meet == invalid_idx)
+    return std::vector<GridPos>();
+  std::vector<GridPos> res = bctx.fwd.reconstruct_path(grid, bctx.meet);
+  for (uint32_t cur = bctx.bwd.prev[bctx.meet]; cur != SearchContext::no_prev; cur = bctx.bwd.prev[cur])
+    res.push_back(grid.pos(cur));
+  return res;
+}
+
+std::vector<GridPos> nav::find_path_bidirectional_dijkstra(BidirectionalContext &bctx, const GridView &grid,
+                                                           GridPos from, GridPos to)
+{
+  const auto zero = [](size_t) { return 0.f; };
+  return run_bidirectional(bctx, grid, from, to, zero, zero);
+}
+
+std::vector<GridPos> nav::find_path_bidirectional_a_star(BidirectionalContext &bctx, const GridView &grid,
+                                                         GridPos from, GridPos to)
+{
+  const auto toTarget = euclidean_to(grid, to);
+  const auto toSource = euclidean_to(grid, from);
+  return run_bidirectional(bctx, grid, from, to, toTarget, toSource);
+}
+
+std::vector<GridPos> nav::find_path_bidirectional_a_star(BidirectionalContext &bctx, const GridView &grid,
+                                                         const LandmarkTable &landmarks, GridPos from, GridPos to)
+{
+  if (!can_use_landmarks(landmarks, grid, from, to))
+    return find_path_bidirectional_a_star(bctx, grid, from, to);
+  const auto toTarget = alt_to(landmarks, grid, to);
+  const auto fromSource = alt_from(landmarks, grid, from);
+  return run_bidirectional(bctx, grid, from, to, toTarget, fromSource);
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <vector>
+#include "gridTypes.h"
+#include "searchContext.h"
+
+namespace nav
+{
+  struct LandmarkTable;
+
+  // Two searches, one from each end, meeting in the middle. The backward one
+  // walks edges in reverse, so it pays the cost of the tile it expands from.
+  struct BidirectionalContext
+  {
+    SearchContext fwd;
+    SearchContext bwd;
+
+    // result of the last query
+    size_t meet = invalid_idx;
+    float cost = 0.f;
+  };
+
+  std::vector<GridPos> find_path_bidirectional_dijkstra(BidirectionalContext &bctx, const GridView &grid,
+                                                        GridPos from, GridPos to);
+  // uses the average of the forward and backward euclidean potentials, which
+  // keeps both directions consistent so the meet condition stays exact. Tiles
+  // whose end bound cannot beat the best meeting are pruned. This does not
+  // halve the explored area on the benchmark caves: it expands 0-22% fewer
+  // tiles than A* and is no faster per query.
+  std::vector<GridPos> find_path_bidirectional_a_star(BidirectionalContext &bctx, const GridView &grid,
+                                                      GridPos from, GridPos to);
+  // same averaging over the ALT bounds toward the target and from the source
+  std::vector<GridPos> find_path_bidirectional_a_star(BidirectionalContext &bctx, const GridView &grid,
+                                                      const LandmarkTable &landmarks, GridPos from, GridPos to);
+};
@@ -0,0 +1,49 @@
+#include "clearance.h"
+#include <algorithm>
+
+using namespace nav;
+
+// needs the right, lower and lower right tiles to be final already
+static uint8_t tile_clearance(const ClearanceMap &cm, const GridView &grid, size_t x, size_t y)
+{
+  const size_t idx = y * grid.width + x;
+  if (!grid.passable(idx))
+    return 0;
+  // the map border counts as wall
+  if (x + 1 >= grid.width || y + 1 >= grid.height)
+    return 1;
+  const uint8_t around = std::min({cm.clearance[idx + 1], cm.clearance[idx + grid.width],
+                                   cm.clearance[idx + grid.width + 1]});
+  return uint8_t(std::min(around + 1, int(max_clearance)));
+}
+
+ClearanceMap nav::build_clearance(const GridView &grid)
+{
+  ClearanceMap cm;
+  cm.width = grid.width;
+  cm.height = grid.height;
+  cm.clearance.assign(grid.size(), 0);
+  for (size_t y = grid.height; y-- > 0;)
+    for (size_t x = grid.width; x-- > 0;)
+      cm.clearance[y * grid.width + x] = tile_clearance(cm, grid, x, y);
+  return cm;
+}
+
+void nav::update_clearance(ClearanceMap &cm, const GridView &grid, const std::vector<GridPos> &changed)
+{
+  if (cm.width != grid.width || cm.height != grid.height)
+  {
+    cm = build_clearance(grid);
+    return;
+  }
+  constexpr int reach = int(max_clearance) - 1;
+  for (const GridPos &p : changed)
+  {
+    if (!grid.in_bounds(p))
+      continue;
+    // same sweep order as the build, restricted to the tiles that can see p
+    for (int y = p.y; y >= std::max(p.y - reach, 0); --y)
+      for (int x = p.x; x >= std::max(p.x - reach, 0); --x)
+        cm.clearance[grid.idx(GridPos{x, y})] = tile_clearance(cm, grid, size_t(x), size_t(y));
+  }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "gridTypes.h"
+
+namespace nav
+{
+  constexpr uint8_t max_clearance = 16;
+
+  // Clearance of a tile is the side of the largest wall free square with its
+  // top left corner on the tile, 0 on walls, capped at max_clearance. An
+  // n x n agent anchored at its top left tile fits wherever clearance >= n,
+  // which covers even sizes that have no center tile. A tile only depends on
+  // its right, lower and lower right neighbours, so one sweep from the bottom
+  // right corner builds the map and an edit only reaches max_clearance - 1
+  // tiles up and left of it.
+  struct ClearanceMap
+  {
+    size_t width = 0;
+    size_t height = 0;
+    std::vector<uint8_t> clearance;
+  };
+
+  ClearanceMap build_clearance(const GridView &grid);
+  // grid already has the changed tiles in their new state
+  void update_clearance(ClearanceMap &cm, const GridView &grid, const std::vector<GridPos> &changed);
+
+  // tiles an agent of agent_size fits on, plugs into run_a_star like GridView
+  struct ClearanceGrid
+  {
+    const char *tiles = nullptr;
+    size_t width = 0;
+    size_t height = 0;
+    const uint8_t *clearance = nullptr;
+    uint8_t agentSize = 1;
+
+    size_t size() const { return width * height; }
+    size_t idx(GridPos p) const { return size_t(p.y) * width + size_t(p.x); }
+    GridPos pos(size_t idx) const { return GridPos{int(idx % width), int(idx / width)}; }
+    bool in_bounds(GridPos p) const { return p.x >= 0 && p.y >= 0 && p.x < int(width) && p.y < int(height); }
+
+    bool passable(size_t idx) const { return clearance[idx] >= agentSize; }
+    // the anchor tile decides the cost, the rest of the footprint is free to enter
+    float cost(size_t idx) const { return float(terrain_cost(tiles[idx])); }
+  };
+
+  inline ClearanceGrid clearance_grid(const GridView &grid, const ClearanceMap &cm, uint8_t agent_size)
+  {
+    return ClearanceGrid{grid.tiles, grid.width, grid.height, cm.clearance.data(), agent_size};
+  }
+};
@@ -0,0 +1,161 @@
+#include "components.h"
+#include <algorithm>
+#include <utility>
+
+using namespace nav;
+
+static uint32_t find_root(const ComponentMap &cm, uint32_t idx)
+{
+  while (cm.parent[idx] != idx)
+    idx = cm.parent[idx];
+  return idx;
+}
+
+// path halving on the way up, only the update side may mutate the forest
+static uint32_t find_root_compress(ComponentMap &cm, uint32_t idx)
+{
+  while (cm.parent[idx] != idx)
+  {
+    cm.parent[idx] = cm.parent[cm.parent[idx]];
+    idx = cm.parent[idx];
+  }
+  return idx;
+}
+
+static void unite(ComponentMap &cm, uint32_t a, uint32_t b)
+{
+  a = find_root_compress(cm, a);
+  b = find_root_compress(cm, b);
+  if (a == b)
+    return;
+  if (cm.size[a] < cm.size[b])
+    std::swap(a, b);
+  cm.parent[b] = a;
+  cm.size[a] += cm.size[b];
+}
+
+template<typename Callable>
+static void for_each_passable_neighbour(const GridView &grid, size_t idx, Callable c)
+{
+  const GridPos p = grid.pos(idx);
+  for (const GridPos &offs : neighbour_offsets)
+  {
+    const GridPos np{p.x + offs.x, p.y + offs.y};
+    if (grid.in_bounds(np) && grid.passable(grid.idx(np)))
+      c(uint32_t(grid.idx(np)));
+  }
+}
+
+ComponentMap nav::build_components(const GridView &grid)
+{
+  ComponentMap cm;
+  cm.width = grid.width;
+  cm.height = grid.height;
+  cm.parent.assign(grid.size(), ComponentMap::no_component);
+  cm.size.assign(grid.size(), 0);
+  for (size_t idx = 0; idx < grid.size(); ++idx)
+    if (grid.passable(idx))
+    {
+      cm.parent[idx] = uint32_t(idx);
+      cm.size[idx] = 1;
+    }
+  // right and down neighbours are enough to see every edge once
+  for (size_t y = 0; y < grid.height; ++y)
+    for (size_t x = 0; x < grid.width; ++x)
+    {
+      const size_t idx = y * grid.width + x;
+      if (!grid.passable(idx))
+        continue;
+      if (x + 1 < grid.width && grid.passable(idx + 1))
+        unite(cm, uint32_t(idx), uint32_t(idx + 1));
+      if (y + 1 < grid.height && grid.passable(idx + grid.width))
+        unite(cm, uint32_t(idx), uint32_t(idx + grid.width));
+    }
+  // flatten, fresh maps answer every query in one hop
+  for (size_t idx = 0; idx < grid.size(); ++idx)
+    if (cm.parent[idx] != ComponentMap::no_component)
+      cm.parent[idx] = find_root_compress(cm, uint32_t(idx));
+  return cm;
+}
+
+// floods the region around a closed tile again, each flood becomes its own flat component
+static void split_component(ComponentMap &cm, const GridView &grid, size_t closed)
+{
+  if (cm.visitGen.size() != grid.size())
+  {
+    cm.visitGen.assign(grid.size(), 0);
+    cm.generation = 0;
+  }
+  if (++cm.generation == 0)
+  {
+    std::fill(cm.visitGen.begin(), cm.visitGen.end(), 0);
+    cm.generation = 1;
+  }
+  std::vector<uint32_t> &region = cm.region;
+  for_each_passable_neighbour(grid, closed, [&](uint32_t start)
+  {
+    if (cm.visitGen[start] == cm.generation)
+      return;
+    region.clear();
+    region.push_back(start);
+    cm.visitGen[start] = cm.generation;
+    for (size_t i = 0; i < region.size(); ++i)
+      for_each_passable_neighbour(grid, region[i], [&](uint32_t nidx)
+      {
+        if (cm.visitGen[nidx] == cm.generation)
+          return;
+        cm.visitGen[nidx] = cm.generation;
+        region.push_back(nidx);
+      });
+    for (uint32_t idx : region)
+      cm.parent[idx] = start;
+    cm.size[start] = uint32_t(region.size());
+  });
+}
+
+void nav::update_components(ComponentMap &cm, const GridView &grid, const std::vector<GridPos> &changed)
+{
+  if (cm.width != grid.width || cm.height != grid.height)
+  {
+    cm = build_components(grid);
+    return;
+  }
+  for (const GridPos &p : changed)
+  {
+    if (!grid.in_bounds(p))
+      continue;
+    const size_t idx = grid.idx(p);
+    const bool wasPassable = cm.parent[idx] != ComponentMap::no_component;
+    if (grid.passable(idx))
+    {
+      if (!wasPassable)
+      {
+        cm.parent[idx] = uint32_t(idx);
+        cm.size[idx] = 1;
+      }
+      for_each_passable_neighbour(grid, idx, [&](uint32_t nidx)
+      {
+        if (cm.parent[nidx] == ComponentMap::no_component) // opened later in this batch
+        {
+          cm.parent[nidx] = nidx;
+          cm.size[nidx] = 1;
+        }
+        unite(cm, uint32_t(idx), nidx);
+      });
+    }
+    else if (wasPassable)
+    {
+      cm.parent[idx] = ComponentMap::no_component;
+      cm.size[idx] = 0;
+      split_component(cm, grid, idx);
+    }
+  }
+}
+
+uint32_t nav::component_of(const ComponentMap &cm, GridPos p)
+{
+  if (p.x < 0 || p.y < 0 || p.x >= int(cm.width) || p.y >= int(cm.height))
+    return ComponentMap::no_component;
+  const uint32_t idx = uint32_t(size_t(p.y) * cm.width + size_t(p.x));
+  return cm.parent[idx] == ComponentMap::no_component ? ComponentMap::no_component : find_root(cm, idx);
+}
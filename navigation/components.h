@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "gridTypes.h"
+
+namespace nav
+{
+  // Connected components of the passable tiles as a union-find forest, so an
+  // unreachable target is rejected before a search floods the whole region.
+  // Opening a tile is a union with its neighbours, closing one relabels only
+  // the component it belonged to. Queries walk to the root without path
+  // compression and stay const, union by size keeps the trees shallow.
+  struct ComponentMap
+  {
+    static constexpr uint32_t no_component = uint32_t(-1);
+
+    size_t width = 0;
+    size_t height = 0;
+    std::vector<uint32_t> parent; // no_component for impassable tiles
+    std::vector<uint32_t> size; // tiles under a root, only meaningful for roots
+
+    // scratch of update_components, a split marks its flood with the generation
+    // so closing a tile costs its component and not the whole map
+    std::vector<uint32_t> visitGen;
+    std::vector<uint32_t> region;
+    uint32_t generation = 0;
+  };
+
+  ComponentMap build_components(const GridView &grid);
+  // grid already has the changed tiles in their new state
+  void update_components(ComponentMap &cm, const GridView &grid, const std::vector<GridPos> &changed);
+
+  // root tile index of the component, no_component for walls and out of bounds
+  uint32_t component_of(const ComponentMap &cm, GridPos p);
+
+  inline bool is_reachable(const ComponentMap &cm, GridPos from, GridPos to)
+  {
+    const uint32_t comp = component_of(cm, from);
+    return comp != ComponentMap::no_component && comp == component_of(cm, to);
+  }
+};
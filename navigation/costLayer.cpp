@@ -0,0 +1,57 @@
+#include "costLayer.h"
+#include <algorithm>
+
+using namespace nav;
+
+TerrainCosts nav::default_terrain_costs()
+{
+  TerrainCosts res;
+  for (size_t c = 0; c < res.size(); ++c)
+    res[c] = terrain_cost(char(c));
+  return res;
+}
+
+static void update_bounds(CostLayer &layer)
+{
+  layer.minCost = impassable_cost;
+  layer.maxCost = 1;
+  for (uint8_t cost : layer.costs)
+    if (cost != impassable_cost)
+    {
+      layer.minCost = std::min(layer.minCost, cost);
+      layer.maxCost = std::max(layer.maxCost, cost);
+    }
+  if (layer.minCost == impassable_cost)
+    layer.minCost = 1;
+}
+
+CostLayer nav::build_cost_layer(const GridView &grid)
+{
+  return build_cost_layer(grid, default_terrain_costs());
+}
+
+CostLayer nav::build_cost_layer(const GridView &grid, const TerrainCosts &terrain)
+{
+  CostLayer layer;
+  layer.width = grid.width;
+  layer.height = grid.height;
+  layer.costs.resize(grid.size());
+  for (size_t idx = 0; idx < grid.size(); ++idx)
+    layer.costs[idx] = std::max(terrain[uint8_t(grid.tiles[idx])], uint8_t(1));
+  update_bounds(layer);
+  return layer;
+}
+
+void nav::set_tile_cost(CostLayer &layer, GridPos p, uint8_t cost)
+{
+  if (!layer.in_bounds(p))
+    return;
+  cost = std::max(cost, uint8_t(1));
+  layer.costs[layer.idx(p)] = cost;
+  // bounds only widen, a loose range keeps the heuristic admissible and the ring big enough
+  if (cost != impassable_cost)
+  {
+    layer.minCost = std::min(layer.minCost, cost);
+    layer.maxCost = std::max(layer.maxCost, cost);
+  }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "gridTypes.h"
+
+namespace nav
+{
+  // entry cost per tile character, impassable_cost marks walls
+  using TerrainCosts = std::array<uint8_t, 256>;
+
+  // the table terrain_cost describes, copy and edit it for other rules
+  TerrainCosts default_terrain_costs();
+
+  // Integer entry cost per tile, 1..254 for passable tiles and
+  // impassable_cost for walls. Fits the Grid interface of run_a_star and
+  // feeds the bucket queue searches in dial.h.
+  struct CostLayer
+  {
+    size_t width = 0;
+    size_t height = 0;
+    std::vector<uint8_t> costs;
+    uint8_t minCost = 1; // over passable tiles, scales the A* heuristic
+    uint8_t maxCost = 1; // over passable tiles, sizes the bucket ring
+
+    size_t size() const { return width * height; }
+    size_t idx(GridPos p) const { return size_t(p.y) * width + size_t(p.x); }
+    GridPos pos(size_t idx) const { return GridPos{int(idx % width), int(idx / width)}; }
+    bool in_bounds(GridPos p) const { return p.x >= 0 && p.y >= 0 && p.x < int(width) && p.y < int(height); }
+
+    bool passable(size_t idx) const { return costs[idx] != impassable_cost; }
+    float cost(size_t idx) const { return float(costs[idx]); }
+  };
+
+  CostLayer build_cost_layer(const GridView &grid);
+  CostLayer build_cost_layer(const GridView &grid, const TerrainCosts &terrain);
+  // cost 0 is clamped to 1, every step has to cost something
+  void set_tile_cost(CostLayer &layer, GridPos p, uint8_t cost);
+};
@@ -0,0 +1,94 @@
+#include "dial.h"
+#include <bit>
+#include <cstdlib>
+
+using namespace nav;
+
+void BucketQueue::reset(uint32_t max_delta)
+{
+  const size_t len = std::bit_ceil(size_t(max_delta) + 1);
+  buckets.resize(len);
+  for (std::vector<uint32_t> &bucket : buckets)
+    bucket.clear();
+  mask = len - 1;
+  cur = 0;
+  count = 0;
+}
+
+void BucketQueue::push(uint32_t idx, uint32_t f)
+{
+  buckets[f & mask].push_back(idx);
+  ++count;
+}
+
+uint32_t BucketQueue::pop()
+{
+  while (buckets[cur & mask].empty())
+    ++cur;
+  std::vector<uint32_t> &bucket = buckets[cur & mask];
+  const uint32_t res = bucket.back();
+  bucket.pop_back();
+  --count;
+  return res;
+}
+
+// heuristic_scale 0 is Dijkstra, minCost keeps manhattan admissible and consistent
+static std::vector<GridPos> dial_search(DialContext &dctx, const CostLayer &layer, GridPos from, GridPos to,
+                                        uint32_t heuristic_scale)
+{
+  SearchContext &ctx = dctx.tiles;
+  BucketQueue &open = dctx.open;
+  ctx.reset(layer.size());
+  // an edge raises f by at most its cost plus the heuristic drop of one step
+  open.reset(uint32_t(layer.maxCost) + heuristic_scale);
+  if (!layer.in_bounds(from) || !layer.in_bounds(to))
+    return std::vector<GridPos>();
+  const auto heuristic = [&](size_t idx)
+  {
+    const GridPos p = layer.pos(idx);
+    return heuristic_scale * uint32_t(std::abs(p.x - to.x) + std::abs(p.y - to.y));
+  };
+  const size_t fromIdx = layer.idx(from);
+  const size_t toIdx = layer.idx(to);
+  ctx.relax(fromIdx, SearchContext::no_prev, 0.f);
+  open.push(uint32_t(fromIdx), heuristic(fromIdx));
+  ++ctx.pushed;
+  while (!open.empty())
+  {
+    const uint32_t idx = open.pop();
+    // g only drops, so an outdated entry sits in a later bucket than the one that closed the tile
+    if (ctx.is_closed(idx))
+      continue;
+    ctx.close(idx);
+    if (idx == toIdx)
+      return ctx.reconstruct_path(layer, idx);
+    const uint32_t g = uint32_t(ctx.g[idx]);
+    const GridPos p = layer.pos(idx);
+    for (const GridPos &offs : neighbour_offsets)
+    {
+      const GridPos np{p.x + offs.x, p.y + offs.y};
+      if (!layer.in_bounds(np))
+        continue;
+      const size_t nidx = layer.idx(np);
+      if (!layer.passable(nidx) || ctx.is_closed(nidx))
+        continue;
+      const uint32_t gScore = g + layer.costs[nidx];
+      if (ctx.relax(nidx, idx, float(gScore)))
+      {
+        open.push(uint32_t(nidx), gScore + heuristic(nidx));
+        ++ctx.pushed;
+      }
+    }
+  }
+  return std::vector<GridPos>();
+}
+
+std::vector<GridPos> nav::find_path_dial_dijkstra(DialContext &dctx, const CostLayer &layer, GridPos from, GridPos to)
+{
+  return dial_search(dctx, layer, from, to, 0);
+}
+
+std::vector<GridPos> nav::find_path_dial_a_star(DialContext &dctx, const CostLayer &layer, GridPos from, GridPos to)
+{
+  return dial_search(dctx, layer, from, to, layer.minCost);
+}
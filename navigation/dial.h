@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "costLayer.h"
+#include "searchContext.h"
+
+namespace nav
+{
+  // Dial's bucket queue: one bucket per integer f in a ring. Keys pushed
+  // while popping f lie in [f, f + maxDelta], so a ring longer than maxDelta
+  // never mixes two keys in one bucket and push/pop are O(1) instead of the
+  // heap's O(log n). Buckets pop last in first, deeper nodes go first on ties.
+  struct BucketQueue
+  {
+    std::vector<std::vector<uint32_t>> buckets;
+    size_t mask = 0;
+    uint32_t cur = 0; // ring position of the bucket being popped, only its low bits matter
+    size_t count = 0;
+
+    void reset(uint32_t max_delta);
+    bool empty() const { return count == 0; }
+    void push(uint32_t idx, uint32_t f);
+    uint32_t pop();
+  };
+
+  // tile state lives in a regular SearchContext (integer g is exact in
+  // float), so paths and debug drawing work as for the heap searches
+  struct DialContext
+  {
+    SearchContext tiles;
+    BucketQueue open;
+  };
+
+  std::vector<GridPos> find_path_dial_dijkstra(DialContext &dctx, const CostLayer &layer, GridPos from, GridPos to);
+  // manhattan distance times the cheapest tile cost as the heuristic
+  std::vector<GridPos> find_path_dial_a_star(DialContext &dctx, const CostLayer &layer, GridPos from, GridPos to);
+};
@@ -0,0 +1,222 @@
+#include "dstarLite.h"
+#include <algorithm>
+#include <limits>
+
+constexpr float inf = std::numeric_limits<float>::infinity();
+
+static bool key_less(const nav::DStarKey &lhs, const nav::DStarKey &rhs)
+{
+  return lhs.k1 < rhs.k1 || (lhs.k1 == rhs.k1 && lhs.k2 < rhs.k2);
+}
+
+static bool key_equal(const nav::DStarKey &lhs, const nav::DStarKey &rhs)
+{
+  return lhs.k1 == rhs.k1 && lhs.k2 == rhs.k2;
+}
+
+static bool entry_greater(const nav::DStarEntry &lhs, const nav::DStarEntry &rhs)
+{
+  return key_less(rhs.key, lhs.key);
+}
+
+static nav::DStarKey calculate_key(const nav::DStarLite &ds, size_t idx)
+{
+  const float v = std::min(ds.g[idx], ds.rhs[idx]);
+  const nav::GridPos p{int(idx % ds.width), int(idx / ds.width)};
+  return nav::DStarKey{v + nav::manhattan(ds.start, p) + ds.km, v};
+}
+
+// edge cost: entering `to`, the same model as A*
+static float edge_cost(const nav::GridView &grid, size_t from, size_t to)
+{
+  if (!grid.passable(from) || !grid.passable(to))
+    return inf;
+  return grid.cost(to);
+}
+
+template<typename Callable>
+static void for_each_neighbour(const nav::DStarLite &ds, size_t idx, Callable c)
+{
+  const nav::GridPos p{int(idx % ds.width), int(idx / ds.width)};
+  for (const nav::GridPos &offs : nav::neighbour_offsets)
+  {
+    const nav::GridPos np{p.x + offs.x, p.y + offs.y};
+    if (np.x < 0 || np.y < 0 || np.x >= int(ds.width) || np.y >= int(ds.height))
+      continue;
+    c(size_t(np.y) * ds.width + size_t(np.x));
+  }
+}
+
+static void push_open(nav::DStarLite &ds, size_t idx)
+{
+  const nav::DStarKey key = calculate_key(ds, idx);
+  ds.openKey[idx] = key;
+  ds.inOpen[idx] = 1;
+  ds.open.push_back(nav::DStarEntry{key, uint32_t(idx)});
+  std::push_heap(ds.open.begin(), ds.open.end(), entry_greater);
+}
+
+// drops heap entries that were removed or re-keyed since they were pushed
+static void skip_stale(nav::DStarLite &ds)
+{
+  while (!ds.open.empty())
+  {
+    const nav::DStarEntry &top = ds.open.front();
+    if (ds.inOpen[top.idx] && key_equal(ds.openKey[top.idx], top.key))
+      return;
+    std::pop_heap(ds.open.begin(), ds.open.end(), entry_greater);
+    ds.open.pop_back();
+  }
+}
+
+static void update_vertex(nav::DStarLite &ds, const nav::GridView &grid, size_t idx)
+{
+  if (idx != grid.idx(ds.goal))
+  {
+    float best = inf;
+    for_each_neighbour(ds, idx, [&](size_t nidx)
+    {
+      best = std::min(best, edge_cost(grid, idx, nidx) + ds.g[nidx]);
+    });
+    ds.rhs[idx] = best;
+  }
+  ds.inOpen[idx] = 0;
+  if (ds.g[idx] != ds.rhs[idx])
+    push_open(ds, idx);
+}
+
+void nav::dstar_init(DStarLite &ds, const GridView &grid, GridPos start, GridPos goal)
+{
+  ds.width = grid.width;
+  ds.height = grid.height;
+  ds.start = start;
+  ds.last = start;
+  ds.goal = goal;
+  ds.km = 0.f;
+  ds.g.assign(grid.size(), inf);
+  ds.rhs.assign(grid.size(), inf);
+  ds.openKey.assign(grid.size(), DStarKey{inf, inf});
+  ds.inOpen.assign(grid.size(), 0);
+  ds.open.clear();
+  ds.initialized = grid.in_bounds(start) && grid.in_bounds(goal);
+  if (!ds.initialized)
+    return;
+  const size_t goalIdx = grid.idx(goal);
+  ds.rhs[goalIdx] = grid.passable(goalIdx) ? 0.f : inf;
+  if (ds.rhs[goalIdx] == 0.f)
+    push_open(ds, goalIdx);
+}
+
+void nav::dstar_move_start(DStarLite &ds, GridPos start)
+{
+  // keys already in the queue stay valid lower bounds after km grows
+  ds.km += manhattan(ds.last, start);
+  ds.last = start;
+  ds.start = start;
+}
+
+void nav::dstar_update_tiles(DStarLite &ds, const GridView &grid, const std::vector<GridPos> &changed)
+{
+  if (!ds.initialized)
+    return;
+  const size_t goalIdx = grid.idx(ds.goal);
+  for (const GridPos &p : changed)
+  {
+    if (!grid.in_bounds(p))
+      continue;
+    const size_t idx = grid.idx(p);
+    if (idx == goalIdx)
+    {
+      ds.rhs[idx] = grid.passable(idx) ? 0.f : inf;
+      ds.inOpen[idx] = 0;
+      if (ds.g[idx] != ds.rhs[idx])
+        push_open(ds, idx);
+    }
+    else
+      update_vertex(ds, grid, idx);
+    // edges into the tile changed their cost
+    for_each_neighbour(ds, idx, [&](size_t nidx) { update_vertex(ds, grid, nidx); });
+  }
+}
+
+bool nav::dstar_compute(DStarLite &ds, const GridView &grid)
+{
+  ds.expanded = 0;
+  if (!ds.initialized || !grid.in_bounds(ds.start))
+    return false;
+  const size_t startIdx = grid.idx(ds.start);
+  while (true)
+  {
+    skip_stale(ds);
+    const DStarKey startKey = calculate_key(ds, startIdx);
+    if (ds.open.empty() ||
+        (!key_less(ds.open.front().key, startKey) && ds.rhs[startIdx] <= ds.g[startIdx]))
+      break;
+    const DStarEntry top = ds.open.front();
+    const size_t u = top.idx;
+    const DStarKey newKey = calculate_key(ds, u);
+    if (key_less(top.key, newKey))
+    {
+      push_open(ds, u);
+      continue;
+    }
+    ds.inOpen[u] = 0;
+    ds.expanded++;
+    if (ds.g[u] > ds.rhs[u])
+    {
+      ds.g[u] = ds.rhs[u];
+      for_each_neighbour(ds, u, [&](size_t pred)
+      {
+        const float viaU = edge_cost(grid, pred, u) + ds.g[u];
+        if (pred != grid.idx(ds.goal) && viaU < ds.rhs[pred])
+        {
+          ds.rhs[pred] = viaU;
+          ds.inOpen[pred] = 0;
+          if (ds.g[pred] != ds.rhs[pred])
+            push_open(ds, pred);
+        }
+      });
+    }
+    else
+    {
+      ds.g[u] = inf;
+      update_vertex(ds, grid, u);
+      for_each_neighbour(ds, u, [&](size_t pred) { update_vertex(ds, grid, pred); });
+    }
+  }
+  return ds.g[startIdx] < inf || ds.rhs[startIdx] < inf;
+}
+
+std::vector<nav::GridPos> nav::dstar_path(const DStarLite &ds, const GridView &grid)
+{
+  std::vector<GridPos> res;
+  if (!ds.initialized || !grid.in_bounds(ds.start))
+    return res;
+  size_t cur = grid.idx(ds.start);
+  const size_t goalIdx = grid.idx(ds.goal);
+  if (ds.rhs[cur] == inf)
+    return res;
+  res.push_back(ds.start);
+  // greedy descent on g, bounded in case the state is not fully consistent
+  for (size_t steps = 0; cur != goalIdx && steps < grid.size(); ++steps)
+  {
+    size_t best = invalid_idx;
+    float bestVal = inf;
+    for_each_neighbour(ds, cur, [&](size_t nidx)
+    {
+      const float val = edge_cost(grid, cur, nidx) + ds.g[nidx];
+      if (val < bestVal)
+      {
+        bestVal = val;
+        best = nidx;
+      }
+    });
+    if (best == invalid_idx)
+      return std::vector<GridPos>();
+    cur = best;
+    res.push_back(grid.pos(cur));
+  }
+  if (cur != goalIdx)
+    return std::vector<GridPos>();
+  return res;
+}
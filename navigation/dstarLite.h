@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "gridTypes.h"
+
+namespace nav
+{
+  struct DStarKey
+  {
+    float k1;
+    float k2;
+  };
+
+  struct DStarEntry
+  {
+    DStarKey key;
+    uint32_t idx;
+  };
+
+  // D* Lite: searches backwards from the goal and keeps g/rhs between calls, so
+  // after tile edits or start moves only inconsistent tiles are re-expanded.
+  // A goal change needs a new init.
+  struct DStarLite
+  {
+    size_t width = 0;
+    size_t height = 0;
+    GridPos start;
+    GridPos goal;
+    GridPos last;
+    float km = 0.f;
+    std::vector<float> g;
+    std::vector<float> rhs;
+    std::vector<DStarKey> openKey;
+    std::vector<uint8_t> inOpen;
+    std::vector<DStarEntry> open;
+    bool initialized = false;
+
+    size_t expanded = 0; // by the last compute
+  };
+
+  void dstar_init(DStarLite &ds, const GridView &grid, GridPos start, GridPos goal);
+  void dstar_move_start(DStarLite &ds, GridPos start);
+  // tiles already hold their new values in grid
+  void dstar_update_tiles(DStarLite &ds, const GridView &grid, const std::vector<GridPos> &changed);
+  // false if the goal is unreachable
+  bool dstar_compute(DStarLite &ds, const GridView &grid);
+  std::vector<GridPos> dstar_path(const DStarLite &ds, const GridView &grid);
+};
@@ -0,0 +1,111 @@
+#include "flowField.h"
+#include "aStar.h"
+
+constexpr float unreachable = std::numeric_limits<float>::max();
+
+// Reverse Dijkstra from the goal. Until old_goal is settled every tile is
+// searched, after that a tile is only entered when it beats the route through
+// the old goal. Returns false if old_goal was given but never reached.
+static bool run_reverse_dijkstra(nav::FlowField &ff, const nav::GridView &grid, size_t goal, size_t old_goal)
+{
+  nav::SearchContext &ctx = ff.ctx;
+  nav::begin_search(ctx, grid);
+  nav::add_start(ctx, goal, 0.f, 0.f);
+  float offset = old_goal == nav::invalid_idx ? 0.f : unreachable;
+  while (!ctx.open.empty())
+  {
+    const nav::OpenNode cur = ctx.pop();
+    if (ctx.is_closed(cur.idx) || cur.g > ctx.g[cur.idx])
+      continue;
+    ctx.close(cur.idx);
+    if (cur.idx == old_goal)
+      offset = cur.g;
+    const nav::GridPos p = grid.pos(cur.idx);
+    for (size_t dir = 0; dir < 4; ++dir)
+    {
+      const nav::GridPos np{p.x + nav::neighbour_offsets[dir].x, p.y + nav::neighbour_offsets[dir].y};
+      if (!grid.in_bounds(np))
+        continue;
+      const size_t nidx = grid.idx(np);
+      if (!grid.passable(nidx) || ctx.is_closed(nidx))
+        continue;
+      // walking from nidx into cur pays for cur
+      const float gScore = cur.g + grid.cost(cur.idx);
+      if (offset != unreachable && old_goal != nav::invalid_idx && !ctx.is_seen(nidx) &&
+          gScore >= ff.cost[nidx] + offset)
+        continue;
+      if (ctx.relax(nidx, cur.idx, gScore))
+        ctx.push(nidx, gScore, gScore);
+    }
+  }
+  if (old_goal != nav::invalid_idx && offset == unreachable)
+    return false;
+  // merge: searched tiles take the new values, the rest route through the old goal
+  ff.touched = 0;
+  for (size_t idx = 0; idx < grid.size(); ++idx)
+  {
+    if (!ctx.is_seen(idx))
+    {
+      if (old_goal == nav::invalid_idx)
+      {
+        ff.cost[idx] = unreachable;
+        ff.dir[idx] = nav::flow_none;
+      }
+      else if (ff.cost[idx] != unreachable)
+        ff.cost[idx] += offset;
+      continue;
+    }
+    ff.touched++;
+    // tiles pushed before the offset was known can miss a tied route through a
+    // pruned tile, the old route is exact for them
+    if (old_goal != nav::invalid_idx && idx != old_goal && ff.cost[idx] != unreachable &&
+        ff.cost[idx] + offset <= ctx.g[idx])
+    {
+      ff.cost[idx] += offset;
+      continue;
+    }
+    ff.cost[idx] = ctx.g[idx];
+    const uint32_t next = ctx.prev[idx];
+    if (next == nav::SearchContext::no_prev)
+    {
+      ff.dir[idx] = nav::flow_none;
+      continue;
+    }
+    const nav::GridPos p = grid.pos(idx);
+    const nav::GridPos np = grid.pos(next);
+    for (uint8_t dir = 0; dir < 4; ++dir)
+      if (np.x - p.x == nav::neighbour_offsets[dir].x && np.y - p.y == nav::neighbour_offsets[dir].y)
+        ff.dir[idx] = dir;
+  }
+  return true;
+}
+
+void nav::build_flow_field(FlowField &ff, const GridView &grid, GridPos goal)
+{
+  ff.width = grid.width;
+  ff.height = grid.height;
+  ff.goal = goal;
+  ff.cost.assign(grid.size(), unreachable);
+  ff.dir.assign(grid.size(), flow_none);
+  ff.touched = 0;
+  if (!grid.in_bounds(goal) || !grid.passable(grid.idx(goal)))
+    return;
+  run_reverse_dijkstra(ff, grid, grid.idx(goal), invalid_idx);
+}
+
+void nav::update_flow_field(FlowField &ff, const GridView &grid, GridPos goal)
+{
+  if (ff.width != grid.width || ff.height != grid.height || !grid.in_bounds(ff.goal) ||
+      !grid.in_bounds(goal) || !grid.passable(grid.idx(goal)) || ff.cost[grid.idx(ff.goal)] != 0.f)
+  {
+    build_flow_field(ff, grid, goal);
+    return;
+  }
+  if (goal == ff.goal)
+    return;
+  const size_t oldGoal = grid.idx(ff.goal);
+  ff.goal = goal;
+  // the goals are in different components, nothing to reuse
+  if (!run_reverse_dijkstra(ff, grid, grid.idx(goal), oldGoal))
+    build_flow_field(ff, grid, goal);
+}
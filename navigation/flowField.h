@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "gridTypes.h"
+#include "searchContext.h"
+
+namespace nav
+{
+  constexpr uint8_t flow_none = 4; // goal or unreachable
+
+  // Per tile direction (index into neighbour_offsets) and integration cost
+  // toward one goal, built by a single reverse Dijkstra.
+  struct FlowField
+  {
+    size_t width = 0;
+    size_t height = 0;
+    GridPos goal{-1, -1};
+    std::vector<float> cost;
+    std::vector<uint8_t> dir;
+    SearchContext ctx;
+
+    // tiles searched by the last build or update
+    size_t touched = 0;
+  };
+
+  inline GridPos flow_dir(const FlowField &ff, GridPos p)
+  {
+    if (p.x < 0 || p.y < 0 || p.x >= int(ff.width) || p.y >= int(ff.height))
+      return GridPos{0, 0};
+    const uint8_t dir = ff.dir[size_t(p.y) * ff.width + size_t(p.x)];
+    return dir == flow_none ? GridPos{0, 0} : neighbour_offsets[dir];
+  }
+
+  inline float flow_cost(const FlowField &ff, GridPos p)
+  {
+    if (p.x < 0 || p.y < 0 || p.x >= int(ff.width) || p.y >= int(ff.height))
+      return std::numeric_limits<float>::max();
+    return ff.cost[size_t(p.y) * ff.width + size_t(p.x)];
+  }
+
+  void build_flow_field(FlowField &ff, const GridView &grid, GridPos goal);
+  // Moves the goal reusing the old field: tiles for which going through the old
+  // goal stays optimal keep their direction and only get the extra cost, so a
+  // short goal move only searches the area that got closer. Falls back to a
+  // full build when there is nothing to reuse.
+  void update_flow_field(FlowField &ff, const GridView &grid, GridPos goal);
+};
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+
+namespace nav
+{
+  constexpr char wall_tile = '#';
+  constexpr char water_tile = 'o';
+
+  constexpr uint8_t impassable_cost = 0xff;
+
+  // entry cost of a tile character, new terrain goes here and nowhere else
+  constexpr uint8_t terrain_cost(char tile)
+  {
+    switch (tile)
+    {
+      case wall_tile: return impassable_cost;
+      case water_tile: return 10;
+      default: return 1;
+    }
+  }
+
+  constexpr size_t invalid_idx = size_t(-1);
+
+  struct GridPos
+  {
+    int x = 0;
+    int y = 0;
+  };
+
+  inline bool operator==(const GridPos &lhs, const GridPos &rhs) { return lhs.x == rhs.x && lhs.y == rhs.y; }
+  inline bool operator!=(const GridPos &lhs, const GridPos &rhs) { return !(lhs == rhs); }
+
+  // works with any of the week's int/float position types
+  template<typename T>
+  inline GridPos to_grid_pos(const T &p) { return GridPos{int(p.x), int(p.y)}; }
+
+  template<typename T>
+  inline std::vector<T> convert_path(const std::vector<GridPos> &path)
+  {
+    std::vector<T> res;
+    res.reserve(path.size());
+    for (const GridPos &p : path)
+      res.push_back(T{p.x, p.y});
+    return res;
+  }
+
+  inline float euclidean(GridPos lhs, GridPos rhs)
+  {
+    const float dx = float(lhs.x - rhs.x);
+    const float dy = float(lhs.y - rhs.y);
+    return sqrtf(dx * dx + dy * dy);
+  }
+
+  inline float manhattan(GridPos lhs, GridPos rhs)
+  {
+    return float(std::abs(lhs.x - rhs.x) + std::abs(lhs.y - rhs.y));
+  }
+
+  // char map view, the same layout DungeonData and the pathfinding demo use
+  struct GridView
+  {
+    const char *tiles = nullptr;
+    size_t width = 0;
+    size_t height = 0;
+
+    size_t size() const { return width * height; }
+    size_t idx(GridPos p) const { return size_t(p.y) * width + size_t(p.x); }
+    GridPos pos(size_t idx) const { return GridPos{int(idx % width), int(idx / width)}; }
+    bool in_bounds(GridPos p) const { return p.x >= 0 && p.y >= 0 && p.x < int(width) && p.y < int(height); }
+
+    bool passable(size_t idx) const { return terrain_cost(tiles[idx]) != impassable_cost; }
+    float cost(size_t idx) const { return float(terrain_cost(tiles[idx])); }
+  };
+
+  // half-open tile rectangle [min, max) the search is not allowed to leave
+  struct SearchLimits
+  {
+    GridPos min;
+    GridPos max;
+  };
+
+  template<typename Grid>
+  inline SearchLimits full_limits(const Grid &grid)
+  {
+    return SearchLimits{{0, 0}, {int(grid.width), int(grid.height)}};
+  }
+
+  inline bool in_limits(const SearchLimits &lim, GridPos p)
+  {
+    return p.x >= lim.min.x && p.y >= lim.min.y && p.x < lim.max.x && p.y < lim.max.y;
+  }
+
+  constexpr GridPos neighbour_offsets[4] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+};
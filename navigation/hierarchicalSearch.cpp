@@ -0,0 +1,249 @@
+#include "hierarchicalSearch.h"
+#include "aStar.h"
+#include "clearance.h"
+#include <algorithm>
+
+static float dist_to_rect(const nav::SearchLimits &rect, nav::GridPos p)
+{
+  const int dx = std::max(std::max(rect.min.x - p.x, p.x - (rect.max.x - 1)), 0);
+  const int dy = std::max(std::max(rect.min.y - p.y, p.y - (rect.max.y - 1)), 0);
+  return float(dx + dy);
+}
+
+static nav::SearchLimits portal_rect(const nav::PathPortal &portal)
+{
+  return nav::SearchLimits{{int(portal.startX), int(portal.startY)}, {int(portal.endX) + 1, int(portal.endY) + 1}};
+}
+
+// flood inside the cluster, g of every reachable tile is left in ctx
+template<typename Grid>
+static void flood_cluster(nav::SearchContext &ctx, const Grid &grid, const nav::SearchLimits &lim,
+                          nav::GridPos from)
+{
+  nav::begin_search(ctx, grid);
+  nav::add_start(ctx, grid.idx(from), 0.f, 0.f);
+  nav::run_a_star(ctx, grid, [](size_t) { return false; }, [](size_t) { return 0.f; }, lim);
+}
+
+// cheapest side tile of the portal the agent can cross from
+static float min_g_on_side(const nav::SearchContext &ctx, const nav::DungeonPortals &dp, size_t portal_idx,
+                           size_t cluster, uint8_t agent_size)
+{
+  const nav::PathPortal portal = nav::get_portal(dp, portal_idx);
+  const nav::SearchLimits side = nav::portal_side(dp, portal, cluster);
+  float res = std::numeric_limits<float>::max();
+  for (int y = side.min.y; y < side.max.y; ++y)
+    for (int x = side.min.x; x < side.max.x; ++x)
+      if (nav::crossing_clearance(dp, portal, cluster, nav::GridPos{x, y}) >= agent_size)
+        res = std::min(res, ctx.get_g(size_t(y) * dp.clearance.width + size_t(x)));
+  return res;
+}
+
+// floods the cluster from p, g of its tiles is left in ctx
+template<typename Grid>
+static std::vector<std::pair<size_t, float>> portal_links(nav::SearchContext &ctx, const Grid &grid,
+                                                          const nav::DungeonPortals &dp, size_t cluster,
+                                                          nav::GridPos p, uint8_t agent_size)
+{
+  std::vector<std::pair<size_t, float>> res;
+  flood_cluster(ctx, grid, nav::cluster_limits(dp, cluster), p);
+  for (uint32_t portalIdx : nav::cluster_portals(dp, cluster))
+  {
+    const float g = min_g_on_side(ctx, dp, portalIdx, cluster, agent_size);
+    if (g < std::numeric_limits<float>::max())
+      res.emplace_back(portalIdx, g);
+  }
+  return res;
+}
+
+std::vector<std::pair<size_t, float>> nav::cluster_portal_links(SearchContext &ctx, const GridView &grid,
+                                                                const DungeonPortals &dp, GridPos p)
+{
+  return portal_links(ctx, grid, dp, cluster_of(dp, p), p, 1);
+}
+
+template<typename Grid>
+static nav::HierarchicalPath abstract_path(nav::HierarchicalContext &ctx, const Grid &grid,
+                                           const nav::DungeonPortals &dp, nav::GridPos from, nav::GridPos to,
+                                           uint8_t agent_size)
+{
+  using namespace nav;
+  HierarchicalPath res;
+  res.from = from;
+  res.to = to;
+  res.cur = from;
+  res.agentSize = agent_size;
+  const size_t fromCluster = cluster_of(dp, from);
+  const size_t toCluster = cluster_of(dp, to);
+  if (fromCluster == invalid_idx || toCluster == invalid_idx ||
+      !grid.passable(grid.idx(from)) || !grid.passable(grid.idx(to)))
+    return res;
+  res.curCluster = fromCluster;
+
+  constexpr float noEdge = std::numeric_limits<float>::max();
+  const size_t numPortals = num_portals(dp);
+  // temporary links of the start and the goal
+  const std::vector<std::pair<size_t, float>> startLinks =
+    portal_links(ctx.tileCtx, grid, dp, fromCluster, from, agent_size);
+  const float directCost = fromCluster == toCluster ? ctx.tileCtx.get_g(grid.idx(to)) : noEdge;
+  const std::vector<std::pair<size_t, float>> goalLinks =
+    portal_links(ctx.tileCtx, grid, dp, toCluster, to, agent_size);
+
+  // abstract graph: portals, then start and goal nodes
+  const size_t startNode = numPortals;
+  const size_t goalNode = numPortals + 1;
+  SearchContext &pctx = ctx.portalCtx;
+  pctx.reset(numPortals + 2);
+  auto heuristic = [&](size_t node)
+  {
+    return node >= numPortals ? (node == startNode ? manhattan(from, to) : 0.f)
+                              : dist_to_rect(portal_rect(get_portal(dp, node)), to);
+  };
+  auto relax = [&](size_t node, size_t prev, float g)
+  {
+    if (!pctx.is_closed(node) && pctx.relax(node, prev, g))
+      pctx.push(node, g, g + heuristic(node));
+  };
+  add_start(pctx, startNode, 0.f, heuristic(startNode));
+  while (!pctx.open.empty())
+  {
+    const OpenNode cur = pctx.pop();
+    if (pctx.is_closed(cur.idx) || cur.g > pctx.g[cur.idx])
+      continue;
+    pctx.close(cur.idx);
+    if (cur.idx == goalNode)
+      break;
+    if (cur.idx == startNode)
+    {
+      for (const auto &link : startLinks)
+        relax(link.first, cur.idx, link.second);
+      if (directCost < noEdge)
+        relax(goalNode, cur.idx, directCost);
+      continue;
+    }
+    for (const PortalConnection &conn : portal_conns(dp, cur.idx))
+      if (conn.clearance >= agent_size)
+        relax(conn.connIdx, cur.idx, cur.g + conn.score);
+    for (const auto &link : goalLinks)
+      if (link.first == cur.idx)
+        relax(goalNode, cur.idx, cur.g + link.second);
+  }
+  if (!pctx.is_closed(goalNode))
+    return res;
+  res.found = true;
+  res.cost = pctx.g[goalNode];
+  for (uint32_t node = pctx.prev[goalNode]; node != startNode; node = pctx.prev[node])
+    res.portals.push_back(node);
+  std::reverse(res.portals.begin(), res.portals.end());
+  return res;
+}
+
+nav::HierarchicalPath nav::find_abstract_path(HierarchicalContext &ctx, const GridView &grid,
+                                              const DungeonPortals &dp, GridPos from, GridPos to,
+                                              uint8_t agent_size)
+{
+  if (agent_size > 1)
+    return abstract_path(ctx, clearance_grid(grid, dp.clearance, agent_size), dp, from, to, agent_size);
+  return abstract_path(ctx, grid, dp, from, to, agent_size);
+}
+
+// bounded search towards any tile of the target rect the agent fits on
+template<typename Grid, typename Fits>
+static bool refine_to_rect(nav::SearchContext &ctx, const Grid &grid, const nav::SearchLimits &cluster,
+                           nav::GridPos from, const nav::SearchLimits &target, Fits fits,
+                           std::vector<nav::GridPos> &out)
+{
+  nav::begin_search(ctx, grid);
+  nav::add_start(ctx, grid.idx(from), 0.f, dist_to_rect(target, from));
+  const size_t width = grid.width;
+  const size_t goal = nav::run_a_star(ctx, grid,
+    [&](size_t idx) { return nav::in_limits(target, grid.pos(idx)) && fits(grid.pos(idx)); },
+    [&](size_t idx) { return dist_to_rect(target, nav::GridPos{int(idx % width), int(idx / width)}); },
+    cluster);
+  if (goal == nav::invalid_idx)
+    return false;
+  const std::vector<nav::GridPos> segment = ctx.reconstruct_path(grid, goal);
+  out.insert(out.end(), segment.begin() + 1, segment.end());
+  return true;
+}
+
+static void cross_portal(const nav::DungeonPortals &dp, nav::HierarchicalPath &path, std::vector<nav::GridPos> &out)
+{
+  const nav::PathPortal portal = nav::get_portal(dp, path.prevPortal);
+  const nav::GridPos p = nav::portal_across(dp, portal, path.curCluster, path.cur);
+  path.cur = p;
+  path.curCluster = nav::portal_other_cluster(dp, portal, path.curCluster);
+  out.push_back(p);
+}
+
+template<typename Grid>
+static bool refine_segment(nav::HierarchicalContext &ctx, const Grid &grid, const nav::DungeonPortals &dp,
+                           nav::HierarchicalPath &path, std::vector<nav::GridPos> &out)
+{
+  using namespace nav;
+  if (!path.found || path.refined)
+    return false;
+  if (path.nextPortal < path.portals.size())
+  {
+    const size_t portalIdx = path.portals[path.nextPortal];
+    const PathPortal portal = get_portal(dp, portalIdx);
+    // portals are only crossed once the next one is not reachable from this side
+    const std::span<const uint32_t> curPortals = cluster_portals(dp, path.curCluster);
+    if (path.prevPortal != invalid_idx &&
+        std::find(curPortals.begin(), curPortals.end(), portalIdx) == curPortals.end())
+      cross_portal(dp, path, out);
+    const SearchLimits side = portal_side(dp, portal, path.curCluster);
+    const size_t cluster = path.curCluster;
+    const auto crossable = [&](GridPos p) { return crossing_clearance(dp, portal, cluster, p) >= path.agentSize; };
+    const size_t prevSize = out.size();
+    if (!refine_to_rect(ctx.tileCtx, grid, cluster_limits(dp, cluster), path.cur, side, crossable, out))
+      return false;
+    if (out.size() > prevSize)
+      path.cur = out.back();
+    path.prevPortal = portalIdx;
+    path.nextPortal++;
+    return true;
+  }
+  if (path.curCluster != cluster_of(dp, path.to))
+    cross_portal(dp, path, out);
+  path.refined = true;
+  if (path.cur == path.to)
+    return true;
+  const SearchLimits goalRect{path.to, GridPos{path.to.x + 1, path.to.y + 1}};
+  if (!refine_to_rect(ctx.tileCtx, grid, cluster_limits(dp, path.curCluster), path.cur, goalRect,
+                      [](GridPos) { return true; }, out))
+    return false;
+  path.cur = path.to;
+  return true;
+}
+
+bool nav::refine_next_segment(HierarchicalContext &ctx, const GridView &grid, const DungeonPortals &dp,
+                              HierarchicalPath &path, std::vector<GridPos> &out)
+{
+  if (path.agentSize > 1)
+    return refine_segment(ctx, clearance_grid(grid, dp.clearance, path.agentSize), dp, path, out);
+  return refine_segment(ctx, grid, dp, path, out);
+}
+
+std::vector<nav::GridPos> nav::find_path_hierarchical(HierarchicalContext &ctx, const GridView &grid,
+                                                      const DungeonPortals &dp, GridPos from, GridPos to,
+                                                      uint8_t agent_size)
+{
+  // plain A* over the same tiles the hierarchy would use
+  auto fallback = [&]()
+  {
+    if (agent_size > 1)
+      return find_path_a_star(ctx.tileCtx, clearance_grid(grid, dp.clearance, agent_size), from, to);
+    return find_path_a_star(ctx.tileCtx, grid, from, to);
+  };
+  if (cluster_of(dp, from) == invalid_idx || cluster_of(dp, to) == invalid_idx)
+    return fallback();
+  HierarchicalPath path = find_abstract_path(ctx, grid, dp, from, to, agent_size);
+  if (!path.found)
+    return std::vector<GridPos>();
+  std::vector<GridPos> res = {from};
+  while (!path.refined)
+    if (!refine_next_segment(ctx, grid, dp, path, res))
+      return fallback();
+  return res;
+}
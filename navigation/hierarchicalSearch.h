@@ -0,0 +1,54 @@
+#pragma once
+#include <utility>
+#include <vector>
+#include "gridTypes.h"
+#include "searchContext.h"
+#include "portalGraph.h"
+
+namespace nav
+{
+  struct HierarchicalContext
+  {
+    SearchContext tileCtx;
+    SearchContext portalCtx;
+  };
+
+  // Portals to pass through plus the refinement cursor. Segments are refined one
+  // cluster at a time, so a follower only pays for the part it is about to walk.
+  struct HierarchicalPath
+  {
+    GridPos from;
+    GridPos to;
+    std::vector<size_t> portals;
+    float cost = 0.f;
+    bool found = false;
+    uint8_t agentSize = 1; // side of the square agent, see clearance.h
+
+    GridPos cur;
+    size_t curCluster = invalid_idx;
+    size_t nextPortal = 0;
+    size_t prevPortal = invalid_idx;
+    bool refined = false;
+  };
+
+  // floods the cluster of p (single tile agent), cost from p to every portal of the cluster it reaches,
+  // g of the cluster tiles is left in ctx
+  std::vector<std::pair<size_t, float>> cluster_portal_links(SearchContext &ctx, const GridView &grid,
+                                                             const DungeonPortals &dp, GridPos p);
+
+  // Agents larger than one tile are anchored at their top left tile, only the
+  // connections and portal tiles wide enough for them are used. The tiles of a
+  // portal wide enough for an agent can be split by narrower ones, so the graph
+  // may promise a route refinement can't walk, the full query then falls back
+  // to A* over the clearance grid.
+  // links start and goal to the portals of their clusters and searches the portal graph
+  HierarchicalPath find_abstract_path(HierarchicalContext &ctx, const GridView &grid, const DungeonPortals &dp,
+                                      GridPos from, GridPos to, uint8_t agent_size = 1);
+  // appends the next segment (without its first tile) to out, false when nothing is left or refinement failed
+  bool refine_next_segment(HierarchicalContext &ctx, const GridView &grid, const DungeonPortals &dp,
+                           HierarchicalPath &path, std::vector<GridPos> &out);
+
+  std::vector<GridPos> find_path_hierarchical(HierarchicalContext &ctx, const GridView &grid,
+                                              const DungeonPortals &dp, GridPos from, GridPos to,
+                                              uint8_t agent_size = 1);
+};
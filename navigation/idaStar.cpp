@@ -0,0 +1,168 @@
+#include "idaStar.h"
+#include <algorithm>
+#include <limits>
+#include "landmarks.h"
+
+constexpr float not_found = std::numeric_limits<float>::max();
+
+enum class IdaResult
+{
+  Found,
+  NotFound,
+  OutOfBudget
+};
+
+static void reset_table(nav::IdaStarContext &ctx)
+{
+  size_t size = 1;
+  while (size < ctx.tableSize)
+    size <<= 1;
+  if (ctx.table.size() != size)
+  {
+    ctx.table.assign(size, nav::IdaTableEntry{0, 0, 0.f});
+    ctx.iteration = 0;
+  }
+}
+
+// returns true if the tile was already reached this iteration with g no worse
+static bool check_table(nav::IdaStarContext &ctx, size_t idx, float g)
+{
+  nav::IdaTableEntry &entry = ctx.table[idx & (ctx.table.size() - 1)];
+  if (entry.iteration == ctx.iteration && entry.idx == idx && entry.g <= g)
+    return true;
+  entry = nav::IdaTableEntry{uint32_t(idx), ctx.iteration, g};
+  return false;
+}
+
+static bool on_path(const nav::IdaStarContext &ctx, size_t idx)
+{
+  return (ctx.onPath[idx >> 6] >> (idx & 63)) & 1u;
+}
+
+static void set_on_path(nav::IdaStarContext &ctx, size_t idx, bool value)
+{
+  const uint64_t bit = uint64_t(1) << (idx & 63);
+  ctx.onPath[idx >> 6] = value ? ctx.onPath[idx >> 6] | bit : ctx.onPath[idx >> 6] & ~bit;
+}
+
+// one depth first pass limited by bound, on exhaustion min_f is the next bound
+template<typename Heuristic>
+static IdaResult ida_star_iteration(nav::IdaStarContext &ctx, const nav::GridView &grid, size_t fromIdx,
+                                    size_t toIdx, float bound, float &min_f, Heuristic heuristic)
+{
+  min_f = not_found;
+  ctx.iteration++;
+  if (ctx.iteration == 0) // wrapped around, old stamps could look current
+  {
+    std::fill(ctx.table.begin(), ctx.table.end(), nav::IdaTableEntry{0, 0, 0.f});
+    ctx.iteration = 1;
+  }
+  ctx.stack.clear();
+
+  // returns false if the tile is cut off by the bound or the table
+  auto enter = [&](size_t idx, float g) -> bool
+  {
+    const float f = g + heuristic(idx);
+    if (f > bound)
+    {
+      min_f = std::min(min_f, f);
+      return false;
+    }
+    if (check_table(ctx, idx, g))
+      return false;
+    nav::IdaFrame frame{uint32_t(idx), g, {}, 0, 0};
+    if (idx != toIdx)
+    {
+      ctx.expanded++;
+      float childF[4];
+      const nav::GridPos p = grid.pos(idx);
+      for (const nav::GridPos &offs : nav::neighbour_offsets)
+      {
+        const nav::GridPos np{p.x + offs.x, p.y + offs.y};
+        if (!grid.in_bounds(np))
+          continue;
+        const size_t nidx = grid.idx(np);
+        if (!grid.passable(nidx) || on_path(ctx, nidx))
+          continue;
+        // insertion sort by f, the most promising child goes first
+        const float nf = g + grid.cost(nidx) + heuristic(nidx);
+        uint8_t pos = frame.numChildren++;
+        for (; pos > 0 && childF[pos - 1] > nf; --pos)
+        {
+          childF[pos] = childF[pos - 1];
+          frame.children[pos] = frame.children[pos - 1];
+        }
+        childF[pos] = nf;
+        frame.children[pos] = uint32_t(nidx);
+      }
+    }
+    set_on_path(ctx, idx, true);
+    ctx.stack.push_back(frame);
+    return true;
+  };
+
+  enter(fromIdx, 0.f);
+  while (!ctx.stack.empty())
+  {
+    nav::IdaFrame &top = ctx.stack.back();
+    if (top.idx == toIdx)
+      return IdaResult::Found;
+    if (top.next == top.numChildren)
+    {
+      set_on_path(ctx, top.idx, false);
+      ctx.stack.pop_back();
+      continue;
+    }
+    if (ctx.budget && ctx.expanded >= ctx.budget)
+      return IdaResult::OutOfBudget;
+    const size_t child = top.children[top.next++];
+    enter(child, top.g + grid.cost(child));
+  }
+  return IdaResult::NotFound;
+}
+
+template<typename Heuristic>
+static std::vector<nav::GridPos> ida_star(nav::IdaStarContext &ctx, const nav::GridView &grid, nav::GridPos from,
+                                          nav::GridPos to, Heuristic heuristic)
+{
+  using namespace nav;
+  ctx.expanded = 0;
+  ctx.iterations = 0;
+  ctx.onPath.assign((grid.size() + 63) / 64, 0);
+  reset_table(ctx);
+  if (!grid.in_bounds(from) || !grid.in_bounds(to))
+    return std::vector<GridPos>();
+  const size_t fromIdx = grid.idx(from);
+  const size_t toIdx = grid.idx(to);
+  float bound = heuristic(fromIdx);
+  while (true)
+  {
+    ctx.iterations++;
+    float nextBound = not_found;
+    const IdaResult res = ida_star_iteration(ctx, grid, fromIdx, toIdx, bound, nextBound, heuristic);
+    if (res == IdaResult::Found)
+    {
+      std::vector<GridPos> path;
+      path.reserve(ctx.stack.size());
+      for (const IdaFrame &frame : ctx.stack)
+        path.push_back(grid.pos(frame.idx));
+      return path;
+    }
+    if (res == IdaResult::OutOfBudget || nextBound == not_found)
+      return std::vector<GridPos>();
+    bound = nextBound;
+  }
+}
+
+std::vector<nav::GridPos> nav::find_path_ida_star(IdaStarContext &ctx, const GridView &grid, GridPos from, GridPos to)
+{
+  return ida_star(ctx, grid, from, to, [&grid, to](size_t idx) { return manhattan(grid.pos(idx), to); });
+}
+
+std::vector<nav::GridPos> nav::find_path_ida_star(IdaStarContext &ctx, const GridView &grid,
+                                                  const LandmarkTable &landmarks, GridPos from, GridPos to)
+{
+  if (!can_use_landmarks(landmarks, grid, from, to))
+    return find_path_ida_star(ctx, grid, from, to);
+  return ida_star(ctx, grid, from, to, alt_to(landmarks, grid, to));
+}
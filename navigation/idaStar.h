@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "gridTypes.h"
+
+namespace nav
+{
+  struct LandmarkTable;
+
+  struct IdaTableEntry
+  {
+    uint32_t idx;
+    uint32_t iteration;
+    float g;
+  };
+
+  struct IdaFrame
+  {
+    uint32_t idx;
+    float g;
+    uint32_t children[4];
+    uint8_t numChildren;
+    uint8_t next;
+  };
+
+  struct IdaStarContext
+  {
+    size_t budget = 0; // max expansions per query, 0 - unlimited
+    size_t tableSize = size_t(1) << 16; // transposition table entries, power of two
+
+    // best g per tile within one iteration, slots are shared by tiles tableSize apart
+    std::vector<IdaTableEntry> table;
+    std::vector<uint64_t> onPath;
+    std::vector<IdaFrame> stack;
+    uint32_t iteration = 0;
+
+    // stats of the last query
+    size_t expanded = 0;
+    size_t iterations = 0;
+  };
+
+  // Iterative deepening A* with an explicit stack. Tiles reached again within
+  // an iteration with no better g are pruned, children are tried in f order.
+  // Uses manhattan distance: with euclidean the fractional f values make the
+  // bound creep up in tiny steps and the number of iterations explodes.
+  // Returns an empty path if the goal is unreachable or the budget ran out.
+  std::vector<GridPos> find_path_ida_star(IdaStarContext &ctx, const GridView &grid, GridPos from, GridPos to);
+  // ALT bounds are integral as well, so the bound still moves in whole steps
+  std::vector<GridPos> find_path_ida_star(IdaStarContext &ctx, const GridView &grid, const LandmarkTable &landmarks,
+                                          GridPos from, GridPos to);
+};
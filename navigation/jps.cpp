@@ -0,0 +1,293 @@
+#include "jps.h"
+#include "aStar.h"
+#include "landmarks.h"
+
+enum JumpDir
+{
+  JD_RIGHT = 0,
+  JD_LEFT,
+  JD_DOWN,
+  JD_UP,
+  JD_NUM
+};
+
+static bool is_free(const nav::GridView &grid, int x, int y)
+{
+  return x >= 0 && y >= 0 && x < int(grid.width) && y < int(grid.height) &&
+         grid.tiles[size_t(y) * grid.width + size_t(x)] != nav::wall_tile;
+}
+
+static int sign(int v)
+{
+  return v > 0 ? 1 : v < 0 ? -1 : 0;
+}
+
+static bool is_forced_vertical(const nav::GridView &grid, int x, int y, int dy)
+{
+  return (is_free(grid, x + 1, y) && !is_free(grid, x + 1, y - dy)) ||
+         (is_free(grid, x - 1, y) && !is_free(grid, x - 1, y - dy));
+}
+
+static size_t jump_vertical(const nav::GridView &grid, nav::GridPos p, int dy, nav::GridPos to)
+{
+  while (true)
+  {
+    p.y += dy;
+    if (!is_free(grid, p.x, p.y))
+      return nav::invalid_idx;
+    if (p == to || is_forced_vertical(grid, p.x, p.y, dy))
+      return grid.idx(p);
+  }
+}
+
+static size_t jump_horizontal(const nav::GridView &grid, nav::GridPos p, int dx, nav::GridPos to)
+{
+  while (true)
+  {
+    p.x += dx;
+    if (!is_free(grid, p.x, p.y))
+      return nav::invalid_idx;
+    if (p == to ||
+        jump_vertical(grid, p, 1, to) != nav::invalid_idx ||
+        jump_vertical(grid, p, -1, to) != nav::invalid_idx)
+      return grid.idx(p);
+  }
+}
+
+// straight runs between consecutive jump points are filled back in
+static std::vector<nav::GridPos> expand_jump_path(const std::vector<nav::GridPos> &jumps)
+{
+  std::vector<nav::GridPos> res;
+  if (jumps.empty())
+    return res;
+  res.push_back(jumps.front());
+  for (size_t i = 1; i < jumps.size(); ++i)
+  {
+    nav::GridPos p = jumps[i - 1];
+    const int dx = sign(jumps[i].x - p.x);
+    const int dy = sign(jumps[i].y - p.y);
+    while (p != jumps[i])
+    {
+      p.x += dx;
+      p.y += dy;
+      res.push_back(p);
+    }
+  }
+  return res;
+}
+
+// arrival direction decides which runs are canonical from this jump point
+template<typename Heuristic, typename Successors>
+static std::vector<nav::GridPos> run_jps(nav::SearchContext &ctx, const nav::GridView &grid,
+                                         nav::GridPos from, nav::GridPos to, Heuristic heuristic,
+                                         Successors successors)
+{
+  nav::begin_search(ctx, grid);
+  if (!grid.in_bounds(from) || !grid.in_bounds(to) || !grid.passable(grid.idx(from)))
+    return std::vector<nav::GridPos>();
+  const size_t toIdx = grid.idx(to);
+  nav::add_start(ctx, grid.idx(from), 0.f, heuristic(grid.idx(from)));
+  while (!ctx.open.empty())
+  {
+    const nav::OpenNode cur = ctx.pop();
+    if (ctx.is_closed(cur.idx) || cur.g > ctx.g[cur.idx])
+      continue;
+    ctx.close(cur.idx);
+    if (cur.idx == toIdx)
+      return expand_jump_path(ctx.reconstruct_path(grid, toIdx));
+    const nav::GridPos p = grid.pos(cur.idx);
+    int dx = 0;
+    int dy = 0;
+    if (ctx.prev[cur.idx] != nav::SearchContext::no_prev)
+    {
+      const nav::GridPos pp = grid.pos(ctx.prev[cur.idx]);
+      dx = sign(p.x - pp.x);
+      dy = sign(p.y - pp.y);
+    }
+    successors(p, dx, dy, [&](size_t nidx)
+    {
+      if (nidx == nav::invalid_idx || ctx.is_closed(nidx))
+        return;
+      const nav::GridPos np = grid.pos(nidx);
+      const float gScore = cur.g + nav::manhattan(p, np);
+      if (ctx.relax(nidx, cur.idx, gScore))
+        ctx.push(nidx, gScore, gScore + heuristic(nidx));
+    });
+  }
+  return std::vector<nav::GridPos>();
+}
+
+bool nav::has_uniform_cost(const GridView &grid)
+{
+  for (size_t idx = 0; idx < grid.size(); ++idx)
+    if (grid.passable(idx) && grid.cost(idx) != 1.f)
+      return false;
+  return true;
+}
+
+static auto manhattan_to(const nav::GridView &grid, nav::GridPos to, float weight)
+{
+  return [&grid, to, weight](size_t idx) { return weight * nav::manhattan(grid.pos(idx), to); };
+}
+
+template<typename Heuristic>
+static std::vector<nav::GridPos> jps(nav::SearchContext &ctx, const nav::GridView &grid, nav::GridPos from,
+                                     nav::GridPos to, Heuristic heuristic)
+{
+  using nav::GridPos;
+  return run_jps(ctx, grid, from, to, heuristic, [&](GridPos p, int dx, int dy, auto add)
+  {
+    if (dy == 0)
+    {
+      // start or horizontal arrival: every vertical run is natural
+      if (dx >= 0)
+        add(jump_horizontal(grid, p, 1, to));
+      if (dx <= 0)
+        add(jump_horizontal(grid, p, -1, to));
+      add(jump_vertical(grid, p, 1, to));
+      add(jump_vertical(grid, p, -1, to));
+      return;
+    }
+    add(jump_vertical(grid, p, dy, to));
+    for (int hx = -1; hx <= 1; hx += 2)
+      if (is_free(grid, p.x + hx, p.y) && !is_free(grid, p.x + hx, p.y - dy))
+        add(jump_horizontal(grid, p, hx, to));
+  });
+}
+
+std::vector<nav::GridPos> nav::find_path_jps(SearchContext &ctx, const GridView &grid, bool uniform_cost,
+                                             GridPos from, GridPos to, float weight)
+{
+  if (!uniform_cost)
+    return find_path_a_star(ctx, grid, from, to, weight);
+  return jps(ctx, grid, from, to, manhattan_to(grid, to, weight));
+}
+
+std::vector<nav::GridPos> nav::find_path_jps(SearchContext &ctx, const GridView &grid, bool uniform_cost,
+                                             GridPos from, GridPos to, const LandmarkTable &landmarks, float weight)
+{
+  if (!can_use_landmarks(landmarks, grid, from, to))
+    return find_path_jps(ctx, grid, uniform_cost, from, to, weight);
+  if (!uniform_cost)
+    return find_path_a_star(ctx, grid, from, to, landmarks, weight);
+  return jps(ctx, grid, from, to, alt_to(landmarks, grid, to, weight));
+}
+
+nav::JumpTable nav::build_jump_table(const GridView &grid)
+{
+  JumpTable table;
+  table.width = grid.width;
+  table.height = grid.height;
+  table.uniformCost = has_uniform_cost(grid);
+  table.dist.assign(grid.size() * JD_NUM, 0);
+  const int w = int(grid.width);
+  const int h = int(grid.height);
+  auto at = [&](int x, int y, int dir) -> int16_t & { return table.dist[(size_t(y) * grid.width + size_t(x)) * JD_NUM + size_t(dir)]; };
+  auto step = [](int16_t next_dist) { return int16_t(next_dist > 0 ? next_dist + 1 : next_dist - 1); };
+
+  // vertical runs first, horizontal jump points are defined through them
+  for (int x = 0; x < w; ++x)
+  {
+    for (int y = h - 1; y >= 0; --y)
+      at(x, y, JD_DOWN) = !is_free(grid, x, y + 1) ? int16_t(0) :
+                          is_forced_vertical(grid, x, y + 1, 1) ? int16_t(1) : step(at(x, y + 1, JD_DOWN));
+    for (int y = 0; y < h; ++y)
+      at(x, y, JD_UP) = !is_free(grid, x, y - 1) ? int16_t(0) :
+                        is_forced_vertical(grid, x, y - 1, -1) ? int16_t(1) : step(at(x, y - 1, JD_UP));
+  }
+  auto is_horizontal_jump = [&](int x, int y) { return at(x, y, JD_DOWN) > 0 || at(x, y, JD_UP) > 0; };
+  for (int y = 0; y < h; ++y)
+  {
+    for (int x = w - 1; x >= 0; --x)
+      at(x, y, JD_RIGHT) = !is_free(grid, x + 1, y) ? int16_t(0) :
+                           is_horizontal_jump(x + 1, y) ? int16_t(1) : step(at(x + 1, y, JD_RIGHT));
+    for (int x = 0; x < w; ++x)
+      at(x, y, JD_LEFT) = !is_free(grid, x - 1, y) ? int16_t(0) :
+                          is_horizontal_jump(x - 1, y) ? int16_t(1) : step(at(x - 1, y, JD_LEFT));
+  }
+  return table;
+}
+
+template<typename Heuristic>
+static std::vector<nav::GridPos> jps_plus(nav::SearchContext &ctx, const nav::GridView &grid,
+                                          const nav::JumpTable &table, nav::GridPos from, nav::GridPos to,
+                                          Heuristic heuristic)
+{
+  using nav::GridPos;
+  auto vertical = [&](GridPos p, int dy, auto add)
+  {
+    const int16_t d = table.at(grid.idx(p), dy > 0 ? JD_DOWN : JD_UP);
+    const int reach = d > 0 ? d : -d;
+    const int toGoal = (to.y - p.y) * dy;
+    if (to.x == p.x && toGoal > 0 && toGoal <= reach)
+      add(grid.idx(to));
+    else if (d > 0)
+      add(grid.idx(GridPos{p.x, p.y + d * dy}));
+  };
+  auto horizontal = [&](GridPos p, int dx, auto add)
+  {
+    const int16_t d = table.at(grid.idx(p), dx > 0 ? JD_RIGHT : JD_LEFT);
+    const int reach = d > 0 ? d : -d;
+    const int toGoal = (to.x - p.x) * dx;
+    if (to.y == p.y && toGoal > 0 && toGoal <= reach)
+    {
+      add(grid.idx(to));
+      return;
+    }
+    // the goal column is crossed before the run stops: the tile there is a jump
+    // point if a vertical run from it reaches the goal unobstructed
+    if (toGoal > 0 && (toGoal < reach || (d <= 0 && toGoal == reach)))
+    {
+      const GridPos m{to.x, p.y};
+      const int16_t dv = table.at(grid.idx(m), to.y > p.y ? JD_DOWN : JD_UP);
+      if (std::abs(to.y - p.y) <= (dv > 0 ? dv : -dv))
+      {
+        add(grid.idx(m));
+        return;
+      }
+    }
+    if (d > 0)
+      add(grid.idx(GridPos{p.x + d * dx, p.y}));
+  };
+  return run_jps(ctx, grid, from, to, heuristic, [&](GridPos p, int dx, int dy, auto add)
+  {
+    if (dy == 0)
+    {
+      if (dx >= 0)
+        horizontal(p, 1, add);
+      if (dx <= 0)
+        horizontal(p, -1, add);
+      vertical(p, 1, add);
+      vertical(p, -1, add);
+      return;
+    }
+    vertical(p, dy, add);
+    for (int hx = -1; hx <= 1; hx += 2)
+      if (is_free(grid, p.x + hx, p.y) && !is_free(grid, p.x + hx, p.y - dy))
+        horizontal(p, hx, add);
+  });
+}
+
+static bool jump_table_matches(const nav::JumpTable &table, const nav::GridView &grid)
+{
+  return table.uniformCost && table.width == grid.width && table.height == grid.height;
+}
+
+std::vector<nav::GridPos> nav::find_path_jps_plus(SearchContext &ctx, const GridView &grid, const JumpTable &table,
+                                                  GridPos from, GridPos to, float weight)
+{
+  if (!jump_table_matches(table, grid))
+    return find_path_a_star(ctx, grid, from, to, weight);
+  return jps_plus(ctx, grid, table, from, to, manhattan_to(grid, to, weight));
+}
+
+std::vector<nav::GridPos> nav::find_path_jps_plus(SearchContext &ctx, const GridView &grid, const JumpTable &table,
+                                                  const LandmarkTable &landmarks, GridPos from, GridPos to,
+                                                  float weight)
+{
+  if (!can_use_landmarks(landmarks, grid, from, to))
+    return find_path_jps_plus(ctx, grid, table, from, to, weight);
+  if (!jump_table_matches(table, grid))
+    return find_path_a_star(ctx, grid, from, to, landmarks, weight);
+  return jps_plus(ctx, grid, table, from, to, alt_to(landmarks, grid, to, weight));
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "gridTypes.h"
+#include "searchContext.h"
+
+namespace nav
+{
+  struct LandmarkTable;
+
+  // Jump point search for 4-connected grids. Canonical paths only turn from a
+  // vertical run into a horizontal one where that turn is forced by a wall, so
+  // vertical runs stop at forced tiles and horizontal runs stop where a vertical
+  // run would. Only valid for unit costs, costed grids fall back to A*. The
+  // caller passes has_uniform_cost() of the grid, kept from when it last
+  // changed, so a query does not scan the whole map.
+
+  // JPS+ tables: per tile and direction (neighbour_offsets order) a positive
+  // value is the distance to the next jump point, zero or negative is minus the
+  // number of free tiles before a wall.
+  struct JumpTable
+  {
+    size_t width = 0;
+    size_t height = 0;
+    bool uniformCost = true;
+    std::vector<int16_t> dist;
+
+    int16_t at(size_t idx, size_t dir) const { return dist[idx * 4 + dir]; }
+  };
+
+  bool has_uniform_cost(const GridView &grid);
+
+  JumpTable build_jump_table(const GridView &grid);
+
+  std::vector<GridPos> find_path_jps(SearchContext &ctx, const GridView &grid, bool uniform_cost, GridPos from,
+                                     GridPos to, float weight = 1.f);
+  std::vector<GridPos> find_path_jps(SearchContext &ctx, const GridView &grid, bool uniform_cost, GridPos from,
+                                     GridPos to, const LandmarkTable &landmarks, float weight = 1.f);
+  std::vector<GridPos> find_path_jps_plus(SearchContext &ctx, const GridView &grid, const JumpTable &table,
+                                          GridPos from, GridPos to, float weight = 1.f);
+  std::vector<GridPos> find_path_jps_plus(SearchContext &ctx, const GridView &grid, const JumpTable &table,
+                                          const LandmarkTable &landmarks, GridPos from, GridPos to,
+                                          float weight = 1.f);
+};
@@ -0,0 +1,160 @@
+#include "landmarks.h"
+#include <atomic>
+#include <thread>
+#include "aStar.h"
+#include "jps.h"
+
+using namespace nav;
+
+// tiles of the largest 4-connected component
+static std::vector<uint32_t> largest_component(const GridView &grid)
+{
+  std::vector<uint8_t> visited(grid.size(), 0);
+  std::vector<uint32_t> best;
+  std::vector<uint32_t> comp;
+  for (size_t start = 0; start < grid.size(); ++start)
+  {
+    if (visited[start] || !grid.passable(start))
+      continue;
+    comp.clear();
+    comp.push_back(uint32_t(start));
+    visited[start] = 1;
+    for (size_t i = 0; i < comp.size(); ++i)
+    {
+      const GridPos p = grid.pos(comp[i]);
+      for (const GridPos &offs : neighbour_offsets)
+      {
+        const GridPos np{p.x + offs.x, p.y + offs.y};
+        if (!grid.in_bounds(np))
+          continue;
+        const size_t nidx = grid.idx(np);
+        if (visited[nidx] || !grid.passable(nidx))
+          continue;
+        visited[nidx] = 1;
+        comp.push_back(uint32_t(nidx));
+      }
+    }
+    if (comp.size() > best.size())
+      best.swap(comp);
+  }
+  return best;
+}
+
+// lowers dist to the hop distance from src where that is closer
+static void bfs_min(const GridView &grid, uint32_t src, std::vector<uint32_t> &dist, std::vector<uint32_t> &queue)
+{
+  queue.clear();
+  queue.push_back(src);
+  dist[src] = 0;
+  for (size_t i = 0; i < queue.size(); ++i)
+  {
+    const uint32_t cur = queue[i];
+    const GridPos p = grid.pos(cur);
+    for (const GridPos &offs : neighbour_offsets)
+    {
+      const GridPos np{p.x + offs.x, p.y + offs.y};
+      if (!grid.in_bounds(np))
+        continue;
+      const size_t nidx = grid.idx(np);
+      if (!grid.passable(nidx) || dist[nidx] <= dist[cur] + 1)
+        continue;
+      dist[nidx] = dist[cur] + 1;
+      queue.push_back(uint32_t(nidx));
+    }
+  }
+}
+
+static uint32_t farthest_tile(const std::vector<uint32_t> &tiles, const std::vector<uint32_t> &dist)
+{
+  uint32_t res = tiles.front();
+  for (uint32_t idx : tiles)
+    if (dist[idx] > dist[res])
+      res = idx;
+  return res;
+}
+
+// farthest point selection: each landmark is the tile farthest in hops from
+// the ones already chosen, the first is the farthest from an arbitrary tile
+static std::vector<uint32_t> select_landmarks(const GridView &grid, const std::vector<uint32_t> &tiles, size_t count)
+{
+  std::vector<uint32_t> res;
+  if (tiles.empty() || count == 0)
+    return res;
+  std::vector<uint32_t> dist(grid.size(), uint32_t(-1));
+  std::vector<uint32_t> queue;
+  bfs_min(grid, tiles.front(), dist, queue);
+  uint32_t next = farthest_tile(tiles, dist);
+  std::fill(dist.begin(), dist.end(), uint32_t(-1));
+  while (res.size() < count && dist[next] != 0)
+  {
+    res.push_back(next);
+    bfs_min(grid, next, dist, queue);
+    next = farthest_tile(tiles, dist);
+  }
+  return res;
+}
+
+// reverse walks edges backwards, giving distances to the landmark instead of from it
+static void landmark_dijkstra(SearchContext &ctx, const GridView &grid, size_t landmark, bool reverse,
+                              uint16_t *out, size_t stride)
+{
+  begin_search(ctx, grid);
+  add_start(ctx, landmark, 0.f, 0.f);
+  while (!ctx.open.empty())
+  {
+    const OpenNode cur = ctx.pop();
+    if (ctx.is_closed(cur.idx) || cur.g > ctx.g[cur.idx])
+      continue;
+    ctx.close(cur.idx);
+    out[size_t(cur.idx) * stride] = uint16_t(std::min(cur.g, float(LandmarkTable::saturated)));
+    const GridPos p = grid.pos(cur.idx);
+    for (const GridPos &offs : neighbour_offsets)
+    {
+      const GridPos np{p.x + offs.x, p.y + offs.y};
+      if (!grid.in_bounds(np))
+        continue;
+      const size_t nidx = grid.idx(np);
+      if (!grid.passable(nidx) || ctx.is_closed(nidx))
+        continue;
+      const float gScore = cur.g + (reverse ? grid.cost(cur.idx) : grid.cost(nidx));
+      if (ctx.relax(nidx, cur.idx, gScore))
+        ctx.push(nidx, gScore, gScore);
+    }
+  }
+}
+
+LandmarkTable nav::build_landmarks(const GridView &grid, size_t count)
+{
+  LandmarkTable table;
+  table.width = grid.width;
+  table.height = grid.height;
+  table.landmarks = select_landmarks(grid, largest_component(grid), count);
+  const size_t n = table.count();
+  const bool symmetric = has_uniform_cost(grid);
+  table.fromDist.assign(grid.size() * n, LandmarkTable::unreachable);
+  if (!symmetric)
+    table.toDist.assign(grid.size() * n, LandmarkTable::unreachable);
+
+  // every landmark and direction is an independent job writing its own column
+  const size_t numJobs = symmetric ? n : n * 2;
+  std::atomic<size_t> nextJob = 0;
+  auto worker = [&]()
+  {
+    SearchContext ctx;
+    for (size_t job = nextJob++; job < numJobs; job = nextJob++)
+    {
+      const size_t l = job % n;
+      const bool reverse = job >= n;
+      uint16_t *column = (reverse ? table.toDist.data() : table.fromDist.data()) + l;
+      landmark_dijkstra(ctx, grid, table.landmarks[l], reverse, column, n);
+    }
+  };
+  const size_t numThreads = std::min(size_t(std::max(std::thread::hardware_concurrency(), 1u)), numJobs);
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < numThreads; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (std::thread &t : threads)
+    t.join();
+  return table;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "gridTypes.h"
+
+namespace nav
+{
+  // ALT preprocessing: exact distances to and from a few landmarks, the
+  // triangle inequality turns them into a lower bound between any two tiles.
+  // Tables are only valid for the map they were built on, rebuild on change.
+  struct LandmarkTable
+  {
+    // distances at or above this are not stored exactly, such tiles are skipped
+    static constexpr uint16_t saturated = 0xfffe;
+    static constexpr uint16_t unreachable = 0xffff;
+
+    size_t width = 0;
+    size_t height = 0;
+    std::vector<uint32_t> landmarks;
+    // tile-major, [idx * landmarks.size() + l], so one query touches one cache line
+    std::vector<uint16_t> fromDist; // landmark -> tile
+    std::vector<uint16_t> toDist; // tile -> landmark, empty if the costs are symmetric
+
+    size_t count() const { return landmarks.size(); }
+    const uint16_t *from_row(size_t idx) const { return fromDist.data() + idx * landmarks.size(); }
+    const uint16_t *to_row(size_t idx) const
+    {
+      return (toDist.empty() ? fromDist.data() : toDist.data()) + idx * landmarks.size();
+    }
+  };
+
+  // Landmarks are spread over the largest component by farthest point
+  // selection. One Dijkstra per landmark and direction, spread over threads.
+  LandmarkTable build_landmarks(const GridView &grid, size_t count = 16);
+
+  // lower bound on d(from, to) given the landmark rows of both tiles
+  inline float landmark_bound(const LandmarkTable &table, const uint16_t *from_f, const uint16_t *from_t,
+                              const uint16_t *to_f, const uint16_t *to_t)
+  {
+    int best = 0;
+    for (size_t l = 0, n = table.count(); l < n; ++l)
+    {
+      // d(L, to) - d(L, from) and d(from, L) - d(to, L)
+      if (from_f[l] < LandmarkTable::saturated && to_f[l] < LandmarkTable::saturated)
+        best = std::max(best, int(to_f[l]) - int(from_f[l]));
+      if (from_t[l] < LandmarkTable::saturated && to_t[l] < LandmarkTable::saturated)
+        best = std::max(best, int(from_t[l]) - int(to_t[l]));
+    }
+    return float(best);
+  }
+
+  // Heuristic toward `to` in the idx form run_a_star takes. Falls back to
+  // manhattan where the landmarks say less, which is admissible with unit
+  // or higher tile costs.
+  inline auto alt_to(const LandmarkTable &table, const GridView &grid, GridPos to, float weight = 1.f)
+  {
+    const size_t toIdx = grid.idx(to);
+    const uint16_t *toF = table.from_row(toIdx);
+    const uint16_t *toT = table.to_row(toIdx);
+    const size_t width = grid.width;
+    return [&table, toF, toT, width, to, weight](size_t idx)
+    {
+      const float h = landmark_bound(table, table.from_row(idx), table.to_row(idx), toF, toT);
+      return weight * std::max(h, manhattan(GridPos{int(idx % width), int(idx / width)}, to));
+    };
+  }
+
+  // lower bound on the distance from `from` to a tile, for backward searches
+  inline auto alt_from(const LandmarkTable &table, const GridView &grid, GridPos from)
+  {
+    const size_t fromIdx = grid.idx(from);
+    const uint16_t *fromF = table.from_row(fromIdx);
+    const uint16_t *fromT = table.to_row(fromIdx);
+    const size_t width = grid.width;
+    return [&table, fromF, fromT, width, from](size_t idx)
+    {
+      const float h = landmark_bound(table, fromF, fromT, table.from_row(idx), table.to_row(idx));
+      return std::max(h, manhattan(from, GridPos{int(idx % width), int(idx / width)}));
+    };
+  }
+
+  // the ALT overloads fall back to the plain search when this is false
+  inline bool can_use_landmarks(const LandmarkTable &table, const GridView &grid, GridPos from, GridPos to)
+  {
+    return table.count() > 0 && table.width == grid.width && table.height == grid.height &&
+           grid.in_bounds(from) && grid.in_bounds(to);
+  }
+};
@@ -0,0 +1,147 @@
+#include "navGrid.h"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace nav;
+
+NavGrid nav::build_nav_grid(const GridView &grid)
+{
+  NavGrid ng;
+  ng.width = grid.width;
+  ng.height = grid.height;
+  ng.rowWords = (grid.width + 2 + 63) / 64;
+  ng.bits.assign((grid.height + 2) * ng.rowWords, 0);
+  bool uniform = true;
+  for (size_t idx = 0; idx < grid.size(); ++idx)
+  {
+    const GridPos p = grid.pos(idx);
+    if (grid.passable(idx))
+    {
+      const size_t bit = size_t(p.x + 1);
+      ng.bits[size_t(p.y + 1) * ng.rowWords + (bit >> 6)] |= uint64_t(1) << (bit & 63);
+    }
+    uniform = uniform && grid.cost(idx) == 1.f;
+  }
+  if (!uniform)
+  {
+    ng.costs.resize(grid.size());
+    for (size_t idx = 0; idx < grid.size(); ++idx)
+      ng.costs[idx] = uint8_t(std::clamp(grid.cost(idx), 1.f, 255.f));
+  }
+  return ng;
+}
+
+void nav::set_nav_tile(NavGrid &ng, GridPos p, bool passable, uint8_t cost)
+{
+  if (!ng.in_bounds(p))
+    return;
+  const size_t bit = size_t(p.x + 1);
+  uint64_t &word = ng.bits[size_t(p.y + 1) * ng.rowWords + (bit >> 6)];
+  const uint64_t mask = uint64_t(1) << (bit & 63);
+  word = passable ? word | mask : word & ~mask;
+  if (cost != 1 && ng.costs.empty())
+    ng.costs.assign(ng.size(), 1);
+  if (!ng.costs.empty())
+    ng.costs[ng.idx(p)] = cost;
+}
+
+int nav::free_run(const NavGrid &ng, GridPos p, int dx)
+{
+  // the border is a wall, so both scans stop inside the padded row
+  int run = 0;
+  if (dx > 0)
+  {
+    for (int x = p.x + 1;; x += 64)
+    {
+      const int ones = std::countr_one(ng.row_bits(x, p.y));
+      run += ones;
+      if (ones < 64)
+        return run;
+    }
+  }
+  for (int x = p.x; x > -1;)
+  {
+    // tiles [start, x) packed at the top of the word
+    const int start = std::max(x - 64, -1);
+    const int n = x - start;
+    const uint64_t bits = ng.row_bits(start, p.y) << (64 - n);
+    const int ones = std::min(std::countl_one(bits), n);
+    run += ones;
+    if (ones < n)
+      return run;
+    x = start;
+  }
+  return run;
+}
+
+size_t nav::count_passable(const NavGrid &ng, int y, int x0, int x1)
+{
+  size_t res = 0;
+  for (int x = x0; x < x1; x += 64)
+  {
+    const int n = std::min(x1 - x, 64);
+    const uint64_t mask = n == 64 ? ~uint64_t(0) : (uint64_t(1) << n) - 1;
+    res += size_t(std::popcount(ng.row_bits(x, y) & mask));
+  }
+  return res;
+}
+
+bool nav::has_line_of_sight(const NavGrid &ng, GridPos from, GridPos to)
+{
+  if (!ng.in_bounds(from) || !ng.in_bounds(to))
+    return false;
+  GridPos cur = from;
+  while (cur != to)
+  {
+    if (!ng.passable_at(cur.x, cur.y))
+      return false;
+    const int dx = to.x - cur.x;
+    const int dy = to.y - cur.y;
+    if (std::abs(dx) > std::abs(dy))
+      cur.x += dx > 0 ? 1 : -1;
+    else
+      cur.y += dy > 0 ? 1 : -1;
+  }
+  return true;
+}
+
+bool nav::has_clear_line(const NavGrid &ng, GridPos from, GridPos to)
+{
+  if (!ng.in_bounds(from) || !ng.in_bounds(to))
+    return false;
+  const int dx = std::abs(to.x - from.x);
+  const int dy = std::abs(to.y - from.y);
+  const int sx = to.x > from.x ? 1 : -1;
+  const int sy = to.y > from.y ? 1 : -1;
+  if (dy == 0)
+    return ng.passable_at(from.x, from.y) && free_run(ng, from, sx) >= dx;
+  // supercover walk, err compares the crossings of the next vertical and horizontal tile edges
+  GridPos cur = from;
+  int err = dx - dy;
+  while (true)
+  {
+    if (!ng.passable_at(cur.x, cur.y))
+      return false;
+    if (cur == to)
+      return true;
+    if (err > 0)
+    {
+      cur.x += sx;
+      err -= 2 * dy;
+    }
+    else if (err < 0)
+    {
+      cur.y += sy;
+      err += 2 * dx;
+    }
+    else
+    {
+      // exactly through a corner
+      if (!ng.passable_at(cur.x + sx, cur.y) || !ng.passable_at(cur.x, cur.y + sy))
+        return false;
+      cur.x += sx;
+      cur.y += sy;
+      err += 2 * (dx - dy);
+    }
+  }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <vector>
+#include "gridTypes.h"
+
+namespace nav
+{
+  // Walkability packed one bit per tile with a one tile wall border, so
+  // neighbour reads never need a bounds check: any x in [-1, width] and y in
+  // [-1, height] is valid and the border reads as wall. Rows are padded to
+  // whole words, a 100x100 map is 1.6 KB. The cost layer is optional, empty
+  // means every tile costs 1.
+  struct NavGrid
+  {
+    size_t width = 0;
+    size_t height = 0;
+    size_t rowWords = 0;
+    std::vector<uint64_t> bits; // (height + 2) rows, tile (x, y) is bit x + 1 of row y + 1
+    std::vector<uint8_t> costs; // entry cost per tile, width * height or empty
+
+    size_t size() const { return width * height; }
+    size_t idx(GridPos p) const { return size_t(p.y) * width + size_t(p.x); }
+    GridPos pos(size_t idx) const { return GridPos{int(idx % width), int(idx / width)}; }
+    bool in_bounds(GridPos p) const { return p.x >= 0 && p.y >= 0 && p.x < int(width) && p.y < int(height); }
+
+    bool passable_at(int x, int y) const
+    {
+      const size_t bit = size_t(x + 1);
+      return (bits[size_t(y + 1) * rowWords + (bit >> 6)] >> (bit & 63)) & 1u;
+    }
+    // prefer passable_at when the coordinates are at hand, this one divides
+    bool passable(size_t idx) const { return passable_at(int(idx % width), int(idx / width)); }
+    float cost(size_t idx) const { return costs.empty() ? 1.f : float(costs[idx]); }
+
+    // 64 tiles of row y starting at x (x >= -1), bit i is tile x + i
+    uint64_t row_bits(int x, int y) const
+    {
+      const size_t bit = size_t(x + 1);
+      const uint64_t *row = bits.data() + size_t(y + 1) * rowWords;
+      const size_t word = bit >> 6;
+      const size_t shift = bit & 63;
+      const uint64_t lo = row[word] >> shift;
+      const uint64_t hi = shift == 0 || word + 1 >= rowWords ? 0 : row[word + 1] << (64 - shift);
+      return lo | hi;
+    }
+
+    // bit d is set if the tile at neighbour_offsets[d] is passable
+    uint8_t neighbour_mask(int x, int y) const
+    {
+      const uint64_t mid = row_bits(x - 1, y);
+      return uint8_t(((mid >> 2) & 1u) | (((mid >> 0) & 1u) << 1) |
+                     (uint64_t(passable_at(x, y + 1)) << 2) | (uint64_t(passable_at(x, y - 1)) << 3));
+    }
+  };
+
+  NavGrid build_nav_grid(const GridView &grid);
+  void set_nav_tile(NavGrid &ng, GridPos p, bool passable, uint8_t cost = 1);
+
+  // passable tiles after p in direction dx (+1 or -1) before the first wall, a word at a time
+  int free_run(const NavGrid &ng, GridPos p, int dx);
+  // number of passable tiles in [x0, x1) of row y
+  size_t count_passable(const NavGrid &ng, int y, int x0, int x1);
+
+  // steps along the axis with the larger remaining delta, as the dmaps did,
+  // the target tile itself is not tested
+  bool has_line_of_sight(const NavGrid &ng, GridPos from, GridPos to);
+  // Exact test for the segment between the tile centers, for any-angle movement:
+  // every tile the segment touches has to be passable and a segment through a
+  // tile corner needs both tiles beside the corner, so it never cuts a wall.
+  // Rows are checked a word at a time.
+  bool has_clear_line(const NavGrid &ng, GridPos from, GridPos to);
+};
@@ -0,0 +1,66 @@
+#include "pathCache.h"
+
+static void sync_version(nav::PathCache &cache, uint32_t version)
+{
+  if (cache.version != version)
+    nav::clear_path_cache(cache, version);
+}
+
+static void evict_last(nav::PathCache &cache)
+{
+  const nav::PathCache::EntryIt last = std::prev(cache.entries.end());
+  const nav::PathCacheKey &key = last->key;
+  auto erase_ref = [&](const nav::PathCacheKey &tileKey)
+  {
+    auto it = cache.tiles.find(tileKey);
+    // a newer path through the same tile may own the key by now
+    if (it != cache.tiles.end() && it->second.entry == last)
+      cache.tiles.erase(it);
+  };
+  erase_ref(key);
+  for (const nav::GridPos &p : last->path)
+    erase_ref(nav::PathCacheKey{p, key.to, key.layer});
+  cache.entries.pop_back();
+}
+
+void nav::clear_path_cache(PathCache &cache, uint32_t version)
+{
+  cache.tiles.clear();
+  cache.entries.clear();
+  cache.version = version;
+}
+
+bool nav::find_cached_path(PathCache &cache, uint32_t version, const PathCacheKey &key, std::vector<GridPos> &out)
+{
+  sync_version(cache, version);
+  auto it = cache.tiles.find(key);
+  if (it == cache.tiles.end())
+  {
+    cache.misses++;
+    return false;
+  }
+  const PathCache::TileRef &ref = it->second;
+  cache.entries.splice(cache.entries.begin(), cache.entries, ref.entry);
+  const std::vector<GridPos> &path = ref.entry->path;
+  out.assign(path.begin() + std::ptrdiff_t(std::min(ref.offset, path.size())), path.end());
+  if (ref.offset > 0)
+    cache.subpathHits++;
+  else
+    cache.hits++;
+  return true;
+}
+
+void nav::store_cached_path(PathCache &cache, uint32_t version, const PathCacheKey &key,
+                            const std::vector<GridPos> &path)
+{
+  sync_version(cache, version);
+  if (cache.capacity == 0)
+    return;
+  while (cache.entries.size() >= cache.capacity)
+    evict_last(cache);
+  cache.entries.push_front(PathCache::Entry{key, path});
+  const PathCache::EntryIt entry = cache.entries.begin();
+  cache.tiles[key] = PathCache::TileRef{entry, 0};
+  for (size_t i = 1; i < path.size(); ++i)
+    cache.tiles[PathCacheKey{path[i], key.to, key.layer}] = PathCache::TileRef{entry, i};
+}
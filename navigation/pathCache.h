@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include "gridTypes.h"
+
+namespace nav
+{
+  struct PathCacheKey
+  {
+    GridPos from;
+    GridPos to;
+    uint32_t layer; // cost model the path was searched with
+
+    bool operator==(const PathCacheKey &rhs) const
+    {
+      return from == rhs.from && to == rhs.to && layer == rhs.layer;
+    }
+  };
+
+  struct PathCacheKeyHash
+  {
+    size_t operator()(const PathCacheKey &key) const
+    {
+      const uint64_t ends = (uint64_t(uint16_t(key.from.x)) << 48) | (uint64_t(uint16_t(key.from.y)) << 32) |
+                            (uint64_t(uint16_t(key.to.x)) << 16) | uint64_t(uint16_t(key.to.y));
+      return std::hash<uint64_t>()(ends ^ (uint64_t(key.layer) * 0x9e3779b97f4a7c15ull));
+    }
+  };
+
+  // Bounded LRU of search results. Every tile of a cached path is indexed
+  // toward the same goal, so a query starting anywhere on it is answered with
+  // the suffix (a suffix of a shortest path is a shortest path). Unreachable
+  // pairs are cached as empty paths. All entries are dropped when the map
+  // version changes.
+  struct PathCache
+  {
+    struct Entry
+    {
+      PathCacheKey key;
+      std::vector<GridPos> path;
+    };
+    using EntryIt = std::list<Entry>::iterator;
+    struct TileRef
+    {
+      EntryIt entry;
+      size_t offset;
+    };
+
+    size_t capacity = 256; // paths
+    uint32_t version = 0;
+    std::list<Entry> entries; // most recently used first
+    std::unordered_map<PathCacheKey, TileRef, PathCacheKeyHash> tiles;
+
+    size_t hits = 0;
+    size_t subpathHits = 0;
+    size_t misses = 0;
+  };
+
+  void clear_path_cache(PathCache &cache, uint32_t version);
+  // false on a miss, out is only written on a hit
+  bool find_cached_path(PathCache &cache, uint32_t version, const PathCacheKey &key, std::vector<GridPos> &out);
+  void store_cached_path(PathCache &cache, uint32_t version, const PathCacheKey &key, const std::vector<GridPos> &path);
+
+  template<typename Search>
+  std::vector<GridPos> cached_path(PathCache &cache, uint32_t version, GridPos from, GridPos to, uint32_t layer,
+                                   Search search)
+  {
+    const PathCacheKey key{from, to, layer};
+    std::vector<GridPos> res;
+    if (find_cached_path(cache, version, key, res))
+      return res;
+    res = search(from, to);
+    store_cached_path(cache, version, key, res);
+    return res;
+  }
+};
@@ -0,0 +1,178 @@
+#include "pathDatabase.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <thread>
+#include "aStar.h"
+
+using namespace nav;
+
+constexpr uint8_t any_move = 0xf;
+
+// DFS preorder of the floor tiles, labelling components on the way
+static std::vector<uint32_t> order_targets(const GridView &grid, PathDatabase &db)
+{
+  db.rank.assign(grid.size(), PathDatabase::no_rank);
+  db.component.assign(grid.size(), PathDatabase::no_rank);
+  std::vector<uint32_t> order;
+  std::vector<uint32_t> stack;
+  uint32_t numComponents = 0;
+  for (size_t start = 0; start < grid.size(); ++start)
+  {
+    if (!grid.passable(start) || db.rank[start] != PathDatabase::no_rank)
+      continue;
+    stack.push_back(uint32_t(start));
+    while (!stack.empty())
+    {
+      const uint32_t cur = stack.back();
+      stack.pop_back();
+      if (db.rank[cur] != PathDatabase::no_rank)
+        continue;
+      db.rank[cur] = uint32_t(order.size());
+      db.component[cur] = numComponents;
+      order.push_back(cur);
+      const GridPos p = grid.pos(cur);
+      for (const GridPos &offs : neighbour_offsets)
+      {
+        const GridPos np{p.x + offs.x, p.y + offs.y};
+        if (grid.in_bounds(np) && grid.passable(grid.idx(np)) && db.rank[grid.idx(np)] == PathDatabase::no_rank)
+          stack.push_back(uint32_t(grid.idx(np)));
+      }
+    }
+    numComponents++;
+  }
+  return order;
+}
+
+// Dijkstra from source keeping the set of first moves of all shortest paths
+static void first_moves(SearchContext &ctx, const GridView &grid, size_t source, std::vector<uint8_t> &moves)
+{
+  begin_search(ctx, grid);
+  add_start(ctx, source, 0.f, 0.f);
+  while (!ctx.open.empty())
+  {
+    const OpenNode cur = ctx.pop();
+    if (ctx.is_closed(cur.idx) || cur.g > ctx.g[cur.idx])
+      continue;
+    ctx.close(cur.idx);
+    const GridPos p = grid.pos(cur.idx);
+    for (uint8_t dir = 0; dir < 4; ++dir)
+    {
+      const GridPos np{p.x + neighbour_offsets[dir].x, p.y + neighbour_offsets[dir].y};
+      if (!grid.in_bounds(np))
+        continue;
+      const size_t nidx = grid.idx(np);
+      if (!grid.passable(nidx) || ctx.is_closed(nidx))
+        continue;
+      const float gScore = cur.g + grid.cost(nidx);
+      const uint8_t via = cur.idx == source ? uint8_t(1u << dir) : moves[cur.idx];
+      if (ctx.relax(nidx, cur.idx, gScore))
+      {
+        moves[nidx] = via;
+        ctx.push(nidx, gScore, gScore);
+      }
+      else if (ctx.g[nidx] == gScore)
+        moves[nidx] |= via;
+    }
+  }
+}
+
+// greedy run-length encoding, a run continues while its targets share a move
+static void encode_row(const PathDatabase &db, const SearchContext &ctx, const std::vector<uint32_t> &order,
+                       size_t source, const std::vector<uint8_t> &moves, std::vector<uint32_t> &out)
+{
+  uint8_t runMoves = any_move;
+  uint32_t runStart = 0;
+  for (uint32_t r = 0; r < order.size(); ++r)
+  {
+    const uint32_t target = order[r];
+    // the source itself and other components are never asked, they fit any run
+    const bool wildcard = target == source || db.component[target] != db.component[source] || !ctx.is_seen(target);
+    const uint8_t m = wildcard ? any_move : moves[target];
+    if ((runMoves & m) != 0)
+    {
+      runMoves &= m;
+      continue;
+    }
+    out.push_back((runStart << 2) | uint32_t(std::countr_zero(runMoves)));
+    runStart = r;
+    runMoves = m;
+  }
+  out.push_back((runStart << 2) | uint32_t(std::countr_zero(runMoves)));
+}
+
+PathDatabase nav::build_path_database(const GridView &grid)
+{
+  PathDatabase db;
+  db.width = grid.width;
+  db.height = grid.height;
+  const std::vector<uint32_t> order = order_targets(grid, db);
+
+  // rows are independent, each worker encodes into its own buffers
+  std::vector<std::vector<uint32_t>> rows(order.size());
+  std::atomic<size_t> nextRow = 0;
+  auto worker = [&]()
+  {
+    SearchContext ctx;
+    std::vector<uint8_t> moves(grid.size(), 0);
+    for (size_t row = nextRow++; row < rows.size(); row = nextRow++)
+    {
+      first_moves(ctx, grid, order[row], moves);
+      encode_row(db, ctx, order, order[row], moves, rows[row]);
+      rows[row].shrink_to_fit();
+    }
+  };
+  const size_t numThreads = std::min(size_t(std::max(std::thread::hardware_concurrency(), 1u)), rows.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < numThreads; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (std::thread &t : threads)
+    t.join();
+
+  db.rowStart.assign(grid.size() + 1, 0);
+  size_t total = 0;
+  for (const std::vector<uint32_t> &row : rows)
+    total += row.size();
+  db.runs.reserve(total);
+  for (size_t idx = 0; idx < grid.size(); ++idx)
+  {
+    db.rowStart[idx] = uint32_t(db.runs.size());
+    if (db.rank[idx] != PathDatabase::no_rank)
+      db.runs.insert(db.runs.end(), rows[db.rank[idx]].begin(), rows[db.rank[idx]].end());
+  }
+  db.rowStart[grid.size()] = uint32_t(db.runs.size());
+  return db;
+}
+
+uint8_t nav::cpd_first_move(const PathDatabase &db, GridPos from, GridPos to)
+{
+  const auto inBounds = [&](GridPos p) { return p.x >= 0 && p.y >= 0 && p.x < int(db.width) && p.y < int(db.height); };
+  if (!inBounds(from) || !inBounds(to) || from == to)
+    return cpd_no_move;
+  const size_t fromIdx = size_t(from.y) * db.width + size_t(from.x);
+  const size_t toIdx = size_t(to.y) * db.width + size_t(to.x);
+  const uint32_t r = db.rank[toIdx];
+  if (db.rank[fromIdx] == PathDatabase::no_rank || r == PathDatabase::no_rank ||
+      db.component[fromIdx] != db.component[toIdx])
+    return cpd_no_move;
+  const auto first = db.runs.begin() + db.rowStart[fromIdx];
+  const auto last = db.runs.begin() + db.rowStart[fromIdx + 1];
+  // the last run starting at or before the target rank
+  const auto run = std::upper_bound(first, last, (r << 2) | 3u) - 1;
+  return uint8_t(*run & 3u);
+}
+
+std::vector<GridPos> nav::cpd_path(const PathDatabase &db, GridPos from, GridPos to)
+{
+  std::vector<GridPos> res{from};
+  for (GridPos cur = from; cur != to;)
+  {
+    const uint8_t move = cpd_first_move(db, cur, to);
+    if (move == cpd_no_move)
+      return std::vector<GridPos>();
+    cur = GridPos{cur.x + neighbour_offsets[move].x, cur.y + neighbour_offsets[move].y};
+    res.push_back(cur);
+  }
+  return res;
+}
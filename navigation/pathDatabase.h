@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "gridTypes.h"
+
+namespace nav
+{
+  constexpr uint8_t cpd_no_move = 4; // at the goal or unreachable
+
+  // Compressed path database: for every source tile the first move of a
+  // shortest path to every target, run-length encoded over the targets in
+  // DFS order (neighbouring targets tend to share the first move). Ties are
+  // kept as wildcards while encoding, so runs grow as long as possible.
+  // Only worth it on small maps, build is one Dijkstra per floor tile.
+  struct PathDatabase
+  {
+    static constexpr uint32_t no_rank = uint32_t(-1);
+
+    size_t width = 0;
+    size_t height = 0;
+    std::vector<uint32_t> rank; // position of the tile in target order, no_rank for walls
+    std::vector<uint32_t> component; // connected component of the tile
+    std::vector<uint32_t> rowStart; // per source tile into runs, size() + 1 entries
+    std::vector<uint32_t> runs; // (rank of the first target << 2) | move
+  };
+
+  PathDatabase build_path_database(const GridView &grid);
+
+  // index into neighbour_offsets or cpd_no_move, O(log runs in the row)
+  uint8_t cpd_first_move(const PathDatabase &db, GridPos from, GridPos to);
+  // walks the first moves, empty if there is no path
+  std::vector<GridPos> cpd_path(const PathDatabase &db, GridPos from, GridPos to);
+};
@@ -0,0 +1,258 @@
+#include "pathService.h"
+#include "aStar.h"
+#include "thetaStar.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace nav;
+using service_clock = std::chrono::steady_clock;
+
+// std heaps keep the largest element on top
+static bool job_less(const std::unique_ptr<PathJob> &lhs, const std::unique_ptr<PathJob> &rhs)
+{
+  return lhs->priority < rhs->priority || (lhs->priority == rhs->priority && lhs->order > rhs->order);
+}
+
+static void start_search(PathJob &job)
+{
+  const NavGrid &grid = *job.grid;
+  begin_search(*job.ctx, grid);
+  if (!grid.in_bounds(job.from) || !grid.in_bounds(job.to) || !grid.passable_at(job.from.x, job.from.y) ||
+      !grid.passable_at(job.to.x, job.to.y))
+    return;
+  add_start(*job.ctx, grid.idx(job.from), 0.f, euclidean(job.from, job.to));
+}
+
+// the run_a_star loop with a deadline, true once the search is over either way
+static bool run_slice(PathJob &job, service_clock::time_point deadline, std::vector<GridPos> &out)
+{
+  const NavGrid &grid = *job.grid;
+  SearchContext &ctx = *job.ctx;
+  if (!grid.in_bounds(job.to))
+    return true;
+  const size_t toIdx = grid.idx(job.to);
+  const size_t width = grid.width;
+  size_t steps = 0;
+  while (!ctx.open.empty())
+  {
+    if ((++steps & 63) == 0 && service_clock::now() >= deadline)
+      return false;
+    const OpenNode cur = ctx.pop();
+    if (ctx.is_closed(cur.idx) || cur.g > ctx.g[cur.idx])
+      continue;
+    ctx.close(cur.idx);
+    if (cur.idx == toIdx)
+    {
+      out = ctx.reconstruct_path(grid, toIdx);
+      if (job.stringPull)
+        out = string_pull(grid, out);
+      return true;
+    }
+    const GridPos p{int(cur.idx % width), int(cur.idx / width)};
+    for (const GridPos &offs : neighbour_offsets)
+    {
+      const GridPos np{p.x + offs.x, p.y + offs.y};
+      // the wall border keeps np inside the padded grid
+      if (!grid.passable_at(np.x, np.y))
+        continue;
+      const size_t nidx = size_t(np.y) * width + size_t(np.x);
+      if (ctx.is_closed(nidx))
+        continue;
+      const float gScore = cur.g + grid.cost(nidx);
+      if (ctx.relax(nidx, cur.idx, gScore))
+        ctx.push(nidx, gScore, gScore + euclidean(np, job.to));
+    }
+  }
+  return true;
+}
+
+// pops the most urgent live job, the lock has to be held
+static std::unique_ptr<PathJob> pop_job(PathService &service)
+{
+  while (!service.queue.empty())
+  {
+    std::pop_heap(service.queue.begin(), service.queue.end(), job_less);
+    std::unique_ptr<PathJob> job = std::move(service.queue.back());
+    service.queue.pop_back();
+    if (service.cancelled.erase(job->handle) == 0)
+      return job;
+    if (job->ctx)
+      service.freeContexts.push_back(std::move(job->ctx));
+  }
+  return nullptr;
+}
+
+// one slice of the job, the lock is released while searching
+static void process_job(PathService &service, std::unique_lock<std::mutex> &lock, std::unique_ptr<PathJob> job,
+                        size_t slice_us)
+{
+  if (!service.grid)
+  {
+    // nothing to search on yet
+    if (service.cancelled.erase(job->handle) == 0)
+      service.finished.push_back(PathResult{job->handle, {}, service.mapVersion});
+    return;
+  }
+  if (!job->ctx)
+  {
+    if (!service.freeContexts.empty())
+    {
+      job->ctx = std::move(service.freeContexts.back());
+      service.freeContexts.pop_back();
+    }
+    else
+      job->ctx = std::make_unique<SearchContext>();
+  }
+  const bool restart = job->grid != service.grid;
+  job->grid = service.grid;
+  const uint32_t version = service.mapVersion;
+  const service_clock::time_point deadline = service_clock::now() + std::chrono::microseconds(slice_us);
+  lock.unlock();
+  if (restart)
+    start_search(*job);
+  PathResult result{job->handle, {}, version};
+  const bool done = run_slice(*job, deadline, result.path);
+  lock.lock();
+  service.sliceCount++;
+  if (!done)
+  {
+    service.queue.push_back(std::move(job));
+    std::push_heap(service.queue.begin(), service.queue.end(), job_less);
+    return;
+  }
+  service.freeContexts.push_back(std::move(job->ctx));
+  if (service.cancelled.erase(result.handle) == 0)
+    service.finished.push_back(std::move(result));
+}
+
+static void worker_loop(PathService &service)
+{
+  std::unique_lock<std::mutex> lock(service.mutex);
+  while (true)
+  {
+    service.wake.wait(lock, [&]() { return service.stopping || !service.queue.empty(); });
+    if (service.stopping)
+      return;
+    std::unique_ptr<PathJob> job = pop_job(service);
+    if (job)
+      process_job(service, lock, std::move(job), service.sliceUs);
+  }
+}
+
+nav::PathService::~PathService()
+{
+  stop_path_service(*this);
+}
+
+void nav::start_path_service(PathService &service, size_t num_workers, size_t slice_us)
+{
+  stop_path_service(service);
+  service.sliceUs = slice_us;
+  service.stopping = false;
+  for (size_t i = 0; i < num_workers; ++i)
+    service.workers.emplace_back(worker_loop, std::ref(service));
+}
+
+void nav::stop_path_service(PathService &service)
+{
+  {
+    std::lock_guard<std::mutex> lock(service.mutex);
+    service.stopping = true;
+  }
+  service.wake.notify_all();
+  for (std::thread &t : service.workers)
+    t.join();
+  service.workers.clear();
+}
+
+void nav::set_path_service_map(PathService &service, const NavGrid &grid)
+{
+  std::shared_ptr<const NavGrid> copy = std::make_shared<const NavGrid>(grid);
+  std::lock_guard<std::mutex> lock(service.mutex);
+  service.grid = std::move(copy);
+  service.mapVersion++;
+}
+
+PathHandle nav::request_path(PathService &service, GridPos from, GridPos to, int priority, bool string_pull)
+{
+  const PathHandle handle = service.nextHandle++;
+  if (service.nextHandle == invalid_path_handle)
+    service.nextHandle++;
+  std::unique_ptr<PathJob> job = std::make_unique<PathJob>();
+  job->handle = handle;
+  job->priority = priority;
+  job->from = from;
+  job->to = to;
+  job->stringPull = string_pull;
+  service.pending.insert(handle);
+  {
+    std::lock_guard<std::mutex> lock(service.mutex);
+    job->order = service.nextOrder++;
+    service.queue.push_back(std::move(job));
+    std::push_heap(service.queue.begin(), service.queue.end(), job_less);
+  }
+  service.wake.notify_one();
+  return handle;
+}
+
+void nav::cancel_path(PathService &service, PathHandle handle)
+{
+  service.results.erase(handle);
+  if (service.pending.erase(handle) == 0)
+    return;
+  std::lock_guard<std::mutex> lock(service.mutex);
+  service.cancelled.insert(handle);
+}
+
+void nav::sync_path_service(PathService &service, size_t budget_us)
+{
+  std::unique_lock<std::mutex> lock(service.mutex);
+  if (service.workers.empty())
+  {
+    const service_clock::time_point deadline = service_clock::now() + std::chrono::microseconds(budget_us);
+    while (service_clock::now() < deadline)
+    {
+      std::unique_ptr<PathJob> job = pop_job(service);
+      if (!job)
+        break;
+      // a slice never outlives the frame budget
+      const auto left = std::chrono::duration_cast<std::chrono::microseconds>(deadline - service_clock::now());
+      process_job(service, lock, std::move(job), std::min(service.sliceUs, size_t(std::max<int64_t>(left.count(), 1))));
+    }
+  }
+  std::vector<PathResult> finished;
+  finished.swap(service.finished);
+  // requests cancelled after they finished
+  finished.erase(std::remove_if(finished.begin(), finished.end(),
+                                [&](const PathResult &result) { return service.cancelled.erase(result.handle) > 0; }),
+                 finished.end());
+  service.slices = service.sliceCount;
+  lock.unlock();
+  for (PathResult &result : finished)
+  {
+    if (service.pending.erase(result.handle) == 0)
+      continue;
+    service.completed++;
+    const PathHandle handle = result.handle;
+    service.results[handle] = std::move(result);
+  }
+}
+
+PathStatus nav::path_status(const PathService &service, PathHandle handle)
+{
+  const auto it = service.results.find(handle);
+  if (it != service.results.end())
+    return it->second.path.empty() ? PathStatus::NoPath : PathStatus::Found;
+  return service.pending.count(handle) ? PathStatus::Pending : PathStatus::Unknown;
+}
+
+PathStatus nav::take_path(PathService &service, PathHandle handle, std::vector<GridPos> &out)
+{
+  auto it = service.results.find(handle);
+  if (it == service.results.end())
+    return service.pending.count(handle) ? PathStatus::Pending : PathStatus::Unknown;
+  const PathStatus status = it->second.path.empty() ? PathStatus::NoPath : PathStatus::Found;
+  out = std::move(it->second.path);
+  service.results.erase(it);
+  return status;
+}
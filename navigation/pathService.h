@@ -0,0 +1,101 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "gridTypes.h"
+#include "navGrid.h"
+#include "searchContext.h"
+
+namespace nav
+{
+  using PathHandle = uint32_t;
+  constexpr PathHandle invalid_path_handle = 0;
+
+  enum class PathStatus : uint8_t
+  {
+    Unknown, // never requested, cancelled or already taken
+    Pending,
+    Found,
+    NoPath
+  };
+
+  struct PathJob
+  {
+    PathHandle handle = invalid_path_handle;
+    int priority = 0;
+    uint64_t order = 0; // submission order, older first among equal priorities
+    GridPos from;
+    GridPos to;
+    bool stringPull = false;
+    std::shared_ptr<const NavGrid> grid; // map the search was started on, null until the first slice
+    std::unique_ptr<SearchContext> ctx;
+  };
+
+  struct PathResult
+  {
+    PathHandle handle = invalid_path_handle;
+    std::vector<GridPos> path;
+    uint32_t mapVersion = 0;
+  };
+
+  // Path requests are queued by priority and searched by worker threads in
+  // slices of sliceUs. A search that runs out of its slice goes back to the
+  // queue with its open list, so a long query never holds a worker while more
+  // urgent ones wait. Finished paths are only handed to the game in
+  // sync_path_service, the main thread never waits for a search. Without
+  // workers the same slices run inside sync_path_service within its budget.
+  // Every search runs on an immutable map snapshot, a search that resumes after
+  // the map changed starts over on the new one.
+  struct PathService
+  {
+    size_t sliceUs = 1000;
+
+    // shared with the workers
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::unique_ptr<PathJob>> queue; // heap on priority
+    std::vector<std::unique_ptr<SearchContext>> freeContexts;
+    std::vector<PathResult> finished;
+    std::unordered_set<PathHandle> cancelled;
+    std::shared_ptr<const NavGrid> grid;
+    uint32_t mapVersion = 0;
+    uint64_t nextOrder = 0;
+    size_t sliceCount = 0;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    // main thread only
+    PathHandle nextHandle = 1;
+    std::unordered_set<PathHandle> pending;
+    std::unordered_map<PathHandle, PathResult> results;
+
+    // stats, updated by sync_path_service
+    size_t slices = 0; // search slices run so far
+    size_t completed = 0;
+
+    ~PathService();
+  };
+
+  // num_workers == 0 runs every search inside sync_path_service
+  void start_path_service(PathService &service, size_t num_workers, size_t slice_us = 1000);
+  void stop_path_service(PathService &service);
+  // copies the map, searches in flight restart on the copy
+  void set_path_service_map(PathService &service, const NavGrid &grid);
+
+  // higher priority is searched first, string_pull turns the tile path into waypoints
+  PathHandle request_path(PathService &service, GridPos from, GridPos to, int priority = 0,
+                          bool string_pull = false);
+  void cancel_path(PathService &service, PathHandle handle);
+
+  // The fixed sync point: publishes the paths finished since the last call.
+  // Without workers it also searches for up to budget_us.
+  void sync_path_service(PathService &service, size_t budget_us);
+  PathStatus path_status(const PathService &service, PathHandle handle);
+  // moves a finished path out and forgets the handle, Pending leaves out untouched
+  PathStatus take_path(PathService &service, PathHandle handle, std::vector<GridPos> &out);
+};
@@ -0,0 +1,637 @@
+#include "portalGraph.h"
+#include "aStar.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <tuple>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+constexpr uint32_t no_portal = uint32_t(-1);
+
+// scans the top (dir 1,0 offs 0,-1) or left (dir 0,1 offs -1,0) border of a super tile
+static void check_border(const nav::GridView &grid, size_t splitTiles,
+                         size_t xx, size_t yy,
+                         size_t dir_x, size_t dir_y,
+                         int offs_x, int offs_y,
+                         std::vector<nav::PathPortal> &portals)
+{
+  int spanFrom = -1;
+  int spanTo = -1;
+  // the last cluster of a row or column is cut by the map edge
+  const size_t len = std::min(splitTiles, dir_x ? grid.width - xx * splitTiles : grid.height - yy * splitTiles);
+  auto write_span = [&]()
+  {
+    portals.push_back({uint32_t(int(xx * splitTiles + size_t(spanFrom) * dir_x) + offs_x),
+                       uint32_t(int(yy * splitTiles + size_t(spanFrom) * dir_y) + offs_y),
+                       uint32_t(xx * splitTiles + size_t(spanTo) * dir_x),
+                       uint32_t(yy * splitTiles + size_t(spanTo) * dir_y)});
+  };
+  for (size_t i = 0; i < len; ++i)
+  {
+    size_t x = xx * splitTiles + i * dir_x;
+    size_t y = yy * splitTiles + i * dir_y;
+    size_t nx = size_t(int(x) + offs_x);
+    size_t ny = size_t(int(y) + offs_y);
+    if (grid.tiles[y * grid.width + x] != nav::wall_tile &&
+        grid.tiles[ny * grid.width + nx] != nav::wall_tile)
+    {
+      if (spanFrom < 0)
+        spanFrom = int(i);
+      spanTo = int(i);
+    }
+    else if (spanFrom >= 0)
+    {
+      write_span();
+      spanFrom = -1;
+    }
+  }
+  if (spanFrom >= 0)
+    write_span();
+}
+
+// adjacency the graph is built and repaired in, packed into the flat arrays afterwards
+struct PortalLists
+{
+  std::vector<nav::PathPortal> portals;
+  std::vector<std::vector<nav::PortalConnection>> conns;
+  std::vector<std::vector<uint32_t>> clusterPortals;
+
+  uint32_t add(const nav::PathPortal &portal, size_t cluster, size_t neighbour)
+  {
+    const uint32_t idx = uint32_t(portals.size());
+    portals.push_back(portal);
+    conns.emplace_back();
+    clusterPortals[cluster].push_back(idx);
+    clusterPortals[neighbour].push_back(idx);
+    return idx;
+  }
+
+  void link(const nav::ClusterLink &link)
+  {
+    conns[link.from].push_back({link.to, link.score, link.cluster, link.clearance});
+    conns[link.to].push_back({link.from, link.score, link.cluster, link.clearance});
+  }
+};
+
+template<typename T>
+static void pack_rows(const std::vector<std::vector<T>> &rows, std::vector<uint32_t> &start, std::vector<T> &flat)
+{
+  start.resize(rows.size() + 1);
+  start[0] = 0;
+  for (size_t i = 0; i < rows.size(); ++i)
+    start[i + 1] = start[i] + uint32_t(rows[i].size());
+  flat.clear();
+  flat.reserve(start.back());
+  for (const std::vector<T> &row : rows)
+    flat.insert(flat.end(), row.begin(), row.end());
+}
+
+static void pack_portals(const PortalLists &lists, nav::DungeonPortals &dp)
+{
+  const size_t numPortals = lists.portals.size();
+  dp.startX.resize(numPortals);
+  dp.startY.resize(numPortals);
+  dp.endX.resize(numPortals);
+  dp.endY.resize(numPortals);
+  for (size_t i = 0; i < numPortals; ++i)
+  {
+    dp.startX[i] = lists.portals[i].startX;
+    dp.startY[i] = lists.portals[i].startY;
+    dp.endX[i] = lists.portals[i].endX;
+    dp.endY[i] = lists.portals[i].endY;
+  }
+  pack_rows(lists.conns, dp.connStart, dp.conns);
+  pack_rows(lists.clusterPortals, dp.clusterStart, dp.clusterPortals);
+}
+
+static PortalLists unpack_portals(const nav::DungeonPortals &dp)
+{
+  PortalLists res;
+  for (size_t i = 0; i < nav::num_portals(dp); ++i)
+  {
+    res.portals.push_back(nav::get_portal(dp, i));
+    const std::span<const nav::PortalConnection> conns = nav::portal_conns(dp, i);
+    res.conns.emplace_back(conns.begin(), conns.end());
+  }
+  for (size_t cluster = 0; cluster + 1 < dp.clusterStart.size(); ++cluster)
+  {
+    const std::span<const uint32_t> portals = nav::cluster_portals(dp, cluster);
+    res.clusterPortals.emplace_back(portals.begin(), portals.end());
+  }
+  return res;
+}
+
+static uint8_t portal_clearance(const nav::DungeonPortals &dp, const nav::PathPortal &portal)
+{
+  const size_t cluster = nav::cluster_of(dp, nav::GridPos{int(portal.startX), int(portal.startY)});
+  const nav::SearchLimits side = nav::portal_side(dp, portal, cluster);
+  uint8_t res = 0;
+  for (int y = side.min.y; y < side.max.y; ++y)
+    for (int x = side.min.x; x < side.max.x; ++x)
+      res = std::max(res, nav::crossing_clearance(dp, portal, cluster, nav::GridPos{x, y}));
+  return res;
+}
+
+// widest agent able to get from the portal to each tile of the cluster, flooded level by level from the widest
+static void widest_flood(const nav::DungeonPortals &dp, const nav::PathPortal &portal, size_t cluster,
+                         std::vector<uint8_t> &widest)
+{
+  const nav::ClearanceMap &cm = dp.clearance;
+  const nav::SearchLimits lim = nav::cluster_limits(dp, cluster);
+  const size_t clusterWidth = size_t(lim.max.x - lim.min.x);
+  const auto local = [&](nav::GridPos p) { return size_t(p.y - lim.min.y) * clusterWidth + size_t(p.x - lim.min.x); };
+  widest.assign(clusterWidth * size_t(lim.max.y - lim.min.y), 0);
+  std::vector<nav::GridPos> levels[nav::max_clearance + 1];
+  const nav::SearchLimits side = nav::portal_side(dp, portal, cluster);
+  for (int y = side.min.y; y < side.max.y; ++y)
+    for (int x = side.min.x; x < side.max.x; ++x)
+    {
+      const uint8_t w = nav::crossing_clearance(dp, portal, cluster, nav::GridPos{x, y});
+      widest[local(nav::GridPos{x, y})] = w;
+      levels[w].push_back(nav::GridPos{x, y});
+    }
+  for (size_t level = nav::max_clearance; level > 0; --level)
+    while (!levels[level].empty())
+    {
+      const nav::GridPos p = levels[level].back();
+      levels[level].pop_back();
+      if (widest[local(p)] != level)
+        continue;
+      for (const nav::GridPos &offs : nav::neighbour_offsets)
+      {
+        const nav::GridPos np{p.x + offs.x, p.y + offs.y};
+        if (!nav::in_limits(lim, np))
+          continue;
+        const uint8_t w = std::min(uint8_t(level), cm.clearance[size_t(np.y) * cm.width + size_t(np.x)]);
+        if (w > widest[local(np)])
+        {
+          widest[local(np)] = w;
+          levels[w].push_back(np);
+        }
+      }
+    }
+}
+
+void nav::connect_cluster_portals(SearchContext &ctx, const GridView &grid, const DungeonPortals &dp,
+                                  size_t cluster, std::vector<ClusterLink> &links)
+{
+  // costed tiles make floods direction dependent, a positional order keeps
+  // links identical no matter in which order portals were (re)created
+  const std::span<const uint32_t> portals = cluster_portals(dp, cluster);
+  std::vector<uint32_t> indices(portals.begin(), portals.end());
+  std::sort(indices.begin(), indices.end(), [&](uint32_t lhs, uint32_t rhs)
+  {
+    return std::tie(dp.startY[lhs], dp.startX[lhs], dp.endY[lhs], dp.endX[lhs]) <
+           std::tie(dp.startY[rhs], dp.startX[rhs], dp.endY[rhs], dp.endX[rhs]);
+  });
+  const SearchLimits lim = cluster_limits(dp, cluster);
+  const size_t clusterWidth = size_t(lim.max.x - lim.min.x);
+  std::vector<uint8_t> widest;
+  links.clear();
+  for (size_t i = 0; i + 1 < indices.size(); ++i)
+  {
+    widest_flood(dp, get_portal(dp, indices[i]), cluster, widest);
+    // one multi-source flood from the whole portal gives distances to all the others
+    const SearchLimits fromSide = portal_side(dp, get_portal(dp, indices[i]), cluster);
+    begin_search(ctx, grid);
+    for (int y = fromSide.min.y; y < fromSide.max.y; ++y)
+      for (int x = fromSide.min.x; x < fromSide.max.x; ++x)
+        add_start(ctx, grid.idx(GridPos{x, y}), 0.f, 0.f);
+    run_a_star(ctx, grid, [](size_t) { return false; }, [](size_t) { return 0.f; }, lim);
+    for (size_t j = i + 1; j < indices.size(); ++j)
+    {
+      const PathPortal to = get_portal(dp, indices[j]);
+      const SearchLimits toSide = portal_side(dp, to, cluster);
+      float minDist = std::numeric_limits<float>::max();
+      uint8_t clearance = 0;
+      for (int y = toSide.min.y; y < toSide.max.y; ++y)
+        for (int x = toSide.min.x; x < toSide.max.x; ++x)
+        {
+          const GridPos p{x, y};
+          minDist = std::min(minDist, ctx.get_g(grid.idx(p)));
+          const size_t local = size_t(y - lim.min.y) * clusterWidth + size_t(x - lim.min.x);
+          clearance = std::max(clearance, std::min(widest[local],
+                                                   crossing_clearance(dp, to, cluster, p)));
+        }
+      if (minDist == std::numeric_limits<float>::max())
+        continue;
+      // score counts tiles on the path, not steps
+      links.push_back({indices[i], indices[j], minDist + 1.f, uint32_t(cluster), clearance});
+    }
+  }
+}
+
+nav::DungeonPortals nav::build_portals(const GridView &grid, size_t split_tiles)
+{
+  const size_t splitTiles = split_tiles;
+  // go through each super tile, the ones on the right and bottom edges may be smaller
+  const size_t width = (grid.width + splitTiles - 1) / splitTiles;
+  const size_t height = (grid.height + splitTiles - 1) / splitTiles;
+
+  PortalLists lists;
+  lists.clusterPortals.resize(width * height);
+  std::vector<PathPortal> borderPortals;
+  for (size_t y = 0; y < height; ++y)
+    for (size_t x = 0; x < width; ++x)
+    {
+      // check top
+      if (y > 0)
+      {
+        borderPortals.clear();
+        check_border(grid, splitTiles, x, y, 1, 0, 0, -1, borderPortals);
+        for (const PathPortal &portal : borderPortals)
+          lists.add(portal, y * width + x, (y - 1) * width + x);
+      }
+      // left
+      if (x > 0)
+      {
+        borderPortals.clear();
+        check_border(grid, splitTiles, x, y, 0, 1, -1, 0, borderPortals);
+        for (const PathPortal &portal : borderPortals)
+          lists.add(portal, y * width + x, y * width + x - 1);
+      }
+    }
+  DungeonPortals res;
+  res.tileSplit = splitTiles;
+  res.numClustersX = width;
+  res.numClustersY = height;
+  res.clearance = build_clearance(grid);
+  pack_portals(lists, res);
+  res.portalClearance.resize(num_portals(res));
+  for (size_t i = 0; i < num_portals(res); ++i)
+    res.portalClearance[i] = portal_clearance(res, get_portal(res, i));
+  // clusters are independent, each worker floods its own clusters and the
+  // links are merged afterwards in cluster order so the result is deterministic
+  std::vector<std::vector<ClusterLink>> clusterLinks(width * height);
+  std::atomic<size_t> nextCluster = 0;
+  auto worker = [&]()
+  {
+    SearchContext ctx;
+    for (size_t cluster = nextCluster++; cluster < clusterLinks.size(); cluster = nextCluster++)
+      connect_cluster_portals(ctx, grid, res, cluster, clusterLinks[cluster]);
+  };
+  const size_t numThreads = std::min(size_t(std::max(std::thread::hardware_concurrency(), 1u)), clusterLinks.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < numThreads; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (std::thread &t : threads)
+    t.join();
+  for (const std::vector<ClusterLink> &links : clusterLinks)
+    for (const ClusterLink &link : links)
+      lists.link(link);
+  pack_rows(lists.conns, res.connStart, res.conns);
+  return res;
+}
+
+void nav::update_portals(SearchContext &ctx, DungeonPortals &dp, const GridView &grid,
+                         const std::vector<GridPos> &changed)
+{
+  const size_t ts = dp.tileSplit;
+  const size_t nx = dp.numClustersX;
+  const size_t ny = dp.numClustersY;
+  const size_t numClusters = nx * ny;
+  // borders are keyed like in the build: bottom/right cluster * 2 + (0 - top, 1 - left)
+  std::vector<bool> dirtyBorder(numClusters * 2, false);
+  std::vector<bool> dirtyCluster(numClusters, false);
+  update_clearance(dp.clearance, grid, changed);
+  for (const GridPos &p : changed)
+  {
+    // clearance changed up and left of the tile, links there may widen or narrow,
+    // one more tile around since links also read the tiles across their borders
+    constexpr int reach = int(max_clearance);
+    if (p.x >= 0 && p.y >= 0 && numClusters > 0)
+      for (size_t cy = size_t(std::max(p.y - reach, 0)) / ts; cy <= std::min(size_t(p.y + 1) / ts, ny - 1); ++cy)
+        for (size_t cx = size_t(std::max(p.x - reach, 0)) / ts; cx <= std::min(size_t(p.x + 1) / ts, nx - 1); ++cx)
+          dirtyCluster[cy * nx + cx] = true;
+    const size_t cluster = cluster_of(dp, p);
+    if (cluster == invalid_idx)
+      continue;
+    dirtyCluster[cluster] = true;
+    const size_t cx = cluster % nx;
+    const size_t cy = cluster / nx;
+    const size_t lx = size_t(p.x) % ts;
+    const size_t ly = size_t(p.y) % ts;
+    if (ly == 0 && cy > 0)
+      dirtyBorder[cluster * 2 + 0] = true;
+    if (ly == ts - 1 && cy + 1 < ny)
+      dirtyBorder[(cluster + nx) * 2 + 0] = true;
+    if (lx == 0 && cx > 0)
+      dirtyBorder[cluster * 2 + 1] = true;
+    if (lx == ts - 1 && cx + 1 < nx)
+      dirtyBorder[(cluster + 1) * 2 + 1] = true;
+  }
+
+  // drop portals of dirty borders and rescan them
+  PortalLists lists = unpack_portals(dp);
+  std::vector<bool> removed(lists.portals.size(), false);
+  std::vector<PathPortal> newPortals;
+  for (size_t border = 0; border < dirtyBorder.size(); ++border)
+  {
+    if (!dirtyBorder[border])
+      continue;
+    const size_t cluster = border / 2;
+    const bool left = border % 2 == 1;
+    const size_t neighbour = left ? cluster - 1 : cluster - nx;
+    // neighbours of a changed border get new portal indices, so their links are rebuilt too
+    dirtyCluster[cluster] = true;
+    dirtyCluster[neighbour] = true;
+    for (uint32_t portalIdx : cluster_portals(dp, cluster))
+      if (portal_other_cluster(dp, get_portal(dp, portalIdx), cluster) == neighbour)
+        removed[portalIdx] = true;
+    newPortals.clear();
+    if (left)
+      check_border(grid, ts, cluster % nx, cluster / nx, 0, 1, -1, 0, newPortals);
+    else
+      check_border(grid, ts, cluster % nx, cluster / nx, 1, 0, 0, -1, newPortals);
+    for (const PathPortal &portal : newPortals)
+    {
+      lists.add(portal, cluster, neighbour);
+      removed.push_back(false);
+    }
+  }
+
+  // compact portal indices in place
+  std::vector<uint32_t> remap(lists.portals.size(), no_portal);
+  uint32_t numAlive = 0;
+  for (size_t i = 0; i < lists.portals.size(); ++i)
+  {
+    if (removed[i])
+      continue;
+    remap[i] = numAlive;
+    if (i != numAlive)
+    {
+      lists.portals[numAlive] = lists.portals[i];
+      lists.conns[numAlive] = std::move(lists.conns[i]);
+    }
+    numAlive++;
+  }
+  lists.portals.resize(numAlive);
+  lists.conns.resize(numAlive);
+  for (std::vector<uint32_t> &indices : lists.clusterPortals)
+  {
+    indices.erase(std::remove_if(indices.begin(), indices.end(), [&](uint32_t idx) { return removed[idx]; }),
+                  indices.end());
+    for (uint32_t &idx : indices)
+      idx = remap[idx];
+  }
+  for (std::vector<PortalConnection> &conns : lists.conns)
+  {
+    conns.erase(std::remove_if(conns.begin(), conns.end(), [&](const PortalConnection &conn)
+    {
+      return removed[conn.connIdx] || dirtyCluster[conn.cluster];
+    }), conns.end());
+    for (PortalConnection &conn : conns)
+      conn.connIdx = remap[conn.connIdx];
+  }
+
+  // the floods read portals from the graph itself, so it is packed before relinking and once more after
+  pack_portals(lists, dp);
+  dp.portalClearance.resize(num_portals(dp));
+  for (size_t i = 0; i < num_portals(dp); ++i)
+    dp.portalClearance[i] = portal_clearance(dp, get_portal(dp, i));
+  std::vector<ClusterLink> links;
+  for (size_t cluster = 0; cluster < numClusters; ++cluster)
+  {
+    if (!dirtyCluster[cluster])
+      continue;
+    connect_cluster_portals(ctx, grid, dp, cluster, links);
+    for (const ClusterLink &link : links)
+      lists.link(link);
+  }
+  pack_rows(lists.conns, dp.connStart, dp.conns);
+}
+
+constexpr uint32_t portals_file_magic = 0x5054504e; // "NPTP"
+constexpr uint32_t portals_file_version = 2;
+
+struct PortalsFileHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint64_t width;
+  uint64_t height;
+  uint64_t tileSplit;
+  uint64_t numClustersX;
+  uint64_t numClustersY;
+  uint64_t tilesHash;
+};
+
+// FNV-1a over the tiles
+static uint64_t tiles_hash(const nav::GridView &grid)
+{
+  uint64_t res = 14695981039346656037ull;
+  for (size_t i = 0; i < grid.size(); ++i)
+    res = (res ^ uint64_t(uint8_t(grid.tiles[i]))) * 1099511628211ull;
+  return res;
+}
+
+template<typename T>
+static void write_array(FILE *f, const std::vector<T> &v)
+{
+  const uint64_t count = v.size();
+  fwrite(&count, sizeof(count), 1, f);
+  fwrite(v.data(), sizeof(T), v.size(), f);
+}
+
+// field by field, PortalConnection has padding that would put stray bytes in the file
+constexpr size_t portal_connection_bytes = 3 * sizeof(uint32_t) + sizeof(uint8_t);
+
+static void write_connections(FILE *f, const std::vector<nav::PortalConnection> &conns)
+{
+  const uint64_t count = conns.size();
+  fwrite(&count, sizeof(count), 1, f);
+  for (const nav::PortalConnection &conn : conns)
+  {
+    fwrite(&conn.connIdx, sizeof(conn.connIdx), 1, f);
+    fwrite(&conn.score, sizeof(conn.score), 1, f);
+    fwrite(&conn.cluster, sizeof(conn.cluster), 1, f);
+    fwrite(&conn.clearance, sizeof(conn.clearance), 1, f);
+  }
+}
+
+// sequential reader over the mapped file, fails once anything runs past the end
+struct FileCursor
+{
+  const uint8_t *cur;
+  const uint8_t *end;
+
+  bool read(void *dst, size_t bytes)
+  {
+    if (size_t(end - cur) < bytes)
+      return false;
+    memcpy(dst, cur, bytes);
+    cur += bytes;
+    return true;
+  }
+
+  template<typename T>
+  bool read_array(std::vector<T> &v)
+  {
+    uint64_t count = 0;
+    if (!read(&count, sizeof(count)) || count > size_t(end - cur) / sizeof(T))
+      return false;
+    v.resize(count);
+    return read(v.data(), count * sizeof(T));
+  }
+
+  bool read_connections(std::vector<nav::PortalConnection> &conns)
+  {
+    uint64_t count = 0;
+    if (!read(&count, sizeof(count)) || count > size_t(end - cur) / portal_connection_bytes)
+      return false;
+    conns.resize(count);
+    for (nav::PortalConnection &conn : conns)
+    {
+      read(&conn.connIdx, sizeof(conn.connIdx));
+      read(&conn.score, sizeof(conn.score));
+      read(&conn.cluster, sizeof(conn.cluster));
+      read(&conn.clearance, sizeof(conn.clearance));
+    }
+    return true;
+  }
+};
+
+bool nav::save_portals(const DungeonPortals &dp, const GridView &grid, const char *path)
+{
+  FILE *f = fopen(path, "wb");
+  if (!f)
+    return false;
+  const PortalsFileHeader header{portals_file_magic, portals_file_version, grid.width, grid.height,
+                                 dp.tileSplit, dp.numClustersX, dp.numClustersY, tiles_hash(grid)};
+  fwrite(&header, sizeof(header), 1, f);
+  write_array(f, dp.startX);
+  write_array(f, dp.startY);
+  write_array(f, dp.endX);
+  write_array(f, dp.endY);
+  write_array(f, dp.portalClearance);
+  write_array(f, dp.connStart);
+  write_connections(f, dp.conns);
+  write_array(f, dp.clusterStart);
+  write_array(f, dp.clusterPortals);
+  write_array(f, dp.clearance.clearance);
+  const bool ok = !ferror(f);
+  return fclose(f) == 0 && ok;
+}
+
+static bool read_portals(FileCursor &file, nav::DungeonPortals &dp, const nav::GridView &grid, size_t split_tiles)
+{
+  PortalsFileHeader header;
+  if (!file.read(&header, sizeof(header)) || header.magic != portals_file_magic ||
+      header.version != portals_file_version || header.width != grid.width || header.height != grid.height ||
+      header.tileSplit != split_tiles || header.tilesHash != tiles_hash(grid))
+    return false;
+  dp.tileSplit = header.tileSplit;
+  dp.numClustersX = header.numClustersX;
+  dp.numClustersY = header.numClustersY;
+  dp.clearance.width = grid.width;
+  dp.clearance.height = grid.height;
+  const bool ok = file.read_array(dp.startX) && file.read_array(dp.startY) && file.read_array(dp.endX) &&
+                  file.read_array(dp.endY) && file.read_array(dp.portalClearance) &&
+                  file.read_array(dp.connStart) && file.read_connections(dp.conns) && file.read_array(dp.clusterStart) &&
+                  file.read_array(dp.clusterPortals) && file.read_array(dp.clearance.clearance);
+  // sizes the accessors rely on
+  return ok && dp.connStart.size() == nav::num_portals(dp) + 1 && dp.connStart.back() == dp.conns.size() &&
+         dp.clusterStart.size() == dp.numClustersX * dp.numClustersY + 1 &&
+         dp.clusterStart.back() == dp.clusterPortals.size() && dp.clearance.clearance.size() == grid.size();
+}
+
+bool nav::load_portals(DungeonPortals &dp, const GridView &grid, size_t split_tiles, const char *path)
+{
+  DungeonPortals res;
+  bool ok = false;
+#if defined(_WIN32)
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return false;
+  std::vector<uint8_t> data;
+  uint8_t buf[1 << 16];
+  for (size_t n = fread(buf, 1, sizeof(buf), f); n > 0; n = fread(buf, 1, sizeof(buf), f))
+    data.insert(data.end(), buf, buf + n);
+  fclose(f);
+  FileCursor file{data.data(), data.data() + data.size()};
+  ok = read_portals(file, res, grid, split_tiles);
+#else
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0)
+  {
+    void *data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED)
+    {
+      const uint8_t *bytes = static_cast<const uint8_t *>(data);
+      FileCursor file{bytes, bytes + st.st_size};
+      ok = read_portals(file, res, grid, split_tiles);
+      munmap(data, size_t(st.st_size));
+    }
+  }
+  close(fd);
+#endif
+  if (ok)
+    dp = std::move(res);
+  return ok;
+}
+
+size_t nav::cluster_of(const DungeonPortals &dp, GridPos p)
+{
+  if (p.x < 0 || p.y < 0 || p.x >= int(dp.clearance.width) || p.y >= int(dp.clearance.height))
+    return invalid_idx;
+  const size_t cx = size_t(p.x) / dp.tileSplit;
+  const size_t cy = size_t(p.y) / dp.tileSplit;
+  if (cx >= dp.numClustersX || cy >= dp.numClustersY)
+    return invalid_idx;
+  return cy * dp.numClustersX + cx;
+}
+
+nav::SearchLimits nav::cluster_limits(const DungeonPortals &dp, size_t cluster)
+{
+  const int cx = int(cluster % dp.numClustersX);
+  const int cy = int(cluster / dp.numClustersX);
+  const int ts = int(dp.tileSplit);
+  // clusters on the right and bottom edges are cut by the map
+  return SearchLimits{{cx * ts, cy * ts},
+                      {std::min((cx + 1) * ts, int(dp.clearance.width)),
+                       std::min((cy + 1) * ts, int(dp.clearance.height))}};
+}
+
+nav::SearchLimits nav::portal_side(const DungeonPortals &dp, const PathPortal &portal, size_t cluster)
+{
+  const SearchLimits lim = cluster_limits(dp, cluster);
+  return SearchLimits{{std::max(int(portal.startX), lim.min.x), std::max(int(portal.startY), lim.min.y)},
+                      {std::min(int(portal.endX) + 1, lim.max.x), std::min(int(portal.endY) + 1, lim.max.y)}};
+}
+
+size_t nav::portal_other_cluster(const DungeonPortals &dp, const PathPortal &portal, size_t cluster)
+{
+  const size_t first = cluster_of(dp, GridPos{int(portal.startX), int(portal.startY)});
+  return first == cluster ? cluster_of(dp, GridPos{int(portal.endX), int(portal.endY)}) : first;
+}
+
+nav::GridPos nav::portal_across(const DungeonPortals &dp, const PathPortal &portal, size_t cluster, GridPos p)
+{
+  const size_t other = portal_other_cluster(dp, portal, cluster);
+  const SearchLimits side = portal_side(dp, portal, other);
+  // the other side is the adjacent row/column, keep the coordinate along the border
+  if (other / dp.numClustersX == cluster / dp.numClustersX)
+    p.x = side.min.x;
+  else
+    p.y = side.min.y;
+  return p;
+}
+
+uint8_t nav::crossing_clearance(const DungeonPortals &dp, const PathPortal &portal, size_t cluster, GridPos p)
+{
+  const ClearanceMap &cm = dp.clearance;
+  const GridPos across = portal_across(dp, portal, cluster, p);
+  return std::min(cm.clearance[size_t(p.y) * cm.width + size_t(p.x)],
+                  cm.clearance[size_t(across.y) * cm.width + size_t(across.x)]);
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "gridTypes.h"
+#include "searchContext.h"
+#include "clearance.h"
+
+namespace nav
+{
+  struct PortalConnection
+  {
+    uint32_t connIdx;
+    float score;
+    uint32_t cluster; // the connection runs inside this cluster
+    uint8_t clearance; // largest agent that can walk it, score is still the one of a single tile agent
+  };
+
+  // spans both sides of a cluster border: start is on the top/left cluster, end on the bottom/right one
+  struct PathPortal
+  {
+    uint32_t startX, startY;
+    uint32_t endX, endY;
+  };
+
+  // Compressed sparse rows: connections of portal i are conns[connStart[i], connStart[i + 1]),
+  // portals of cluster c are clusterPortals[clusterStart[c], clusterStart[c + 1]). Extents are
+  // kept per coordinate, so the whole graph is a dozen flat arrays instead of a heap block per portal.
+  struct DungeonPortals
+  {
+    size_t tileSplit = 0;
+    size_t numClustersX = 0;
+    size_t numClustersY = 0;
+    std::vector<uint32_t> startX, startY;
+    std::vector<uint32_t> endX, endY;
+    std::vector<uint8_t> portalClearance; // largest agent that can step across
+    std::vector<uint32_t> connStart;
+    std::vector<PortalConnection> conns;
+    std::vector<uint32_t> clusterStart;
+    std::vector<uint32_t> clusterPortals;
+    ClearanceMap clearance; // kept in sync by update_portals
+  };
+
+  inline size_t num_portals(const DungeonPortals &dp) { return dp.startX.size(); }
+  inline PathPortal get_portal(const DungeonPortals &dp, size_t idx)
+  {
+    return PathPortal{dp.startX[idx], dp.startY[idx], dp.endX[idx], dp.endY[idx]};
+  }
+  inline std::span<const PortalConnection> portal_conns(const DungeonPortals &dp, size_t idx)
+  {
+    return std::span<const PortalConnection>(dp.conns.data() + dp.connStart[idx],
+                                             dp.connStart[idx + 1] - dp.connStart[idx]);
+  }
+  inline std::span<const uint32_t> cluster_portals(const DungeonPortals &dp, size_t cluster)
+  {
+    return std::span<const uint32_t>(dp.clusterPortals.data() + dp.clusterStart[cluster],
+                                     dp.clusterStart[cluster + 1] - dp.clusterStart[cluster]);
+  }
+
+  struct ClusterLink
+  {
+    uint32_t from;
+    uint32_t to;
+    float score;
+    uint32_t cluster;
+    uint8_t clearance;
+  };
+
+  // portals are found serially, intra-cluster connections are built on all cores
+  DungeonPortals build_portals(const GridView &grid, size_t split_tiles);
+  void connect_cluster_portals(SearchContext &ctx, const GridView &grid, const DungeonPortals &dp,
+                               size_t cluster, std::vector<ClusterLink> &links);
+
+  // Repairs the graph after the given tiles changed: only borders touching them
+  // get new portals, only their clusters get new links. Portal indices are compacted.
+  void update_portals(SearchContext &ctx, DungeonPortals &dp, const GridView &grid,
+                      const std::vector<GridPos> &changed);
+
+  // Raw dump of the arrays after a small header, connections field by field so
+  // the same graph always gives the same bytes. The map size, cluster split and
+  // a hash of the tiles have to match on load, otherwise the graph is stale.
+  bool save_portals(const DungeonPortals &dp, const GridView &grid, const char *path);
+  // maps the file and copies the arrays out of it, false if it is missing or stale
+  bool load_portals(DungeonPortals &dp, const GridView &grid, size_t split_tiles, const char *path);
+
+  // invalid_idx for tiles outside of the map
+  size_t cluster_of(const DungeonPortals &dp, GridPos p);
+  SearchLimits cluster_limits(const DungeonPortals &dp, size_t cluster);
+  // part of the portal lying inside the cluster (one row or column of tiles)
+  SearchLimits portal_side(const DungeonPortals &dp, const PathPortal &portal, size_t cluster);
+  size_t portal_other_cluster(const DungeonPortals &dp, const PathPortal &portal, size_t cluster);
+  // tile next to p on the other side of the border, p is on the portal side in cluster
+  GridPos portal_across(const DungeonPortals &dp, const PathPortal &portal, size_t cluster, GridPos p);
+  // widest agent that can step across the portal from its side tile p in cluster
+  uint8_t crossing_clearance(const DungeonPortals &dp, const PathPortal &portal, size_t cluster, GridPos p);
+};
@@ -0,0 +1,373 @@
+#include "portalHierarchy.h"
+#include "aStar.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+using namespace nav;
+
+constexpr float no_edge = std::numeric_limits<float>::max();
+constexpr uint32_t via_cluster_mask = (1u << 24) - 1;
+
+static uint32_t encode_via(size_t level, size_t cluster) { return uint32_t(level << 24) | uint32_t(cluster); }
+
+// cluster of the portal's start (side 0) or end (side 1) tile in DungeonPortals
+static size_t side_cluster(const DungeonPortals &dp, const PathPortal &portal, size_t side)
+{
+  return side == 0 ? cluster_of(dp, GridPos{int(portal.startX), int(portal.startY)})
+                   : cluster_of(dp, GridPos{int(portal.endX), int(portal.endY)});
+}
+
+static size_t ancestor(const PortalHierarchy &ph, size_t level, size_t base_cluster)
+{
+  const PortalLevel &base = ph.levels[0];
+  const PortalLevel &lv = ph.levels[level];
+  const size_t cx = base_cluster % base.numClustersX / lv.span;
+  const size_t cy = base_cluster / base.numClustersX / lv.span;
+  return cy * lv.numClustersX + cx;
+}
+
+// row of the matrix of the cluster
+static const float *matrix_row(const PortalLevel &lv, size_t cluster, uint32_t row)
+{
+  const size_t n = lv.entryStart[cluster + 1] - lv.entryStart[cluster];
+  return lv.distances.data() + lv.matrixStart[cluster] + row * n;
+}
+
+// relaxes the entries of the cluster from the portal at the given row
+template<typename Relax>
+static void relax_row(const PortalLevel &lv, size_t cluster, uint32_t row, float g, Relax relax)
+{
+  const float *dist = matrix_row(lv, cluster, row);
+  const uint32_t first = lv.entryStart[cluster];
+  for (uint32_t i = first; i < lv.entryStart[cluster + 1]; ++i)
+    if (dist[i - first] < no_edge)
+      relax(lv.entries[i], g + dist[i - first]);
+}
+
+static SearchLimits level_limits(const DungeonPortals &dp, const PortalHierarchy &ph, size_t level, size_t cluster)
+{
+  const PortalLevel &lv = ph.levels[level];
+  const int side = int(lv.span * dp.tileSplit);
+  const int cx = int(cluster % lv.numClustersX);
+  const int cy = int(cluster / lv.numClustersX);
+  return SearchLimits{{cx * side, cy * side},
+                      {std::min((cx + 1) * side, int(dp.clearance.width)),
+                       std::min((cy + 1) * side, int(dp.clearance.height))}};
+}
+
+// tiles of the portal inside the cluster of the level
+static SearchLimits level_side(const DungeonPortals &dp, const PortalHierarchy &ph, size_t level, uint32_t portal,
+                               size_t cluster)
+{
+  const PathPortal pp = get_portal(dp, portal);
+  const size_t base = side_cluster(dp, pp, 0);
+  return portal_side(dp, pp, ancestor(ph, level, base) == cluster ? base : side_cluster(dp, pp, 1));
+}
+
+// multi-source flood from the portal side, g of the cluster tiles is left in ctx
+static void flood_from_side(SearchContext &ctx, const GridView &grid, const SearchLimits &lim,
+                            const SearchLimits &side)
+{
+  begin_search(ctx, grid);
+  for (int y = side.min.y; y < side.max.y; ++y)
+    for (int x = side.min.x; x < side.max.x; ++x)
+      add_start(ctx, grid.idx(GridPos{x, y}), 0.f, 0.f);
+  run_a_star(ctx, grid, [](size_t) { return false; }, [](size_t) { return 0.f; }, lim);
+}
+
+static float min_g_in(const SearchContext &ctx, const GridView &grid, const SearchLimits &rect)
+{
+  float res = no_edge;
+  for (int y = rect.min.y; y < rect.max.y; ++y)
+    for (int x = rect.min.x; x < rect.max.x; ++x)
+      res = std::min(res, ctx.get_g(grid.idx(GridPos{x, y})));
+  return res;
+}
+
+static void fill_matrix(SearchContext &ctx, const GridView &grid, const DungeonPortals &dp, PortalHierarchy &ph,
+                        size_t level, size_t cluster)
+{
+  PortalLevel &lv = ph.levels[level];
+  const uint32_t first = lv.entryStart[cluster];
+  const size_t n = lv.entryStart[cluster + 1] - first;
+  float *dist = lv.distances.data() + lv.matrixStart[cluster];
+  if (level == 0)
+  {
+    // the flat graph already holds the distances
+    for (size_t i = 0; i < n; ++i)
+    {
+      dist[i * n + i] = 0.f;
+      for (const PortalConnection &conn : portal_conns(dp, lv.entries[first + i]))
+        if (conn.cluster == cluster)
+        {
+          const uint32_t to = conn.connIdx;
+          float &d = dist[i * n + lv.entryOf[side_cluster(dp, get_portal(dp, to), 0) == cluster ? 0 : 1][to]];
+          d = std::min(d, conn.score);
+        }
+    }
+    return;
+  }
+  // tiles are flooded instead of chaining the matrices below, every hop through
+  // a portal would take the closest of its tiles and add up to a route the agent can't walk
+  const SearchLimits lim = level_limits(dp, ph, level, cluster);
+  for (size_t i = 0; i < n; ++i)
+  {
+    flood_from_side(ctx, grid, lim, level_side(dp, ph, level, lv.entries[first + i], cluster));
+    for (size_t j = 0; j < n; ++j)
+    {
+      const float g = min_g_in(ctx, grid, level_side(dp, ph, level, lv.entries[first + j], cluster));
+      // score counts tiles on the path like the portal connections do
+      dist[i * n + j] = i == j ? 0.f : g < no_edge ? g + 1.f : no_edge;
+    }
+  }
+}
+
+static PortalLevel make_level(const DungeonPortals &dp, size_t nx, size_t ny, size_t span)
+{
+  PortalLevel lv;
+  lv.numClustersX = nx;
+  lv.numClustersY = ny;
+  lv.span = span;
+  const size_t numPortals = num_portals(dp);
+  const auto cluster_at = [&](size_t base)
+  {
+    const size_t baseX = dp.numClustersX;
+    return base / baseX / span * nx + base % baseX / span;
+  };
+  // portals crossing a border of this level are entries of the clusters on both sides
+  std::vector<uint32_t> counts(nx * ny + 1, 0);
+  for (size_t side = 0; side < 2; ++side)
+    lv.entryOf[side].assign(numPortals, no_entry);
+  for (size_t p = 0; p < numPortals; ++p)
+  {
+    const size_t c0 = cluster_at(side_cluster(dp, get_portal(dp, p), 0));
+    const size_t c1 = cluster_at(side_cluster(dp, get_portal(dp, p), 1));
+    if (c0 == c1)
+      continue;
+    lv.entryOf[0][p] = counts[c0]++;
+    lv.entryOf[1][p] = counts[c1]++;
+  }
+  lv.entryStart.assign(nx * ny + 1, 0);
+  lv.matrixStart.assign(nx * ny, 0);
+  size_t matrixSize = 0;
+  for (size_t c = 0; c < nx * ny; ++c)
+  {
+    lv.entryStart[c + 1] = lv.entryStart[c] + counts[c];
+    lv.matrixStart[c] = uint32_t(matrixSize);
+    matrixSize += size_t(counts[c]) * counts[c];
+  }
+  lv.entries.resize(lv.entryStart.back());
+  for (size_t p = 0; p < numPortals; ++p)
+    for (size_t side = 0; side < 2; ++side)
+      if (lv.entryOf[side][p] != no_entry)
+        lv.entries[lv.entryStart[cluster_at(side_cluster(dp, get_portal(dp, p), side))] + lv.entryOf[side][p]] =
+          uint32_t(p);
+  lv.distances.assign(matrixSize, no_edge);
+  return lv;
+}
+
+PortalHierarchy nav::build_portal_hierarchy(const GridView &grid, const DungeonPortals &dp, size_t group,
+                                            size_t max_levels)
+{
+  PortalHierarchy ph;
+  ph.group = group;
+  size_t nx = dp.numClustersX;
+  size_t ny = dp.numClustersY;
+  size_t span = 1;
+  for (size_t level = 0; level < max_levels; ++level)
+  {
+    ph.levels.push_back(make_level(dp, nx, ny, span));
+    // same scheme as build_portals, clusters of a level only read the level below
+    const size_t numClusters = nx * ny;
+    std::atomic<size_t> nextCluster = 0;
+    auto worker = [&]()
+    {
+      SearchContext ctx;
+      for (size_t cluster = nextCluster++; cluster < numClusters; cluster = nextCluster++)
+        fill_matrix(ctx, grid, dp, ph, level, cluster);
+    };
+    const size_t numThreads = std::min(size_t(std::max(std::thread::hardware_concurrency(), 1u)), numClusters);
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < numThreads; ++i)
+      threads.emplace_back(worker);
+    if (numThreads > 0)
+      worker();
+    for (std::thread &t : threads)
+      t.join();
+    if (std::max(nx, ny) <= group)
+      break;
+    nx = (nx + group - 1) / group;
+    ny = (ny + group - 1) / group;
+    span *= group;
+  }
+  return ph;
+}
+
+static float dist_to_rect(const SearchLimits &rect, GridPos p)
+{
+  const int dx = std::max(std::max(rect.min.x - p.x, p.x - (rect.max.x - 1)), 0);
+  const int dy = std::max(std::max(rect.min.y - p.y, p.y - (rect.max.y - 1)), 0);
+  return float(dx + dy);
+}
+
+// appends the portals of the flat graph the matrix edge passes, without from
+static void unpack_edge(SearchContext &ctx, const GridView &grid, const DungeonPortals &dp, const PortalHierarchy &ph,
+                        uint32_t from, uint32_t to, uint32_t via, std::vector<size_t> &out)
+{
+  const size_t level = via >> 24;
+  const size_t cluster = via & via_cluster_mask;
+  if (level > 0)
+  {
+    // the tile path the matrix entry was measured on, crossings of the clusters below are its portals
+    const SearchLimits target = level_side(dp, ph, level, to, cluster);
+    const SearchLimits side = level_side(dp, ph, level, from, cluster);
+    begin_search(ctx, grid);
+    for (int y = side.min.y; y < side.max.y; ++y)
+      for (int x = side.min.x; x < side.max.x; ++x)
+        add_start(ctx, grid.idx(GridPos{x, y}), 0.f, dist_to_rect(target, GridPos{x, y}));
+    const size_t goal = run_a_star(ctx, grid, [&](size_t idx) { return in_limits(target, grid.pos(idx)); },
+                                   [&](size_t idx) { return dist_to_rect(target, grid.pos(idx)); },
+                                   level_limits(dp, ph, level, cluster));
+    const std::vector<GridPos> tiles = goal == invalid_idx ? std::vector<GridPos>() : ctx.reconstruct_path(grid, goal);
+    for (size_t i = 1; i < tiles.size(); ++i)
+    {
+      const size_t a = cluster_of(dp, tiles[i - 1]);
+      const size_t b = cluster_of(dp, tiles[i]);
+      if (a == b)
+        continue;
+      for (uint32_t portalIdx : cluster_portals(dp, a))
+        if (portal_other_cluster(dp, get_portal(dp, portalIdx), a) == b &&
+            in_limits(portal_side(dp, get_portal(dp, portalIdx), a), tiles[i - 1]))
+        {
+          if (out.back() != portalIdx)
+            out.push_back(portalIdx);
+          break;
+        }
+    }
+  }
+  if (out.back() != to)
+    out.push_back(to);
+}
+
+HierarchicalPath nav::find_abstract_path_multilevel(PortalHierarchyContext &ctx, const GridView &grid,
+                                                    const DungeonPortals &dp, const PortalHierarchy &ph,
+                                                    GridPos from, GridPos to)
+{
+  HierarchicalPath res;
+  res.from = from;
+  res.to = to;
+  res.cur = from;
+  const size_t fromCluster = cluster_of(dp, from);
+  const size_t toCluster = cluster_of(dp, to);
+  if (fromCluster == invalid_idx || toCluster == invalid_idx || ph.levels.empty() ||
+      !grid.passable(grid.idx(from)) || !grid.passable(grid.idx(to)))
+    return res;
+  res.curCluster = fromCluster;
+
+  SearchContext &tileCtx = ctx.hierCtx.tileCtx;
+  const std::vector<std::pair<size_t, float>> goalLinks = cluster_portal_links(tileCtx, grid, dp, to);
+  const std::vector<std::pair<size_t, float>> startLinks = cluster_portal_links(tileCtx, grid, dp, from);
+  const float directCost = fromCluster == toCluster ? tileCtx.get_g(grid.idx(to)) : no_edge;
+  // clusters holding the start or the goal have to be entered a level lower
+  std::vector<size_t> fromAncestor(ph.levels.size());
+  std::vector<size_t> toAncestor(ph.levels.size());
+  for (size_t level = 0; level < ph.levels.size(); ++level)
+  {
+    fromAncestor[level] = ancestor(ph, level, fromCluster);
+    toAncestor[level] = ancestor(ph, level, toCluster);
+  }
+
+  // abstract graph: portals, then start and goal nodes
+  const size_t numPortals = num_portals(dp);
+  const size_t startNode = numPortals;
+  const size_t goalNode = numPortals + 1;
+  SearchContext &pctx = ctx.hierCtx.portalCtx;
+  pctx.reset(numPortals + 2);
+  ctx.via.resize(numPortals + 2);
+  auto heuristic = [&](size_t node)
+  {
+    if (node >= numPortals)
+      return node == startNode ? manhattan(from, to) : 0.f;
+    const PathPortal portal = get_portal(dp, node);
+    return dist_to_rect(SearchLimits{{int(portal.startX), int(portal.startY)},
+                                     {int(portal.endX) + 1, int(portal.endY) + 1}}, to);
+  };
+  auto relax = [&](size_t node, size_t prev, float g, uint32_t via)
+  {
+    if (!pctx.is_closed(node) && pctx.relax(node, prev, g))
+    {
+      pctx.push(node, g, g + heuristic(node));
+      ctx.via[node] = via;
+    }
+  };
+  add_start(pctx, startNode, 0.f, heuristic(startNode));
+  while (!pctx.open.empty())
+  {
+    const OpenNode cur = pctx.pop();
+    if (pctx.is_closed(cur.idx) || cur.g > pctx.g[cur.idx])
+      continue;
+    pctx.close(cur.idx);
+    if (cur.idx == goalNode)
+      break;
+    if (cur.idx == startNode)
+    {
+      for (const auto &link : startLinks)
+        relax(link.first, cur.idx, link.second, encode_via(0, fromCluster));
+      if (directCost < no_edge)
+        relax(goalNode, cur.idx, directCost, encode_via(0, fromCluster));
+      continue;
+    }
+    const PathPortal portal = get_portal(dp, cur.idx);
+    for (size_t side = 0; side < 2; ++side)
+    {
+      const size_t base = side_cluster(dp, portal, side);
+      size_t level = ph.levels.size() - 1;
+      for (; level > 0; --level)
+      {
+        const size_t cluster = ancestor(ph, level, base);
+        if (ph.levels[level].entryOf[side][cur.idx] != no_entry && cluster != fromAncestor[level] &&
+            cluster != toAncestor[level])
+          break;
+      }
+      const size_t cluster = ancestor(ph, level, base);
+      relax_row(ph.levels[level], cluster, ph.levels[level].entryOf[side][cur.idx], cur.g,
+                [&](uint32_t node, float g) { relax(node, cur.idx, g, encode_via(level, cluster)); });
+    }
+    for (const auto &link : goalLinks)
+      if (link.first == cur.idx)
+        relax(goalNode, cur.idx, cur.g + link.second, encode_via(0, toCluster));
+  }
+  if (!pctx.is_closed(goalNode))
+    return res;
+  res.found = true;
+  res.cost = pctx.g[goalNode];
+  std::vector<uint32_t> route;
+  for (uint32_t node = pctx.prev[goalNode]; node != startNode; node = pctx.prev[node])
+    route.push_back(node);
+  std::reverse(route.begin(), route.end());
+  for (size_t i = 0; i < route.size(); ++i)
+  {
+    if (i == 0)
+      res.portals.push_back(route[0]);
+    else
+      unpack_edge(tileCtx, grid, dp, ph, route[i - 1], route[i], ctx.via[route[i]], res.portals);
+  }
+  return res;
+}
+
+std::vector<GridPos> nav::find_path_multilevel(PortalHierarchyContext &ctx, const GridView &grid,
+                                               const DungeonPortals &dp, const PortalHierarchy &ph,
+                                               GridPos from, GridPos to)
+{
+  if (cluster_of(dp, from) == invalid_idx || cluster_of(dp, to) == invalid_idx)
+    return find_path_a_star(ctx.hierCtx.tileCtx, grid, from, to);
+  HierarchicalPath path = find_abstract_path_multilevel(ctx, grid, dp, ph, from, to);
+  if (!path.found)
+    return std::vector<GridPos>();
+  std::vector<GridPos> res = {from};
+  while (!path.refined)
+    if (!refine_next_segment(ctx.hierCtx, grid, dp, path, res))
+      return find_path_a_star(ctx.hierCtx.tileCtx, grid, from, to);
+  return res;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "gridTypes.h"
+#include "searchContext.h"
+#include "portalGraph.h"
+#include "hierarchicalSearch.h"
+
+namespace nav
+{
+  constexpr uint32_t no_entry = uint32_t(-1);
+
+  // One level of clusters. Entries of a cluster are the DungeonPortals portals
+  // on its border, the distances between all of them are kept in one dense
+  // row major matrix per cluster, matrices of all clusters back to back.
+  struct PortalLevel
+  {
+    size_t numClustersX = 0;
+    size_t numClustersY = 0;
+    size_t span = 1; // DungeonPortals clusters per side of a cluster
+    std::vector<uint32_t> entryStart; // per cluster into entries, one extra at the end
+    std::vector<uint32_t> entries; // portal indices
+    std::vector<uint32_t> matrixStart; // per cluster into distances
+    std::vector<float> distances; // max float if there is no path inside the cluster
+    std::vector<uint32_t> entryOf[2]; // per portal, its row in the cluster of the start/end side or no_entry
+  };
+
+  // Clusters of clusters over DungeonPortals: levels[0] are its own clusters,
+  // every next level groups group x group clusters of the previous one, until
+  // the top level is at most group clusters wide. Matrices above levels[0] are
+  // filled with tile floods inside the cluster.
+  // Single tile agents only, rebuilt after update_portals since it compacts portal indices.
+  struct PortalHierarchy
+  {
+    size_t group = 0;
+    std::vector<PortalLevel> levels;
+  };
+
+  // clusters of every level are filled in on all cores
+  PortalHierarchy build_portal_hierarchy(const GridView &grid, const DungeonPortals &dp, size_t group = 4,
+                                         size_t max_levels = 4);
+
+  struct PortalHierarchyContext
+  {
+    HierarchicalContext hierCtx;
+    std::vector<uint32_t> via; // per node, (level << 24) | cluster of the matrix edge it was reached by
+  };
+
+  // Each portal expands through the highest level cluster on its side that
+  // has neither start nor goal in it, so far away parts of the map cost one
+  // row of a matrix. Each matrix edge is then unpacked into the portals of the
+  // flat graph its tile path crosses and refined like any HPA* path.
+  HierarchicalPath find_abstract_path_multilevel(PortalHierarchyContext &ctx, const GridView &grid,
+                                                 const DungeonPortals &dp, const PortalHierarchy &ph,
+                                                 GridPos from, GridPos to);
+  std::vector<GridPos> find_path_multilevel(PortalHierarchyContext &ctx, const GridView &grid,
+                                            const DungeonPortals &dp, const PortalHierarchy &ph,
+                                            GridPos from, GridPos to);
+};
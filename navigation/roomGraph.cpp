@@ -0,0 +1,604 @@
+#include "roomGraph.h"
+#include "aStar.h"
+#include "clearance.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+
+using namespace nav;
+
+// tiles of the allowed rooms, plugs into run_a_star like GridView
+struct RoomSetView
+{
+  const char *tiles = nullptr;
+  size_t width = 0;
+  size_t height = 0;
+  const uint32_t *roomOf = nullptr;
+  const uint8_t *allowed = nullptr;
+
+  size_t idx(GridPos p) const { return size_t(p.y) * width + size_t(p.x); }
+  GridPos pos(size_t idx) const { return GridPos{int(idx % width), int(idx / width)}; }
+
+  bool passable(size_t idx) const { return roomOf[idx] != no_room && allowed[roomOf[idx]]; }
+  float cost(size_t idx) const { return float(terrain_cost(tiles[idx])); }
+};
+
+constexpr uint8_t max_depth = max_clearance / 2;
+// crossings per door, wider openings are split so paths do not detour to a single anchor
+constexpr size_t max_door_width = 8;
+
+// half the side of the largest wall free square centered on the tile, 0 on walls
+static uint8_t tile_depth(const ClearanceMap &cm, size_t x, size_t y)
+{
+  uint8_t depth = 0;
+  for (size_t r = 0; r <= x && r <= y && r < max_depth; ++r)
+  {
+    if (cm.clearance[(y - r) * cm.width + (x - r)] < 2 * r + 1)
+      break;
+    depth = uint8_t(r + 1);
+  }
+  return depth;
+}
+
+struct Watershed
+{
+  std::vector<uint32_t> parent;
+  std::vector<uint8_t> peak;
+  std::vector<size_t> area;
+
+  uint32_t find(uint32_t r)
+  {
+    while (parent[r] != r)
+      r = parent[r] = parent[parent[r]];
+    return r;
+  }
+
+  uint32_t add(uint8_t level)
+  {
+    parent.push_back(uint32_t(parent.size()));
+    peak.push_back(level);
+    area.push_back(0);
+    return parent.back();
+  }
+
+  void unite(uint32_t into, uint32_t from)
+  {
+    parent[from] = into;
+    peak[into] = std::max(peak[into], peak[from]);
+    area[into] += area[from];
+  }
+};
+
+// watershed labels, compacted to room indices in tile order
+static std::vector<uint32_t> segment_rooms(const GridView &grid, float merge_ratio, size_t min_room_area,
+                                           size_t max_room_area)
+{
+  const ClearanceMap cm = build_clearance(grid);
+  const size_t width = grid.width;
+  std::vector<uint8_t> depth(grid.size(), 0);
+  std::vector<std::vector<uint32_t>> byDepth(max_depth + 1);
+  for (size_t y = 0; y < grid.height; ++y)
+    for (size_t x = 0; x < width; ++x)
+    {
+      depth[y * width + x] = tile_depth(cm, x, y);
+      byDepth[depth[y * width + x]].push_back(uint32_t(y * width + x));
+    }
+
+  Watershed ws;
+  std::vector<uint32_t> label(grid.size(), no_room);
+  auto for_neighbours = [&](uint32_t idx, auto fn)
+  {
+    const GridPos p = grid.pos(idx);
+    for (const GridPos &offs : neighbour_offsets)
+    {
+      const GridPos np{p.x + offs.x, p.y + offs.y};
+      if (grid.in_bounds(np) && depth[grid.idx(np)] > 0)
+        fn(uint32_t(grid.idx(np)));
+    }
+  };
+  // every adjacent pair is looked at once, when the later of the two gets its label
+  auto assign = [&](uint32_t idx, uint32_t room, uint8_t level)
+  {
+    label[idx] = room;
+    ws.area[room]++;
+    for_neighbours(idx, [&](uint32_t nidx)
+    {
+      if (label[nidx] == no_room)
+        return;
+      const uint32_t a = ws.find(label[idx]);
+      const uint32_t b = ws.find(label[nidx]);
+      if (a == b || ws.area[a] + ws.area[b] > max_room_area)
+        return;
+      if (float(level) >= merge_ratio * float(std::min(ws.peak[a], ws.peak[b])))
+        ws.unite(a, b);
+    });
+  };
+  auto has_room = [&](uint32_t idx) { return ws.area[ws.find(label[idx])] < max_room_area; };
+
+  std::vector<uint32_t> queue;
+  for (uint8_t level = max_depth; level > 0; --level)
+  {
+    // existing rooms flow down into the level first, a tile joins whichever room reaches it first
+    queue.clear();
+    for (uint32_t idx : byDepth[level])
+      for_neighbours(idx, [&](uint32_t nidx)
+      {
+        if (label[idx] == no_room && label[nidx] != no_room && has_room(nidx))
+        {
+          assign(idx, ws.find(label[nidx]), level);
+          queue.push_back(idx);
+        }
+      });
+    for (size_t head = 0; head < queue.size(); ++head)
+    {
+      const uint32_t cur = queue[head];
+      for_neighbours(cur, [&](uint32_t nidx)
+      {
+        if (label[nidx] == no_room && depth[nidx] == level && has_room(cur))
+        {
+          assign(nidx, ws.find(label[cur]), level);
+          queue.push_back(nidx);
+        }
+      });
+    }
+    // what is left are new maxima, each plateau starts its own room
+    for (uint32_t seed : byDepth[level])
+    {
+      if (label[seed] != no_room)
+        continue;
+      queue.clear();
+      assign(seed, ws.add(level), level);
+      queue.push_back(seed);
+      for (size_t head = 0; head < queue.size(); ++head)
+      {
+        const uint32_t cur = queue[head];
+        for_neighbours(cur, [&](uint32_t nidx)
+        {
+          if (label[nidx] == no_room && depth[nidx] == level && has_room(cur))
+          {
+            assign(nidx, ws.find(label[cur]), level);
+            queue.push_back(nidx);
+          }
+        });
+      }
+    }
+  }
+
+  // small leftovers join the neighbour they share the longest boundary with, smallest first
+  std::vector<std::vector<uint32_t>> roomTiles(ws.parent.size());
+  for (uint32_t idx = 0; idx < label.size(); ++idx)
+    if (label[idx] != no_room)
+      roomTiles[ws.find(label[idx])].push_back(idx);
+  std::vector<uint32_t> order;
+  for (uint32_t room = 0; room < roomTiles.size(); ++room)
+    if (!roomTiles[room].empty() && roomTiles[room].size() < min_room_area)
+      order.push_back(room);
+  std::sort(order.begin(), order.end(),
+            [&](uint32_t lhs, uint32_t rhs) { return roomTiles[lhs].size() < roomTiles[rhs].size(); });
+  std::unordered_map<uint32_t, size_t> contacts;
+  for (uint32_t room : order)
+  {
+    const uint32_t self = ws.find(room);
+    if (roomTiles[self].size() >= min_room_area)
+      continue;
+    contacts.clear();
+    for (uint32_t idx : roomTiles[self])
+      for_neighbours(idx, [&](uint32_t nidx)
+      {
+        const uint32_t other = ws.find(label[nidx]);
+        if (other != self)
+          contacts[other]++;
+      });
+    // the room sharing the longest border wins, the lower id on ties
+    uint32_t bestId = no_room;
+    size_t bestCount = 0;
+    for (const auto &[other, count] : contacts)
+      if (count > bestCount || (count == bestCount && other < bestId))
+      {
+        bestId = other;
+        bestCount = count;
+      }
+    if (bestId == no_room)
+      continue;
+    const uint32_t into = bestId;
+    ws.unite(into, self);
+    roomTiles[into].insert(roomTiles[into].end(), roomTiles[self].begin(), roomTiles[self].end());
+    roomTiles[self].clear();
+  }
+
+  std::vector<uint32_t> compact(ws.parent.size(), no_room);
+  uint32_t numRooms = 0;
+  for (uint32_t &l : label)
+  {
+    if (l == no_room)
+      continue;
+    const uint32_t root = ws.find(l);
+    if (compact[root] == no_room)
+      compact[root] = numRooms++;
+    l = compact[root];
+  }
+  return label;
+}
+
+// groups the boundary tile pairs of every two rooms into connected doors
+static std::vector<RoomDoor> find_doors(const GridView &grid, const std::vector<uint32_t> &roomOf)
+{
+  struct Crossing
+  {
+    uint32_t tiles[2]; // tiles[0] lies in the room with the lower index
+  };
+  std::vector<Crossing> crossings;
+  std::unordered_map<uint32_t, std::vector<uint32_t>> tileCrossings;
+  auto add_crossing = [&](uint32_t a, uint32_t b)
+  {
+    if (roomOf[a] == no_room || roomOf[b] == no_room || roomOf[a] == roomOf[b])
+      return;
+    if (roomOf[a] > roomOf[b])
+      std::swap(a, b);
+    tileCrossings[a].push_back(uint32_t(crossings.size()));
+    tileCrossings[b].push_back(uint32_t(crossings.size()));
+    crossings.push_back({{a, b}});
+  };
+  for (size_t y = 0; y < grid.height; ++y)
+    for (size_t x = 0; x < grid.width; ++x)
+    {
+      const uint32_t idx = uint32_t(y * grid.width + x);
+      if (x + 1 < grid.width)
+        add_crossing(idx, idx + 1);
+      if (y + 1 < grid.height)
+        add_crossing(idx, idx + uint32_t(grid.width));
+    }
+
+  // crossings of the same pair of rooms touching each other belong to one door
+  std::vector<uint8_t> taken(crossings.size(), 0);
+  std::vector<RoomDoor> doors;
+  std::vector<uint32_t> stack;
+  std::vector<uint32_t> members;
+  for (uint32_t first = 0; first < crossings.size(); ++first)
+  {
+    if (taken[first])
+      continue;
+    const uint32_t rooms[2] = {roomOf[crossings[first].tiles[0]], roomOf[crossings[first].tiles[1]]};
+    taken[first] = 1;
+    stack.assign(1, first);
+    members.clear();
+    SearchLimits rect{grid.pos(crossings[first].tiles[0]), grid.pos(crossings[first].tiles[0])};
+    while (!stack.empty())
+    {
+      const Crossing c = crossings[stack.back()];
+      members.push_back(stack.back());
+      stack.pop_back();
+      for (size_t side = 0; side < 2; ++side)
+      {
+        const GridPos p = grid.pos(c.tiles[side]);
+        rect.min = GridPos{std::min(rect.min.x, p.x), std::min(rect.min.y, p.y)};
+        rect.max = GridPos{std::max(rect.max.x, p.x), std::max(rect.max.y, p.y)};
+        for (const GridPos &offs : {GridPos{0, 0}, GridPos{1, 0}, GridPos{-1, 0}, GridPos{0, 1}, GridPos{0, -1}})
+        {
+          const GridPos np{p.x + offs.x, p.y + offs.y};
+          if (!grid.in_bounds(np))
+            continue;
+          const auto it = tileCrossings.find(uint32_t(grid.idx(np)));
+          if (it == tileCrossings.end())
+            continue;
+          for (uint32_t other : it->second)
+          {
+            const Crossing &oc = crossings[other];
+            if (taken[other] || roomOf[oc.tiles[0]] != rooms[0] || roomOf[oc.tiles[1]] != rooms[1])
+              continue;
+            taken[other] = 1;
+            stack.push_back(other);
+          }
+        }
+      }
+    }
+    // wide openings are cut along their longer side, each piece gets its own anchor
+    const bool alongX = rect.max.x - rect.min.x >= rect.max.y - rect.min.y;
+    std::sort(members.begin(), members.end(), [&](uint32_t lhs, uint32_t rhs)
+    {
+      const GridPos l = grid.pos(crossings[lhs].tiles[0]);
+      const GridPos r = grid.pos(crossings[rhs].tiles[0]);
+      return alongX ? (l.x != r.x ? l.x < r.x : l.y < r.y) : (l.y != r.y ? l.y < r.y : l.x < r.x);
+    });
+    const size_t pieces = (members.size() + max_door_width - 1) / max_door_width;
+    for (size_t piece = 0; piece < pieces; ++piece)
+    {
+      // even pieces, so a door a little wider than the cap is not left with a sliver
+      const size_t begin = members.size() * piece / pieces;
+      const size_t end = members.size() * (piece + 1) / pieces;
+      RoomDoor door;
+      door.rooms[0] = rooms[0];
+      door.rooms[1] = rooms[1];
+      door.rect = SearchLimits{grid.pos(crossings[members[begin]].tiles[0]),
+                               grid.pos(crossings[members[begin]].tiles[0])};
+      for (size_t i = begin; i < end; ++i)
+        for (size_t side = 0; side < 2; ++side)
+        {
+          const uint32_t idx = crossings[members[i]].tiles[side];
+          const GridPos p = grid.pos(idx);
+          door.tiles[side].push_back(idx);
+          door.rect.min = GridPos{std::min(door.rect.min.x, p.x), std::min(door.rect.min.y, p.y)};
+          door.rect.max = GridPos{std::max(door.rect.max.x, p.x), std::max(door.rect.max.y, p.y)};
+        }
+      for (std::vector<uint32_t> &tiles : door.tiles)
+      {
+        std::sort(tiles.begin(), tiles.end());
+        tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
+      }
+      // the crossing closest to the middle, in doubled coordinates to stay on ints
+      int bestDist = std::numeric_limits<int>::max();
+      for (size_t i = begin; i < end; ++i)
+      {
+        const GridPos p = grid.pos(crossings[members[i]].tiles[0]);
+        const int dist = std::abs(2 * p.x - door.rect.min.x - door.rect.max.x) +
+                         std::abs(2 * p.y - door.rect.min.y - door.rect.max.y);
+        if (dist < bestDist)
+        {
+          bestDist = dist;
+          door.anchor[0] = crossings[members[i]].tiles[0];
+          door.anchor[1] = crossings[members[i]].tiles[1];
+        }
+      }
+      door.rect.max = GridPos{door.rect.max.x + 1, door.rect.max.y + 1};
+      doors.push_back(std::move(door));
+    }
+  }
+  return doors;
+}
+
+static uint8_t side_in(const RoomDoor &door, uint32_t room)
+{
+  return door.rooms[0] == room ? 0 : 1;
+}
+
+// anchors of the doors of the room, in roomDoors order
+static void room_anchors(const RoomGraph &rg, uint32_t room, std::vector<uint32_t> &anchors)
+{
+  anchors.clear();
+  for (uint32_t doorIdx : rg.roomDoors[room])
+    anchors.push_back(rg.doors[doorIdx].anchor[side_in(rg.doors[doorIdx], room)]);
+}
+
+// floods the room from the tile until every one of the targets is settled,
+// g and prev of what it reached are left in ctx
+static void flood_room(SearchContext &ctx, const RoomSetView &view, const SearchLimits &lim, size_t from,
+                       const std::vector<uint32_t> &targets)
+{
+  begin_search(ctx, view);
+  add_start(ctx, from, 0.f, 0.f);
+  size_t left = targets.size();
+  auto is_goal = [&](size_t idx)
+  {
+    for (uint32_t target : targets)
+      if (target == idx)
+        left--;
+    return left == 0;
+  };
+  run_a_star(ctx, view, is_goal, [](size_t) { return 0.f; }, lim);
+}
+
+struct DoorPairLink
+{
+  uint32_t from;
+  uint32_t to;
+  float score;
+  std::vector<uint32_t> path; // anchor of from to anchor of to
+};
+
+static void connect_room_doors(SearchContext &ctx, std::vector<uint8_t> &allowed, std::vector<uint32_t> &anchors,
+                               const GridView &grid, const RoomGraph &rg, uint32_t room,
+                               std::vector<DoorPairLink> &links)
+{
+  const std::vector<uint32_t> &doorIndices = rg.roomDoors[room];
+  room_anchors(rg, room, anchors);
+  allowed[room] = 1;
+  const RoomSetView view{grid.tiles, grid.width, grid.height, rg.roomOf.data(), allowed.data()};
+  for (size_t i = 0; i + 1 < doorIndices.size(); ++i)
+  {
+    flood_room(ctx, view, rg.roomRects[room], anchors[i], anchors);
+    for (size_t j = i + 1; j < doorIndices.size(); ++j)
+    {
+      if (!ctx.is_closed(anchors[j]))
+        continue;
+      DoorPairLink link{doorIndices[i], doorIndices[j], ctx.g[anchors[j]], {}};
+      for (uint32_t cur = anchors[j]; cur != SearchContext::no_prev; cur = ctx.prev[cur])
+        link.path.push_back(cur);
+      std::reverse(link.path.begin(), link.path.end());
+      links.push_back(std::move(link));
+    }
+  }
+  allowed[room] = 0;
+}
+
+RoomGraph nav::build_room_graph(const GridView &grid, float merge_ratio, size_t min_room_area,
+                                size_t max_room_area)
+{
+  RoomGraph rg;
+  rg.width = grid.width;
+  rg.height = grid.height;
+  rg.roomOf = segment_rooms(grid, merge_ratio, min_room_area, max_room_area);
+  for (size_t idx = 0; idx < rg.roomOf.size(); ++idx)
+  {
+    const uint32_t room = rg.roomOf[idx];
+    if (room == no_room)
+      continue;
+    const GridPos p = grid.pos(idx);
+    if (room >= rg.roomRects.size())
+      rg.roomRects.resize(room + 1, SearchLimits{p, GridPos{p.x + 1, p.y + 1}});
+    SearchLimits &rect = rg.roomRects[room];
+    rect.min = GridPos{std::min(rect.min.x, p.x), std::min(rect.min.y, p.y)};
+    rect.max = GridPos{std::max(rect.max.x, p.x + 1), std::max(rect.max.y, p.y + 1)};
+  }
+  rg.roomDoors.resize(rg.roomRects.size());
+  rg.doors = find_doors(grid, rg.roomOf);
+  for (uint32_t doorIdx = 0; doorIdx < rg.doors.size(); ++doorIdx)
+    for (uint32_t room : rg.doors[doorIdx].rooms)
+      rg.roomDoors[room].push_back(doorIdx);
+
+  // same scheme as build_portals: rooms are flooded in parallel, links merged in room order
+  std::vector<std::vector<DoorPairLink>> roomLinks(rg.roomDoors.size());
+  std::atomic<size_t> nextRoom = 0;
+  auto worker = [&]()
+  {
+    SearchContext ctx;
+    std::vector<uint8_t> allowed(rg.roomDoors.size(), 0);
+    std::vector<uint32_t> anchors;
+    for (size_t room = nextRoom++; room < roomLinks.size(); room = nextRoom++)
+      connect_room_doors(ctx, allowed, anchors, grid, rg, uint32_t(room), roomLinks[room]);
+  };
+  const size_t numThreads = std::min(size_t(std::max(std::thread::hardware_concurrency(), 1u)), roomLinks.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < numThreads; ++i)
+    threads.emplace_back(worker);
+  if (numThreads > 0)
+    worker();
+  for (std::thread &t : threads)
+    t.join();
+  for (uint32_t room = 0; room < roomLinks.size(); ++room)
+    for (DoorPairLink &link : roomLinks[room])
+    {
+      RoomDoor &from = rg.doors[link.from];
+      RoomDoor &to = rg.doors[link.to];
+      const uint8_t fromSide = side_in(from, room);
+      const uint8_t toSide = side_in(to, room);
+      const uint32_t path = uint32_t(rg.linkPaths.size());
+      // walked backwards the path enters the anchor of from instead of the one of to
+      const float back = link.score - grid.cost(to.anchor[toSide]) + grid.cost(from.anchor[fromSide]);
+      from.links[fromSide].push_back({link.to, link.score, path, false});
+      to.links[toSide].push_back({link.from, back, path, true});
+      rg.linkPaths.push_back(std::move(link.path));
+    }
+  return rg;
+}
+
+// Door graph search: node 2 * door + side stands on the anchor of that side of
+// the door, the two nodes after them are the ends of the query. Expects both
+// end floods in ctx, leaves the door nodes of the route in ctx.route.
+static bool find_door_route(RoomContext &ctx, const GridView &grid, const RoomGraph &rg, GridPos from, GridPos to)
+{
+  const uint32_t fromRoom = room_of(rg, from);
+  const uint32_t toRoom = room_of(rg, to);
+  const size_t toIdx = grid.idx(to);
+  const size_t numNodes = rg.doors.size() * 2;
+  const size_t startNode = numNodes;
+  const size_t goalNode = numNodes + 1;
+  auto anchor_of = [&](size_t node) { return rg.doors[node / 2].anchor[node % 2]; };
+  SearchContext &dctx = ctx.doorCtx;
+  dctx.reset(numNodes + 2);
+  auto heuristic = [&](size_t node)
+  {
+    if (node == goalNode)
+      return 0.f;
+    return manhattan(node == startNode ? from : grid.pos(anchor_of(node)), to);
+  };
+  auto relax = [&](size_t node, size_t prev, float g)
+  {
+    if (!dctx.is_closed(node) && dctx.relax(node, prev, g))
+      dctx.push(node, g, g + heuristic(node));
+  };
+  add_start(dctx, startNode, 0.f, heuristic(startNode));
+  while (!dctx.open.empty())
+  {
+    const OpenNode cur = dctx.pop();
+    if (dctx.is_closed(cur.idx) || cur.g > dctx.g[cur.idx])
+      continue;
+    dctx.close(cur.idx);
+    if (cur.idx == goalNode)
+      break;
+    if (cur.idx == startNode)
+    {
+      for (uint32_t doorIdx : rg.roomDoors[fromRoom])
+      {
+        const size_t node = doorIdx * 2 + side_in(rg.doors[doorIdx], fromRoom);
+        if (ctx.tileCtx.is_closed(anchor_of(node)))
+          relax(node, cur.idx, ctx.tileCtx.g[anchor_of(node)]);
+      }
+      // the start flood only reaches to when both ends share the room
+      if (ctx.tileCtx.is_closed(toIdx))
+        relax(goalNode, cur.idx, ctx.tileCtx.g[toIdx]);
+      continue;
+    }
+    const RoomDoor &door = rg.doors[cur.idx / 2];
+    const uint8_t side = uint8_t(cur.idx % 2);
+    const uint32_t room = door.rooms[side];
+    // stepping through the door enters the anchor on the other side
+    relax(cur.idx ^ 1u, cur.idx, cur.g + grid.cost(door.anchor[side ^ 1]));
+    for (const DoorLink &link : door.links[side])
+      relax(link.door * 2 + side_in(rg.doors[link.door], room), cur.idx, cur.g + link.score);
+    const uint32_t anchor = door.anchor[side];
+    if (room == toRoom && ctx.goalCtx.is_closed(anchor))
+      // the goal flood ran from to, walked the other way its path enters to instead of the anchor
+      relax(goalNode, cur.idx, cur.g + ctx.goalCtx.g[anchor] - grid.cost(anchor) + grid.cost(toIdx));
+  }
+  if (!dctx.is_closed(goalNode))
+    return false;
+  ctx.route.clear();
+  for (uint32_t node = dctx.prev[goalNode]; node != startNode; node = dctx.prev[node])
+    ctx.route.push_back(node);
+  std::reverse(ctx.route.begin(), ctx.route.end());
+  return true;
+}
+
+std::vector<GridPos> nav::find_path_rooms(RoomContext &ctx, const GridView &grid, const RoomGraph &rg,
+                                          GridPos from, GridPos to)
+{
+  ctx.tileCtx.expanded = 0;
+  ctx.goalCtx.expanded = 0;
+  ctx.doorCtx.expanded = 0;
+  const uint32_t fromRoom = room_of(rg, from);
+  const uint32_t toRoom = room_of(rg, to);
+  if (fromRoom == no_room || toRoom == no_room)
+    return std::vector<GridPos>();
+  const size_t toIdx = grid.idx(to);
+  // each end is flooded with only its own room allowed
+  ctx.allowed.assign(rg.roomDoors.size(), 0);
+  const RoomSetView view{grid.tiles, grid.width, grid.height, rg.roomOf.data(), ctx.allowed.data()};
+  ctx.allowed[fromRoom] = 1;
+  room_anchors(rg, fromRoom, ctx.anchors);
+  if (fromRoom == toRoom)
+    ctx.anchors.push_back(uint32_t(toIdx));
+  flood_room(ctx.tileCtx, view, rg.roomRects[fromRoom], grid.idx(from), ctx.anchors);
+  ctx.allowed[fromRoom] = 0;
+  ctx.allowed[toRoom] = 1;
+  room_anchors(rg, toRoom, ctx.anchors);
+  flood_room(ctx.goalCtx, view, rg.roomRects[toRoom], toIdx, ctx.anchors);
+  const bool found = find_door_route(ctx, grid, rg, from, to);
+  // stats cover both end floods
+  ctx.tileCtx.expanded += ctx.goalCtx.expanded;
+  if (!found)
+    return std::vector<GridPos>();
+  if (ctx.route.empty())
+    return ctx.tileCtx.reconstruct_path(grid, toIdx);
+
+  auto anchor_of = [&](uint32_t node) { return rg.doors[node / 2].anchor[node % 2]; };
+  std::vector<GridPos> res = ctx.tileCtx.reconstruct_path(grid, anchor_of(ctx.route.front()));
+  for (size_t i = 1; i < ctx.route.size(); ++i)
+  {
+    const uint32_t prev = ctx.route[i - 1];
+    const uint32_t node = ctx.route[i];
+    if ((prev ^ 1u) == node)
+    {
+      res.push_back(grid.pos(anchor_of(node)));
+      continue;
+    }
+    for (const DoorLink &link : rg.doors[prev / 2].links[prev % 2])
+    {
+      if (link.door != node / 2)
+        continue;
+      // the first tile of the cached path is the anchor already on res
+      const std::vector<uint32_t> &path = rg.linkPaths[link.path];
+      if (link.reversed)
+        for (size_t t = path.size() - 1; t-- > 0;)
+          res.push_back(grid.pos(path[t]));
+      else
+        for (size_t t = 1; t < path.size(); ++t)
+          res.push_back(grid.pos(path[t]));
+      break;
+    }
+  }
+  for (uint32_t cur = ctx.goalCtx.prev[anchor_of(ctx.route.back())]; cur != SearchContext::no_prev;
+       cur = ctx.goalCtx.prev[cur])
+    res.push_back(grid.pos(cur));
+  return res;
+}
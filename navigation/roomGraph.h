@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "gridTypes.h"
+#include "searchContext.h"
+
+namespace nav
+{
+  constexpr uint32_t no_room = uint32_t(-1);
+
+  struct DoorLink
+  {
+    uint32_t door;
+    float score; // cost of walking the path inside the shared room, anchor to anchor
+    uint32_t path; // into RoomGraph::linkPaths
+    bool reversed; // the stored path runs from door to this one
+  };
+
+  // connected run of tile pairs across the boundary of two rooms
+  struct RoomDoor
+  {
+    uint32_t rooms[2];
+    std::vector<uint32_t> tiles[2]; // tiles of the door inside rooms[0] and rooms[1]
+    uint32_t anchor[2]; // the tile pair nearest the middle of the door, paths cross here
+    SearchLimits rect; // bounds of both sides
+    std::vector<DoorLink> links[2]; // to the other doors of rooms[0] and rooms[1]
+  };
+
+  // Rooms and corridors instead of square clusters. Every tile gets a depth read
+  // off the clearance map (half the side of the largest wall free square centered
+  // on it) and a watershed floods the depths from the top: each local maximum
+  // starts a room, two rooms meeting at a saddle almost as deep as the shallower
+  // of them are merged, otherwise the saddle becomes a door. Narrow corridors are
+  // split between the rooms they connect, so doors land on chokepoints and caves
+  // get a handful of rooms instead of a portal per wall gap. Rooms are capped at
+  // max_room_area tiles so the end floods of a query stay small, rooms under
+  // min_room_area join the neighbour they share the longest boundary with.
+  // Single tile agents only, rebuilt from scratch when the map changes.
+  struct RoomGraph
+  {
+    size_t width = 0;
+    size_t height = 0;
+    std::vector<uint32_t> roomOf; // no_room on walls
+    std::vector<SearchLimits> roomRects;
+    std::vector<std::vector<uint32_t>> roomDoors;
+    std::vector<RoomDoor> doors;
+    std::vector<std::vector<uint32_t>> linkPaths; // tiles of every link, kept from the build floods
+  };
+
+  // door links are flooded on all cores like the portal links
+  RoomGraph build_room_graph(const GridView &grid, float merge_ratio = 0.7f, size_t min_room_area = 16,
+                             size_t max_room_area = 400);
+
+  inline uint32_t room_of(const RoomGraph &rg, GridPos p)
+  {
+    if (p.x < 0 || p.y < 0 || p.x >= int(rg.width) || p.y >= int(rg.height))
+      return no_room;
+    return rg.roomOf[size_t(p.y) * rg.width + size_t(p.x)];
+  }
+
+  struct RoomContext
+  {
+    SearchContext tileCtx;
+    SearchContext goalCtx;
+    SearchContext doorCtx;
+    std::vector<uint8_t> allowed; // the room an end flood may enter
+    std::vector<uint32_t> anchors; // the end flood stops once it has reached these
+    std::vector<uint32_t> route;
+  };
+
+  // Floods the start and goal rooms until they reach the anchors of their
+  // doors, searches the door graph and stitches the cached anchor to anchor
+  // paths of the route in between, so only the two end rooms are searched per
+  // query. Paths cross every door at its anchor, so the result is not
+  // guaranteed to be optimal.
+  std::vector<GridPos> find_path_rooms(RoomContext &ctx, const GridView &grid, const RoomGraph &rg,
+                                       GridPos from, GridPos to);
+};
@@ -0,0 +1,39 @@
+#include "searchContext.h"
+#include <algorithm>
+
+void nav::SearchContext::reset(size_t size)
+{
+  if (g.size() != size)
+  {
+    g.assign(size, std::numeric_limits<float>::max());
+    prev.assign(size, no_prev);
+    seenGen.assign(size, 0);
+    closedGen.assign(size, 0);
+    generation = 0;
+  }
+  if (++generation == 0)
+  {
+    // wrapped around, old stamps could alias the new generation
+    std::fill(seenGen.begin(), seenGen.end(), 0);
+    std::fill(closedGen.begin(), closedGen.end(), 0);
+    generation = 1;
+  }
+  open.clear();
+  expanded = 0;
+  pushed = 0;
+}
+
+void nav::SearchContext::push(size_t idx, float new_g, float f)
+{
+  open.push_back(OpenNode{f, new_g, uint32_t(idx)});
+  std::push_heap(open.begin(), open.end(), open_node_less);
+  ++pushed;
+}
+
+nav::OpenNode nav::SearchContext::pop()
+{
+  std::pop_heap(open.begin(), open.end(), open_node_less);
+  OpenNode res = open.back();
+  open.pop_back();
+  return res;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "gridTypes.h"
+
+namespace nav
+{
+  struct OpenNode
+  {
+    float f;
+    float g;
+    uint32_t idx;
+  };
+
+  // min-heap on f, ties go to the deeper node
+  inline bool open_node_less(const OpenNode &lhs, const OpenNode &rhs)
+  {
+    return lhs.f > rhs.f || (lhs.f == rhs.f && lhs.g < rhs.g);
+  }
+
+  // Per-query buffers of a grid search. Reused between queries: bumping the
+  // generation invalidates all tiles in O(1) instead of refilling the arrays.
+  struct SearchContext
+  {
+    static constexpr uint32_t no_prev = uint32_t(-1);
+
+    std::vector<float> g;
+    std::vector<uint32_t> prev;
+    std::vector<uint32_t> seenGen;
+    std::vector<uint32_t> closedGen;
+    std::vector<OpenNode> open;
+    uint32_t generation = 0;
+
+    // stats of the last query
+    size_t expanded = 0;
+    size_t pushed = 0;
+
+    void reset(size_t size);
+
+    bool is_seen(size_t idx) const { return seenGen[idx] == generation; }
+    bool is_closed(size_t idx) const { return closedGen[idx] == generation; }
+    float get_g(size_t idx) const { return is_seen(idx) ? g[idx] : std::numeric_limits<float>::max(); }
+
+    void close(size_t idx) { closedGen[idx] = generation; ++expanded; }
+    // returns false if the tile already has a better or equal g
+    bool relax(size_t idx, size_t from, float new_g)
+    {
+      if (is_seen(idx) && g[idx] <= new_g)
+        return false;
+      seenGen[idx] = generation;
+      g[idx] = new_g;
+      prev[idx] = uint32_t(from);
+      return true;
+    }
+
+    void push(size_t idx, float new_g, float f);
+    OpenNode pop();
+
+    template<typename Grid>
+    std::vector<GridPos> reconstruct_path(const Grid &grid, size_t to) const
+    {
+      std::vector<GridPos> res;
+      for (uint32_t cur = uint32_t(to); cur != no_prev; cur = prev[cur])
+        res.push_back(GridPos{int(cur % grid.width), int(cur / grid.width)});
+      std::reverse(res.begin(), res.end());
+      return res;
+    }
+  };
+};
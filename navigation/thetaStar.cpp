@@ -0,0 +1,94 @@
+#include "thetaStar.h"
+#include "aStar.h"
+#include "navGrid.h"
+
+using namespace nav;
+
+static bool valid_ends(const NavGrid &grid, GridPos from, GridPos to)
+{
+  return grid.in_bounds(from) && grid.in_bounds(to) && grid.passable_at(from.x, from.y) &&
+         grid.passable_at(to.x, to.y);
+}
+
+template<bool Lazy>
+static std::vector<GridPos> theta_star(SearchContext &ctx, const NavGrid &grid, GridPos from, GridPos to)
+{
+  begin_search(ctx, grid);
+  if (!valid_ends(grid, from, to))
+    return std::vector<GridPos>();
+  const size_t width = grid.width;
+  const size_t toIdx = grid.idx(to);
+  add_start(ctx, grid.idx(from), 0.f, euclidean(from, to));
+  while (!ctx.open.empty())
+  {
+    const OpenNode cur = ctx.pop();
+    if (ctx.is_closed(cur.idx) || cur.g > ctx.g[cur.idx])
+      continue;
+    const GridPos p = grid.pos(cur.idx);
+    if constexpr (Lazy)
+    {
+      const uint32_t parent = ctx.prev[cur.idx];
+      if (parent != SearchContext::no_prev && !has_clear_line(grid, grid.pos(parent), p))
+      {
+        // the assumed shortcut is blocked, fall back to the best expanded neighbour
+        ctx.g[cur.idx] = std::numeric_limits<float>::max();
+        for (const GridPos &offs : neighbour_offsets)
+        {
+          const GridPos np{p.x + offs.x, p.y + offs.y};
+          const size_t nidx = size_t(np.y) * width + size_t(np.x);
+          if (!grid.passable_at(np.x, np.y) || !ctx.is_closed(nidx) || ctx.g[nidx] + 1.f >= ctx.g[cur.idx])
+            continue;
+          ctx.g[cur.idx] = ctx.g[nidx] + 1.f;
+          ctx.prev[cur.idx] = uint32_t(nidx);
+        }
+      }
+    }
+    ctx.close(cur.idx);
+    if (cur.idx == toIdx)
+      return ctx.reconstruct_path(grid, toIdx);
+    const float g = ctx.g[cur.idx];
+    const uint32_t parent = ctx.prev[cur.idx];
+    for (const GridPos &offs : neighbour_offsets)
+    {
+      const GridPos np{p.x + offs.x, p.y + offs.y};
+      // the wall border keeps np inside the padded grid
+      if (!grid.passable_at(np.x, np.y))
+        continue;
+      const size_t nidx = size_t(np.y) * width + size_t(np.x);
+      if (ctx.is_closed(nidx))
+        continue;
+      size_t fromIdx = cur.idx;
+      float gScore = g + 1.f;
+      if (parent != SearchContext::no_prev && (Lazy || has_clear_line(grid, grid.pos(parent), np)))
+      {
+        fromIdx = parent;
+        gScore = ctx.g[parent] + euclidean(grid.pos(parent), np);
+      }
+      if (ctx.relax(nidx, fromIdx, gScore))
+        ctx.push(nidx, gScore, gScore + euclidean(np, to));
+    }
+  }
+  return std::vector<GridPos>();
+}
+
+std::vector<GridPos> nav::find_path_theta_star(SearchContext &ctx, const NavGrid &grid, GridPos from, GridPos to)
+{
+  return theta_star<false>(ctx, grid, from, to);
+}
+
+std::vector<GridPos> nav::find_path_lazy_theta_star(SearchContext &ctx, const NavGrid &grid, GridPos from, GridPos to)
+{
+  return theta_star<true>(ctx, grid, from, to);
+}
+
+std::vector<GridPos> nav::string_pull(const NavGrid &grid, const std::vector<GridPos> &path)
+{
+  if (path.size() <= 2)
+    return path;
+  std::vector<GridPos> res = {path.front()};
+  for (size_t i = 1; i + 1 < path.size(); ++i)
+    if (!has_clear_line(grid, res.back(), path[i + 1]))
+      res.push_back(path[i]);
+  res.push_back(path.back());
+  return res;
+}
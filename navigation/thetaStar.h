@@ -0,0 +1,24 @@
+#pragma once
+#include <vector>
+#include "gridTypes.h"
+#include "searchContext.h"
+
+namespace nav
+{
+  struct NavGrid;
+
+  // Any-angle searches for agents moving in continuous space. A tile may take
+  // its parent's parent as its own parent when the line between them is clear
+  // (has_clear_line), so paths are a few waypoints at the turns instead of a
+  // 4-connected staircase. Lengths are euclidean between tile centers, the tile
+  // costs are ignored. Consecutive returned points are joined by clear lines.
+  std::vector<GridPos> find_path_theta_star(SearchContext &ctx, const NavGrid &grid, GridPos from, GridPos to);
+  // Lazy Theta* assumes the line is clear when a tile is reached and only checks
+  // it when the tile is expanded, about one line test per expansion instead of
+  // one per neighbour.
+  std::vector<GridPos> find_path_lazy_theta_star(SearchContext &ctx, const NavGrid &grid, GridPos from, GridPos to);
+
+  // Keeps only the tiles of a grid path where the straight line has to bend, so
+  // any search can hand out waypoints. The ends are kept.
+  std::vector<GridPos> string_pull(const NavGrid &grid, const std::vector<GridPos> &path);
+};
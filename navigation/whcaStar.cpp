@@ -0,0 +1,260 @@
+#include "whcaStar.h"
+#include <algorithm>
+
+constexpr uint32_t far_away = uint32_t(-1);
+
+void nav::ReservationTable::reset(size_t w, size_t h, size_t window_steps)
+{
+  width = w;
+  height = h;
+  window = window_steps;
+  const size_t size = w * h * (window_steps + 1);
+  if (stamp.size() != size)
+  {
+    stamp.assign(size, 0);
+    owner.assign(size, no_agent);
+    generation = 0;
+  }
+  if (++generation == 0)
+  {
+    std::fill(stamp.begin(), stamp.end(), 0);
+    generation = 1;
+  }
+}
+
+static void begin_goal(nav::GoalDistance &gd, const nav::NavGrid &ng, nav::GridPos goal)
+{
+  if (gd.dist.size() != ng.size())
+  {
+    gd.dist.assign(ng.size(), far_away);
+    gd.seenGen.assign(ng.size(), 0);
+    gd.generation = 0;
+  }
+  if (++gd.generation == 0)
+  {
+    std::fill(gd.seenGen.begin(), gd.seenGen.end(), 0);
+    gd.generation = 1;
+  }
+  gd.goal = goal;
+  gd.queue.clear();
+  gd.head = 0;
+  if (!ng.in_bounds(goal) || !ng.passable_at(goal.x, goal.y))
+    return;
+  const size_t idx = ng.idx(goal);
+  gd.seenGen[idx] = gd.generation;
+  gd.dist[idx] = 0;
+  gd.queue.push_back(uint32_t(idx));
+}
+
+// moves are undirected, so the reverse search gives the forward distance
+static uint32_t goal_distance(nav::GoalDistance &gd, const nav::NavGrid &ng, nav::GridPos p, size_t &expanded,
+                              size_t max_expanded)
+{
+  const size_t idx = ng.idx(p);
+  while (gd.seenGen[idx] != gd.generation && gd.head < gd.queue.size() && expanded < max_expanded)
+  {
+    const uint32_t cur = gd.queue[gd.head++];
+    ++expanded;
+    const nav::GridPos cp = ng.pos(cur);
+    const uint8_t mask = ng.neighbour_mask(cp.x, cp.y);
+    for (size_t dir = 0; dir < 4; ++dir)
+    {
+      if (!(mask & (1u << dir)))
+        continue;
+      const size_t nidx = ng.idx(nav::GridPos{cp.x + nav::neighbour_offsets[dir].x,
+                                              cp.y + nav::neighbour_offsets[dir].y});
+      if (gd.seenGen[nidx] == gd.generation)
+        continue;
+      gd.seenGen[nidx] = gd.generation;
+      gd.dist[nidx] = gd.dist[cur] + 1;
+      gd.queue.push_back(uint32_t(nidx));
+    }
+  }
+  return gd.seenGen[idx] == gd.generation ? gd.dist[idx] : far_away;
+}
+
+static nav::GoalDistance *kept_goal(nav::CooperativeContext &cctx, nav::GridPos goal)
+{
+  for (nav::GoalDistance &gd : cctx.goals)
+    if (gd.lastPlan != 0 && gd.goal == goal)
+    {
+      if (gd.lastPlan != cctx.plan)
+        cctx.usedGoals++;
+      gd.lastPlan = cctx.plan;
+      return &gd;
+    }
+  return nullptr;
+}
+
+// agents heading for the same tile share one search, goals past max_goals in a plan get none
+static nav::GoalDistance *find_goal(nav::CooperativeContext &cctx, const nav::NavGrid &ng, nav::GridPos goal,
+                                    size_t max_goals)
+{
+  if (nav::GoalDistance *gd = kept_goal(cctx, goal))
+    return gd;
+  if (cctx.usedGoals >= max_goals)
+    return nullptr;
+  // the least recently used search makes room for the new goal
+  nav::GoalDistance *res = nullptr;
+  if (cctx.goals.size() < max_goals)
+    res = &cctx.goals.emplace_back();
+  else
+    for (nav::GoalDistance &gd : cctx.goals)
+      if (gd.lastPlan != cctx.plan && (!res || gd.lastPlan < res->lastPlan))
+        res = &gd;
+  if (!res)
+    return nullptr;
+  cctx.usedGoals++;
+  res->lastPlan = cctx.plan;
+  begin_goal(*res, ng, goal);
+  return res;
+}
+
+static void plan_agent(nav::CooperativeContext &cctx, const nav::NavGrid &ng, const nav::CooperativeAgent &agent,
+                       uint32_t agent_id, size_t window, const nav::CooperativeSettings &settings)
+{
+  nav::ReservationTable &table = cctx.table;
+  nav::SearchContext &ctx = cctx.ctx;
+  nav::GridPos *plan = cctx.plans.data() + agent_id * (window + 1);
+  const size_t size = ng.size();
+  if (!ng.in_bounds(agent.from) || !ng.passable_at(agent.from.x, agent.from.y))
+  {
+    std::fill(plan, plan + window + 1, agent.from);
+    return;
+  }
+
+  nav::GoalDistance *gd = find_goal(cctx, ng, agent.to, settings.maxGoals);
+  // tiles cut off from the goal or not reached within the budget fall back to manhattan,
+  // the agent still gets as close as it can
+  auto heuristic = [&](nav::GridPos p)
+  {
+    const uint32_t d = gd ? goal_distance(*gd, ng, p, cctx.goalExpanded, settings.maxGoalExpanded) : far_away;
+    return d != far_away ? float(d) : nav::manhattan(p, agent.to);
+  };
+
+  ctx.reset(size * (window + 1));
+  const size_t start = ng.idx(agent.from);
+  const float startH = heuristic(agent.from);
+  ctx.relax(start, nav::SearchContext::no_prev, 0.f);
+  ctx.push(start, 0.f, startH);
+  // without a full window the plan ends at the closest tile to the goal reached, the latest such state
+  size_t best = start;
+  float bestH = startH;
+  size_t found = nav::invalid_idx;
+  while (!ctx.open.empty())
+  {
+    const nav::OpenNode cur = ctx.pop();
+    if (ctx.is_closed(cur.idx) || cur.g > ctx.g[cur.idx])
+      continue;
+    ctx.close(cur.idx);
+    const size_t t = cur.idx / size;
+    if (t == window)
+    {
+      found = cur.idx;
+      break;
+    }
+    const float h = cur.f - cur.g;
+    if (h < bestH || (h == bestH && cur.idx / size > best / size))
+    {
+      best = cur.idx;
+      bestH = h;
+    }
+    if (ctx.expanded >= settings.maxExpanded)
+      break;
+    const nav::GridPos p = ng.pos(cur.idx % size);
+    const uint8_t mask = ng.neighbour_mask(p.x, p.y);
+    // waiting is the fifth move
+    for (size_t dir = 0; dir <= 4; ++dir)
+    {
+      if (dir < 4 && !(mask & (1u << dir)))
+        continue;
+      const nav::GridPos np = dir < 4 ? nav::GridPos{p.x + nav::neighbour_offsets[dir].x,
+                                                      p.y + nav::neighbour_offsets[dir].y} : p;
+      if (!table.is_free(np, t + 1, agent_id))
+        continue;
+      if (dir < 4)
+      {
+        // whoever stands on np now must not be taking p next
+        const uint32_t other = table.owner_at(np, t);
+        if (other != nav::no_agent && other != agent_id && table.owner_at(p, t + 1) == other)
+          continue;
+      }
+      const size_t nidx = (t + 1) * size + ng.idx(np);
+      if (ctx.is_closed(nidx))
+        continue;
+      const float gScore = cur.g + (dir == 4 && p == agent.to ? 0.f : 1.f);
+      if (ctx.relax(nidx, cur.idx, gScore))
+        ctx.push(nidx, gScore, gScore + heuristic(np));
+    }
+  }
+  cctx.expanded += ctx.expanded;
+
+  const size_t end = found != nav::invalid_idx ? found : best;
+  if (found == nav::invalid_idx)
+    cctx.partial++;
+  const size_t endT = end / size;
+  for (uint32_t cur = uint32_t(end); cur != nav::SearchContext::no_prev; cur = ctx.prev[cur])
+    plan[cur / size] = ng.pos(cur % size);
+  std::fill(plan + endT + 1, plan + window + 1, plan[endT]);
+  for (size_t t = 1; t <= window; ++t)
+    table.reserve(plan[t], t, agent_id);
+}
+
+void nav::plan_cooperative(CooperativeContext &cctx, const NavGrid &ng, std::span<const CooperativeAgent> agents,
+                           std::span<const GridPos> blocked, const CooperativeSettings &settings)
+{
+  const size_t window = std::max(settings.window, size_t(1));
+  if (cctx.table.width != ng.width || cctx.table.height != ng.height)
+    forget_goal_distances(cctx);
+  cctx.table.reset(ng.width, ng.height, window);
+  cctx.plans.assign(agents.size() * (window + 1), GridPos{});
+  cctx.plan++;
+  cctx.usedGoals = 0;
+  cctx.expanded = 0;
+  cctx.goalExpanded = 0;
+  cctx.partial = 0;
+  cctx.yielded = 0;
+
+  for (size_t i = 0; i < blocked.size(); ++i)
+    if (ng.in_bounds(blocked[i]))
+      for (size_t t = 0; t <= window; ++t)
+        cctx.table.reserve(blocked[i], t, uint32_t(agents.size() + i));
+  // everybody stands on its start now, so the first moves can be checked for swaps
+  for (size_t a = 0; a < agents.size(); ++a)
+    if (ng.in_bounds(agents[a].from))
+      cctx.table.reserve(agents[a].from, 0, uint32_t(a));
+  // searches still asked for are marked first, new goals only evict the others
+  for (const CooperativeAgent &agent : agents)
+    kept_goal(cctx, agent.to);
+  for (size_t a = 0; a < agents.size(); ++a)
+    plan_agent(cctx, ng, agents[a], uint32_t(a), window, settings);
+
+  // An agent planned later can find its start taken at time 1 with nowhere to
+  // go. It stays and the agent that took the tile waits on its own, which may
+  // in turn be taken by the next one down the line. Searched steps respect the
+  // table, so every tile has at most one agent stepping onto it.
+  cctx.stuck.clear();
+  for (size_t a = 0; a < agents.size(); ++a)
+    if (planned_step(cctx, a) == agents[a].from && ng.in_bounds(agents[a].from) &&
+        cctx.table.owner_at(agents[a].from, 1) != a)
+      cctx.stuck.push_back(uint32_t(a));
+  while (!cctx.stuck.empty())
+  {
+    const uint32_t a = cctx.stuck.back();
+    cctx.stuck.pop_back();
+    const uint32_t other = cctx.table.owner_at(agents[a].from, 1);
+    if (other == no_agent || other == a || other >= agents.size() || planned_step(cctx, other) == agents[other].from)
+      continue;
+    GridPos *plan = cctx.plans.data() + other * (window + 1);
+    std::fill(plan + 1, plan + window + 1, agents[other].from);
+    cctx.yielded++;
+    if (cctx.table.owner_at(agents[other].from, 1) != other)
+      cctx.stuck.push_back(other);
+  }
+}
+
+void nav::forget_goal_distances(CooperativeContext &cctx)
+{
+  for (GoalDistance &gd : cctx.goals)
+    gd.lastPlan = 0;
+}
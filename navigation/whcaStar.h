@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "gridTypes.h"
+#include "navGrid.h"
+#include "searchContext.h"
+
+namespace nav
+{
+  constexpr uint32_t no_agent = uint32_t(-1);
+
+  // Tiles taken by already planned agents at every time step of the window,
+  // time 0 is now. One layer of width * height stamps per step, so a new plan
+  // clears the table by bumping the generation.
+  struct ReservationTable
+  {
+    size_t width = 0;
+    size_t height = 0;
+    size_t window = 0;
+    uint32_t generation = 0;
+    std::vector<uint32_t> stamp; // (window + 1) layers
+    std::vector<uint32_t> owner;
+
+    void reset(size_t w, size_t h, size_t window_steps);
+
+    size_t slot(GridPos p, size_t t) const { return t * width * height + size_t(p.y) * width + size_t(p.x); }
+    uint32_t owner_at(GridPos p, size_t t) const
+    {
+      const size_t s = slot(p, t);
+      return stamp[s] == generation ? owner[s] : no_agent;
+    }
+    bool is_free(GridPos p, size_t t, uint32_t agent) const
+    {
+      const uint32_t o = owner_at(p, t);
+      return o == no_agent || o == agent;
+    }
+    // the first agent to reserve a tile keeps it
+    void reserve(GridPos p, size_t t, uint32_t agent)
+    {
+      const size_t s = slot(p, t);
+      if (stamp[s] == generation)
+        return;
+      stamp[s] = generation;
+      owner[s] = agent;
+    }
+  };
+
+  // Exact distance to one goal by a reverse breadth first search that is only
+  // resumed as far as the tiles asked about (reverse resumable A*), so agents
+  // sharing a goal share the search, later plans to the same goal too.
+  struct GoalDistance
+  {
+    GridPos goal;
+    size_t lastPlan = 0; // 0 for a free slot
+    uint32_t generation = 0;
+    std::vector<uint32_t> dist;
+    std::vector<uint32_t> seenGen;
+    std::vector<uint32_t> queue;
+    size_t head = 0;
+  };
+
+  struct CooperativeAgent
+  {
+    GridPos from;
+    GridPos to;
+  };
+
+  struct CooperativeSettings
+  {
+    size_t window = 8; // time steps planned ahead, callers replan every turn
+    size_t maxExpanded = 512; // per agent, past it the agent takes the best partial plan
+    size_t maxGoals = 32; // goal searches kept, goals past it in one plan fall back to manhattan
+    // goal search steps per plan, past it unseen tiles fall back to manhattan and
+    // the searches resume in the next plan, so a turn full of new goals stays cheap
+    size_t maxGoalExpanded = 32768;
+  };
+
+  struct CooperativeContext
+  {
+    ReservationTable table;
+    SearchContext ctx; // one node per (time, tile)
+    std::vector<GoalDistance> goals;
+    size_t plan = 0;
+    size_t usedGoals = 0;
+    std::vector<GridPos> plans; // window + 1 tiles per agent, plans[agent * (window + 1)] is its start
+    std::vector<uint32_t> stuck;
+
+    // stats of the last plan
+    size_t expanded = 0;
+    size_t goalExpanded = 0;
+    size_t partial = 0; // agents that ran out of budget or had no way forward
+    size_t yielded = 0; // agents made to wait for one that could not leave its tile
+  };
+
+  inline GridPos planned_step(const CooperativeContext &cctx, size_t agent, size_t t = 1)
+  {
+    return cctx.plans[agent * (cctx.table.window + 1) + t];
+  }
+
+  // Windowed hierarchical cooperative A*: agents are planned one after another
+  // through space and time over 4-connected moves and waits, each avoiding the
+  // tiles and the swaps already reserved by the agents before it, and guided
+  // past the window by the exact distance to its goal. Blocked tiles stay taken
+  // for the whole window, for actors the plan does not move. Every step takes
+  // one turn whatever the terrain cost, waiting on the goal is free.
+  // An agent boxed in on its start stays there, whoever planned to step onto
+  // it waits instead, so the first steps of all plans never collide.
+  // Per agent work is bounded by the window and maxExpanded, the goal searches
+  // by maxGoalExpanded per plan.
+  void plan_cooperative(CooperativeContext &cctx, const NavGrid &ng, std::span<const CooperativeAgent> agents,
+                        std::span<const GridPos> blocked, const CooperativeSettings &settings = {});
+  // goal searches are kept between plans, call after the map changes
+  void forget_goal_distances(CooperativeContext &cctx);
+};
@@ -16,3 +16,20 @@ Position dungeon::find_walkable_tile(const char *dungeon, const size_t width, co
   return res;
 }
 
+
+Position dungeon::find_walkable_tile(const char *dungeon, const size_t width, const size_t height,
+                                     const nav::ComponentMap &components, Position reachable_from)
+{
+  const uint32_t comp = nav::component_of(components, nav::to_grid_pos(reachable_from));
+  if (comp == nav::ComponentMap::no_component)
+    return find_walkable_tile(dungeon, width, height);
+  std::vector<Position> posList;
+  for (size_t y = 0; y < height; ++y)
+    for (size_t x = 0; x < width; ++x)
+      if (dungeon[y * width + x] == dungeon::floor &&
+          nav::component_of(components, nav::GridPos{int(x), int(y)}) == comp)
+        posList.push_back(Position{int(x), int(y)});
+  if (posList.empty())
+    return reachable_from;
+  return posList[size_t(GetRandomValue(0, int(posList.size()) - 1))];
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "math.h"
 #include <cstddef>
+#include "components.h"
 
 namespace dungeon
 {
@@ -9,4 +10,7 @@ namespace dungeon
   constexpr char water = 'o';
 
   Position find_walkable_tile(const char *dungeon, const size_t width, const size_t height);
+  // only samples tiles in the same component as reachable_from
+  Position find_walkable_tile(const char *dungeon, const size_t width, const size_t height,
+                              const nav::ComponentMap &components, Position reachable_from);
 }
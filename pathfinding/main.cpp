@@ -7,6 +7,21 @@
 #include "math.h"
 #include "dungeonGen.h"
 #include "dungeonUtils.h"
+#include "aStar.h"
+#include "jps.h"
+#include "hierarchicalSearch.h"
+#include "dstarLite.h"
+#include "bidirectional.h"
+#include "idaStar.h"
+#include "araStar.h"
+#include "landmarks.h"
+#include "components.h"
+#include "navGrid.h"
+#include "dial.h"
+#include "clearance.h"
+#include "thetaStar.h"
+#include "roomGraph.h"
+#include "portalHierarchy.h"
 
 template<typename T>
 static size_t coord_to_idx(T x, T y, size_t w)
@@ -27,169 +42,219 @@ static void draw_nav_grid(const char *input, size_t width, size_t height)
     }
 }
 
-static void draw_path(std::vector<Position> path)
+static void draw_path(std::vector<Position> path, uint8_t agent_size)
 {
   for (const Position &p : path)
   {
-    const Rectangle rect = {float(p.x), float(p.y), 1.f, 1.f};
+    const Rectangle rect = {float(p.x), float(p.y), float(agent_size), float(agent_size)};
     DrawRectangleRec(rect, GetColor(0x44000088));
   }
+  // any-angle paths only hold their turns, the segments show where the agent walks
+  const float half = float(agent_size) * 0.5f;
+  for (size_t i = 1; i < path.size(); ++i)
+    DrawLineEx(Vector2{float(path[i - 1].x) + half, float(path[i - 1].y) + half},
+               Vector2{float(path[i].x) + half, float(path[i].y) + half}, 0.2f, GetColor(0xaa0000ff));
 }
 
-static std::vector<Position> reconstruct_path(std::vector<Position> prev, Position to, size_t width)
+static void draw_search_data(const nav::SearchContext &ctx, size_t width, size_t height)
 {
-  Position curPos = to;
-  std::vector<Position> res = {curPos};
-  while (prev[coord_to_idx(curPos.x, curPos.y, width)] != Position{-1, -1})
-  {
-    curPos = prev[coord_to_idx(curPos.x, curPos.y, width)];
-    res.insert(res.begin(), curPos);
-  }
-  return res;
+  if (ctx.closedGen.size() != width * height)
+    return;
+  for (size_t y = 0; y < height; ++y)
+    for (size_t x = 0; x < width; ++x)
+    {
+      size_t idx = coord_to_idx(x, y, width);
+      if (!ctx.is_closed(idx))
+        continue;
+      const Rectangle rect = {float(x), float(y), 1.f, 1.f};
+      DrawRectangleRec(rect, Color{uint8_t(ctx.g[idx]), uint8_t(ctx.g[idx]), 0, 100});
+    }
 }
 
-float heuristic(Position lhs, Position rhs)
+enum SearchMode
 {
-  return sqrtf(square(float(lhs.x - rhs.x)) + square(float(lhs.y - rhs.y)));
+  SM_A_STAR = 0,
+  SM_JPS,
+  SM_JPS_PLUS,
+  SM_HIERARCHICAL,
+  SM_D_STAR_LITE,
+  SM_BIDIR_A_STAR,
+  SM_BIDIR_DIJKSTRA,
+  SM_IDA_STAR,
+  SM_ARA_STAR,
+  SM_DIAL_A_STAR,
+  SM_LAZY_THETA_STAR,
+  SM_ROOMS,
+  SM_MULTILEVEL,
+  SM_NUM
 };
 
-static float ida_star_search(const char *input, size_t width, size_t height, std::vector<Position> &path, const float g, const float bound, Position to)
+static const char *search_mode_names[SM_NUM] = {"A*", "JPS", "JPS+", "HPA*", "D* Lite", "Bidirectional A*",
+                                                "Bidirectional Dijkstra", "IDA*", "ARA*", "Dial A*",
+                                                "Lazy Theta*", "Room HPA*", "Multilevel HPA*"};
+
+constexpr size_t ara_budget_us = 1000;
+
+struct NavState
 {
-  const Position &p = path.back();
-  const float f = g + heuristic(p, to);
-  if (f > bound)
-    return f;
-  if (p == to)
-    return -f;
-  float min = FLT_MAX;
-  auto checkNeighbour = [&](Position p) -> float
-  {
-    // out of bounds
-    if (p.x < 0 || p.y < 0 || p.x >= int(width) || p.y >= int(height))
-      return 0.f;
-    size_t idx = coord_to_idx(p.x, p.y, width);
-    // not empty
-    if (input[idx] == '#')
-      return 0.f;
-    if (std::find(path.begin(), path.end(), p) != path.end())
-      return 0.f;
-    path.push_back(p);
-    float weight = input[idx] == 'o' ? 10.f : 1.f;
-    float gScore = g + 1.f * weight; // we're exactly 1 unit away
-    const float t = ida_star_search(input, width, height, path, gScore, bound, to);
-    if (t < 0.f)
-      return t;
-    if (t < min)
-      min = t;
-    path.pop_back();
-    return t;
-  };
-  float lv = checkNeighbour({p.x + 1, p.y + 0});
-  if (lv < 0.f) return lv;
-  float rv = checkNeighbour({p.x - 1, p.y + 0});
-  if (rv < 0.f) return rv;
-  float tv = checkNeighbour({p.x + 0, p.y + 1});
-  if (tv < 0.f) return tv;
-  float bv = checkNeighbour({p.x + 0, p.y - 1});
-  if (bv < 0.f) return bv;
-  return min;
-}
+  nav::SearchContext ctx;
+  nav::JumpTable jumpTable;
+  nav::DungeonPortals portals;
+  nav::HierarchicalContext hierCtx;
+  nav::DStarLite dstar;
+  nav::BidirectionalContext bidirCtx;
+  nav::IdaStarContext idaCtx;
+  nav::AraStarContext araCtx;
+  nav::LandmarkTable landmarks;
+  nav::ComponentMap components;
+  nav::NavGrid packed; // bit per tile copy of the map for plain A* and Theta*
+  nav::CostLayer costLayer;
+  nav::DialContext dialCtx;
+  nav::RoomGraph rooms;
+  nav::RoomContext roomCtx;
+  nav::PortalHierarchy hierarchy;
+  nav::PortalHierarchyContext hierarchyCtx;
+  SearchMode mode = SM_A_STAR;
+  uint8_t agentSize = 1; // side of the square agent, only A* and HPA* take it
+  bool useLandmarks = false;
+  bool rejected = false; // last query had no path by the component labels, nothing was searched
+};
 
-static std::vector<Position> find_ida_star_path(const char *input, size_t width, size_t height, Position from, Position to)
+static void rebuild_nav_state(NavState &ns, const char *input, size_t width, size_t height)
 {
-  float bound = heuristic(from, to);
-  std::vector<Position> path = {from};
-  while (true)
-  {
-    const float t = ida_star_search(input, width, height, path, 0.f, bound, to);
-    if (t < 0.f)
-      return path;
-    if (t == FLT_MAX)
-      return {};
-    bound = t;
-    printf("new bound %0.1f\n", bound);
-  }
-  return {};
+  const nav::GridView grid{input, width, height};
+  ns.jumpTable = nav::build_jump_table(grid);
+  ns.portals = nav::build_portals(grid, 10);
+  ns.hierarchy = nav::build_portal_hierarchy(grid, ns.portals);
+  ns.landmarks = nav::build_landmarks(grid);
+  ns.components = nav::build_components(grid);
+  ns.packed = nav::build_nav_grid(grid);
+  ns.costLayer = nav::build_cost_layer(grid);
+  ns.rooms = nav::build_room_graph(grid);
+  ns.dstar.initialized = false;
 }
 
-static std::vector<Position> find_path_a_star(const char *input, size_t width, size_t height, Position from, Position to, float weight)
+static void update_nav_state(NavState &ns, const char *input, size_t width, size_t height, Position changed)
 {
-  if (from.x < 0 || from.y < 0 || from.x >= int(width) || from.y >= int(height))
-    return std::vector<Position>();
-  size_t inpSize = width * height;
-
-  std::vector<float> g(inpSize, std::numeric_limits<float>::max());
-  std::vector<float> f(inpSize, std::numeric_limits<float>::max());
-  std::vector<Position> prev(inpSize, {-1,-1});
-
-  auto getG = [&](Position p) -> float { return g[coord_to_idx(p.x, p.y, width)]; };
-  auto getF = [&](Position p) -> float { return f[coord_to_idx(p.x, p.y, width)]; };
-
-  g[coord_to_idx(from.x, from.y, width)] = 0;
-  f[coord_to_idx(from.x, from.y, width)] = weight * heuristic(from, to);
+  const nav::GridView grid{input, width, height};
+  ns.jumpTable = nav::build_jump_table(grid);
+  nav::update_portals(ns.ctx, ns.portals, grid, {nav::to_grid_pos(changed)});
+  ns.hierarchy = nav::build_portal_hierarchy(grid, ns.portals);
+  nav::dstar_update_tiles(ns.dstar, grid, {nav::to_grid_pos(changed)});
+  nav::update_components(ns.components, grid, {nav::to_grid_pos(changed)});
+  const size_t changedIdx = coord_to_idx(changed.x, changed.y, width);
+  nav::set_nav_tile(ns.packed, nav::to_grid_pos(changed), grid.passable(changedIdx), uint8_t(grid.cost(changedIdx)));
+  nav::set_tile_cost(ns.costLayer, nav::to_grid_pos(changed), nav::terrain_cost(input[changedIdx]));
+  // any change can break the triangle bounds, so the tables are rebuilt
+  ns.landmarks = nav::build_landmarks(grid);
+  // one tile can move a watershed line anywhere in its room, rooms are rebuilt as well
+  ns.rooms = nav::build_room_graph(grid);
+}
 
-  std::vector<Position> openList = {from};
-  std::vector<Position> closedList;
+// replans incrementally, only a goal change restarts the search
+static std::vector<nav::GridPos> find_path_dstar(nav::DStarLite &ds, const nav::GridView &grid,
+                                                 nav::GridPos from, nav::GridPos to)
+{
+  if (!ds.initialized || ds.goal != to)
+    nav::dstar_init(ds, grid, from, to);
+  else if (ds.start != from)
+    nav::dstar_move_start(ds, from);
+  if (!nav::dstar_compute(ds, grid))
+    return std::vector<nav::GridPos>();
+  return nav::dstar_path(ds, grid);
+}
 
-  while (!openList.empty())
+static std::vector<nav::GridPos> find_path(NavState &ns, const nav::GridView &grid,
+                                           nav::GridPos from, nav::GridPos to, float weight)
+{
+  ns.rejected = !nav::is_reachable(ns.components, from, to);
+  if (ns.rejected)
+    return std::vector<nav::GridPos>();
+  if (ns.agentSize > 1)
+  {
+    // the portal graph keeps the clearance map up to date for us
+    if (ns.mode == SM_HIERARCHICAL)
+      return nav::find_path_hierarchical(ns.hierCtx, grid, ns.portals, from, to, ns.agentSize);
+    return nav::find_path_a_star(ns.ctx, nav::clearance_grid(grid, ns.portals.clearance, ns.agentSize), from, to,
+                                 weight);
+  }
+  if (ns.useLandmarks)
   {
-    size_t bestIdx = 0;
-    float bestScore = getF(openList[0]);
-    for (size_t i = 1; i < openList.size(); ++i)
+    // ALT heuristic for the searches that take one
+    switch (ns.mode)
     {
-      float score = getF(openList[i]);
-      if (score < bestScore)
-      {
-        bestIdx = i;
-        bestScore = score;
-      }
+      case SM_A_STAR:
+        return nav::find_path_a_star(ns.ctx, grid, from, to, ns.landmarks, weight);
+      case SM_JPS:
+        return nav::find_path_jps(ns.ctx, grid, ns.jumpTable.uniformCost, from, to, ns.landmarks, weight);
+      case SM_JPS_PLUS:
+        return nav::find_path_jps_plus(ns.ctx, grid, ns.jumpTable, ns.landmarks, from, to, weight);
+      case SM_BIDIR_A_STAR:
+        return nav::find_path_bidirectional_a_star(ns.bidirCtx, grid, ns.landmarks, from, to);
+      case SM_IDA_STAR:
+        return nav::find_path_ida_star(ns.idaCtx, grid, ns.landmarks, from, to);
+      case SM_ARA_STAR:
+        return nav::find_path_ara_star(ns.araCtx, grid, ns.landmarks, from, to, ara_budget_us);
+      default:
+        break;
     }
-    if (openList[bestIdx] == to)
-      return reconstruct_path(prev, to, width);
-    Position curPos = openList[bestIdx];
-    openList.erase(openList.begin() + bestIdx);
-    if (std::find(closedList.begin(), closedList.end(), curPos) != closedList.end())
-      continue;
-    size_t idx = coord_to_idx(curPos.x, curPos.y, width);
-    const Rectangle rect = {float(curPos.x), float(curPos.y), 1.f, 1.f};
-    DrawRectangleRec(rect, Color{uint8_t(g[idx]), uint8_t(g[idx]), 0, 100});
-    closedList.emplace_back(curPos);
-    auto checkNeighbour = [&](Position p)
-    {
-      // out of bounds
-      if (p.x < 0 || p.y < 0 || p.x >= int(width) || p.y >= int(height))
-        return;
-      size_t idx = coord_to_idx(p.x, p.y, width);
-      // not empty
-      if (input[idx] == '#')
-        return;
-      float edgeWeight = input[idx] == 'o' ? 10.f : 1.f;
-      float gScore = getG(curPos) + 1.f * edgeWeight; // we're exactly 1 unit away
-      if (gScore < getG(p))
-      {
-        prev[idx] = curPos;
-        g[idx] = gScore;
-        f[idx] = gScore + weight * heuristic(p, to);
-      }
-      bool found = std::find(openList.begin(), openList.end(), p) != openList.end();
-      if (!found)
-        openList.emplace_back(p);
-    };
-    checkNeighbour({curPos.x + 1, curPos.y + 0});
-    checkNeighbour({curPos.x - 1, curPos.y + 0});
-    checkNeighbour({curPos.x + 0, curPos.y + 1});
-    checkNeighbour({curPos.x + 0, curPos.y - 1});
   }
-  // empty path
-  return std::vector<Position>();
+  switch (ns.mode)
+  {
+    case SM_JPS:
+      return nav::find_path_jps(ns.ctx, grid, ns.jumpTable.uniformCost, from, to, weight);
+    case SM_JPS_PLUS:
+      return nav::find_path_jps_plus(ns.ctx, grid, ns.jumpTable, from, to, weight);
+    case SM_HIERARCHICAL:
+      return nav::find_path_hierarchical(ns.hierCtx, grid, ns.portals, from, to);
+    case SM_D_STAR_LITE:
+      return find_path_dstar(ns.dstar, grid, from, to);
+    case SM_BIDIR_A_STAR:
+      return nav::find_path_bidirectional_a_star(ns.bidirCtx, grid, from, to);
+    case SM_BIDIR_DIJKSTRA:
+      return nav::find_path_bidirectional_dijkstra(ns.bidirCtx, grid, from, to);
+    case SM_IDA_STAR:
+      return nav::find_path_ida_star(ns.idaCtx, grid, from, to);
+    case SM_ARA_STAR:
+      return nav::find_path_ara_star(ns.araCtx, grid, from, to, ara_budget_us);
+    case SM_DIAL_A_STAR:
+      return nav::find_path_dial_a_star(ns.dialCtx, ns.costLayer, from, to);
+    case SM_LAZY_THETA_STAR:
+      return nav::find_path_lazy_theta_star(ns.ctx, ns.packed, from, to);
+    case SM_ROOMS:
+      return nav::find_path_rooms(ns.roomCtx, grid, ns.rooms, from, to);
+    case SM_MULTILEVEL:
+      return nav::find_path_multilevel(ns.hierarchyCtx, grid, ns.portals, ns.hierarchy, from, to);
+    default:
+      return nav::find_path_a_star(ns.ctx, ns.packed, from, to, weight);
+  }
 }
 
-void draw_nav_data(const char *input, size_t width, size_t height, Position from, Position to, float weight)
+void draw_nav_data(NavState &ns, const char *input, size_t width, size_t height,
+                   Position from, Position to, float weight)
 {
   draw_nav_grid(input, width, height);
-  std::vector<Position> path = find_path_a_star(input, width, height, from, to, weight);
-  //std::vector<Position> path = find_ida_star_path(input, width, height, from, to);
-  draw_path(path);
+  const nav::GridView grid{input, width, height};
+  std::vector<Position> path =
+    nav::convert_path<Position>(find_path(ns, grid, nav::to_grid_pos(from), nav::to_grid_pos(to), weight));
+  // a rejected query did not search, the contexts still hold the previous one
+  const bool searched = !ns.rejected;
+  if (searched && ns.agentSize > 1)
+    draw_search_data(ns.mode == SM_HIERARCHICAL ? ns.hierCtx.tileCtx : ns.ctx, width, height);
+  else if (searched && (ns.mode == SM_BIDIR_A_STAR || ns.mode == SM_BIDIR_DIJKSTRA))
+  {
+    draw_search_data(ns.bidirCtx.fwd, width, height);
+    draw_search_data(ns.bidirCtx.bwd, width, height);
+  }
+  else if (searched && ns.mode == SM_DIAL_A_STAR)
+    draw_search_data(ns.dialCtx.tiles, width, height);
+  else if (searched && ns.mode == SM_ROOMS)
+    draw_search_data(ns.roomCtx.tileCtx, width, height);
+  else if (searched && ns.mode == SM_MULTILEVEL)
+    draw_search_data(ns.hierarchyCtx.hierCtx.tileCtx, width, height);
+  else if (searched && ns.mode != SM_D_STAR_LITE)
+    draw_search_data(ns.mode == SM_HIERARCHICAL ? ns.hierCtx.tileCtx : ns.ctx, width, height);
+  draw_path(path, ns.agentSize);
 }
 
 int main(int /*argc*/, const char ** /*argv*/)
@@ -213,9 +278,12 @@ int main(int /*argc*/, const char ** /*argv*/)
   gen_drunk_dungeon(navGrid, dungWidth, dungHeight, 24, 100);
   spill_drunk_water(navGrid, dungWidth, dungHeight, 8, 10);
   float weight = 1.f;
+  NavState navState;
+  navState.idaCtx.budget = 100000; // keeps the frame alive on far targets
+  rebuild_nav_state(navState, navGrid, dungWidth, dungHeight);
 
   Position from = dungeon::find_walkable_tile(navGrid, dungWidth, dungHeight);
-  Position to = dungeon::find_walkable_tile(navGrid, dungWidth, dungHeight);
+  Position to = dungeon::find_walkable_tile(navGrid, dungWidth, dungHeight, navState.components, from);
 
   Camera2D camera = { {0, 0}, {0, 0}, 0.f, 1.f };
   //camera.offset = Vector2{ width * 0.5f, height * 0.5f };
@@ -229,9 +297,12 @@ int main(int /*argc*/, const char ** /*argv*/)
     Position p{int(mousePosition.x), int(mousePosition.y)};
     if (IsMouseButtonPressed(2) || IsKeyPressed(KEY_Q))
     {
-      size_t idx = coord_to_idx(p.x, p.y, dungWidth);
-      if (idx < dungWidth * dungHeight)
+      if (p.x >= 0 && p.y >= 0 && size_t(p.x) < dungWidth && size_t(p.y) < dungHeight)
+      {
+        const size_t idx = coord_to_idx(p.x, p.y, dungWidth);
         navGrid[idx] = navGrid[idx] == ' ' ? '#' : navGrid[idx] == '#' ? 'o' : ' ';
+        update_nav_state(navState, navGrid, dungWidth, dungHeight, p);
+      }
     }
     else if (IsMouseButtonPressed(0))
     {
@@ -247,8 +318,24 @@ int main(int /*argc*/, const char ** /*argv*/)
     {
       gen_drunk_dungeon(navGrid, dungWidth, dungHeight, 24, 100);
       spill_drunk_water(navGrid, dungWidth, dungHeight, 8, 10);
+      rebuild_nav_state(navState, navGrid, dungWidth, dungHeight);
       from = dungeon::find_walkable_tile(navGrid, dungWidth, dungHeight);
-      to = dungeon::find_walkable_tile(navGrid, dungWidth, dungHeight);
+      to = dungeon::find_walkable_tile(navGrid, dungWidth, dungHeight, navState.components, from);
+    }
+    if (IsKeyPressed(KEY_TAB))
+    {
+      navState.mode = SearchMode((navState.mode + 1) % SM_NUM);
+      printf("search mode %s\n", search_mode_names[navState.mode]);
+    }
+    if (IsKeyPressed(KEY_A))
+    {
+      navState.agentSize = navState.agentSize % 3 + 1;
+      printf("agent size %dx%d\n", navState.agentSize, navState.agentSize);
+    }
+    if (IsKeyPressed(KEY_L))
+    {
+      navState.useLandmarks = !navState.useLandmarks;
+      printf("landmarks %s\n", navState.useLandmarks ? "on" : "off");
     }
     if (IsKeyPressed(KEY_UP))
     {
@@ -263,7 +350,7 @@ int main(int /*argc*/, const char ** /*argv*/)
     BeginDrawing();
       ClearBackground(BLACK);
       BeginMode2D(camera);
-        draw_nav_data(navGrid, dungWidth, dungHeight, from, to, weight);
+        draw_nav_data(navState, navGrid, dungWidth, dungHeight, from, to, weight);
       EndMode2D();
     EndDrawing();
   }
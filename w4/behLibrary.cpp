@@ -1,6 +1,7 @@
 #include "aiLibrary.h"
 #include "ecsTypes.h"
 #include "aiUtils.h"
+#include "pathFollower.h"
 #include "math.h"
 #include "raylib.h"
 #include "blackboard.h"
@@ -90,7 +91,7 @@ struct MoveToEntity : public BehNode
   BehResult update(flecs::world &, flecs::entity entity, Blackboard &bb) override
   {
     BehResult res = BEH_RUNNING;
-    entity.set([&](Action &a, const Position &pos)
+    entity.set([&](Action &a, const Position &pos, PathFollow &pf)
     {
       flecs::entity targetEntity = bb.get<flecs::entity>(entityBb);
       if (!targetEntity.is_alive())
@@ -102,7 +103,7 @@ struct MoveToEntity : public BehNode
       {
         if (pos != target_pos)
         {
-          a.action = move_towards(pos, target_pos);
+          follow_path(a, pf, target_pos);
           res = BEH_RUNNING;
         }
         else
@@ -179,7 +180,7 @@ struct Flee : public BehNode
   BehResult update(flecs::world &, flecs::entity entity, Blackboard &bb) override
   {
     BehResult res = BEH_RUNNING;
-    entity.set([&](Action &a, const Position &pos)
+    entity.set([&](Action &a, PathFollow &pf)
     {
       flecs::entity targetEntity = bb.get<flecs::entity>(entityBb);
       if (!targetEntity.is_alive())
@@ -189,7 +190,7 @@ struct Flee : public BehNode
       }
       targetEntity.get([&](const Position &target_pos)
       {
-        a.action = inverse_move(move_towards(pos, target_pos));
+        follow_path(a, pf, target_pos, true);
       });
     });
     return res;
@@ -213,11 +214,11 @@ struct Patrol : public BehNode
   BehResult update(flecs::world &, flecs::entity entity, Blackboard &bb) override
   {
     BehResult res = BEH_RUNNING;
-    entity.set([&](Action &a, const Position &pos)
+    entity.set([&](Action &a, const Position &pos, PathFollow &pf)
     {
       Position patrolPos = bb.get<Position>(pposBb);
       if (dist(pos, patrolPos) > patrolDist)
-        a.action = move_towards(pos, patrolPos);
+        follow_path(a, pf, patrolPos);
       else
         a.action = GetRandomValue(EA_MOVE_START, EA_MOVE_END - 1); // do a random walk
     });
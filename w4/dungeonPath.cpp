@@ -0,0 +1,165 @@
+#include "dungeonPath.h"
+#include "aiUtils.h"
+#include "aStar.h"
+#include "components.h"
+#include "navGrid.h"
+#include "pathCache.h"
+#include "pathDatabase.h"
+#include "whcaStar.h"
+
+constexpr uint32_t walk_layer = 0;
+// all-pairs first moves are only built for maps up to this size, larger ones search
+constexpr size_t max_path_db_tiles = 128 * 128;
+
+static nav::PathDatabase pathDb;
+static uint32_t pathDbVersion = 0;
+
+static bool use_path_db(const DungeonData &dd)
+{
+  if (dd.width * dd.height > max_path_db_tiles)
+    return false;
+  if (pathDb.width != dd.width || pathDb.height != dd.height || pathDbVersion != dd.version)
+  {
+    pathDb = nav::build_path_database(nav::GridView{dd.tiles.data(), dd.width, dd.height});
+    pathDbVersion = dd.version;
+  }
+  return true;
+}
+
+void dungeon::init_dungeon_paths(flecs::world &ecs)
+{
+  ecs.query<const DungeonData>().each([](const DungeonData &dd) { use_path_db(dd); });
+}
+
+int dungeon::path_move_towards(flecs::world &ecs, const Position &from, const Position &to)
+{
+  static auto dungeonDataQuery = ecs.query<const DungeonData, const nav::ComponentMap, const nav::NavGrid>();
+  static nav::SearchContext searchCtx;
+  static nav::PathCache pathCache;
+
+  int res = move_towards(from, to);
+  dungeonDataQuery.each([&](const DungeonData &dd, const nav::ComponentMap &components, const nav::NavGrid &ng)
+  {
+    // a target in another region would flood everything reachable before failing
+    if (!nav::is_reachable(components, nav::to_grid_pos(from), nav::to_grid_pos(to)))
+      return;
+    if (use_path_db(dd))
+    {
+      const nav::GridPos p = nav::to_grid_pos(from);
+      const uint8_t move = nav::cpd_first_move(pathDb, p, nav::to_grid_pos(to));
+      if (move != nav::cpd_no_move)
+      {
+        const nav::GridPos &offs = nav::neighbour_offsets[move];
+        res = move_towards(p, nav::GridPos{p.x + offs.x, p.y + offs.y});
+      }
+      return;
+    }
+    const std::vector<nav::GridPos> path =
+      nav::cached_path(pathCache, dd.version, nav::to_grid_pos(from), nav::to_grid_pos(to), walk_layer,
+                       [&](nav::GridPos path_from, nav::GridPos path_to)
+                       {
+                         return nav::find_path_a_star(searchCtx, ng, path_from, path_to);
+                       });
+    if (path.size() > 1)
+      res = move_towards(path[0], path[1]);
+  });
+  return res;
+}
+
+void dungeon::path_move(flecs::world &ecs, Action &a, const Position &from, const Position &to)
+{
+  a.action = path_move_towards(ecs, from, to);
+  a.hasGoal = true;
+  a.goal = to;
+}
+
+static bool is_move(int action)
+{
+  return action >= EA_MOVE_START && action < EA_MOVE_END;
+}
+
+static nav::GridPos step_pos(nav::GridPos p, int action)
+{
+  if (action == EA_MOVE_LEFT)
+    p.x--;
+  else if (action == EA_MOVE_RIGHT)
+    p.x++;
+  else if (action == EA_MOVE_UP)
+    p.y--;
+  else if (action == EA_MOVE_DOWN)
+    p.y++;
+  return p;
+}
+
+void dungeon::plan_cooperative_moves(flecs::world &ecs)
+{
+  static auto dungeonDataQuery = ecs.query<const DungeonData, const nav::NavGrid>();
+  // the same query is walked again to hand out the moves, in the same order
+  static auto actorsQuery = ecs.query<const Position, Action, const Team>();
+  static nav::CooperativeContext coopCtx;
+  static uint32_t coopVersion = 0;
+  static std::vector<int> teamAt;
+  static std::vector<nav::CooperativeAgent> agents;
+  static std::vector<nav::GridPos> blocked;
+  static std::vector<uint32_t> agentOf; // per actor in query order
+
+  dungeonDataQuery.each([&](const DungeonData &dd, const nav::NavGrid &ng)
+  {
+    if (coopVersion != dd.version)
+    {
+      nav::forget_goal_distances(coopCtx);
+      coopVersion = dd.version;
+    }
+    teamAt.assign(ng.size(), -1);
+    actorsQuery.each([&](const Position &pos, Action &, const Team &team)
+    {
+      if (ng.in_bounds(nav::to_grid_pos(pos)))
+        teamAt[ng.idx(nav::to_grid_pos(pos))] = team.team;
+    });
+
+    agents.clear();
+    blocked.clear();
+    agentOf.clear();
+    actorsQuery.each([&](flecs::entity e, const Position &pos, Action &a, const Team &team)
+    {
+      const nav::GridPos p = nav::to_grid_pos(pos);
+      const nav::GridPos next = step_pos(p, a.action);
+      agentOf.push_back(nav::no_agent);
+      if (!ng.in_bounds(p))
+        return;
+      const bool canMove = is_move(a.action) && ng.in_bounds(next) && ng.passable_at(next.x, next.y);
+      const int nextTeam = canMove ? teamAt[ng.idx(next)] : -1;
+      if (e.has<IsPlayer>())
+      {
+        // the player moves after the plan, both tiles stay taken
+        blocked.push_back(p);
+        if (canMove && nextTeam < 0)
+          blocked.push_back(next);
+        return;
+      }
+      if (!canMove || (nextTeam >= 0 && nextTeam != team.team))
+      {
+        blocked.push_back(p);
+        return;
+      }
+      // greedy and random moves have no goal past their next tile
+      agentOf.back() = uint32_t(agents.size());
+      agents.push_back(nav::CooperativeAgent{p, a.hasGoal ? nav::to_grid_pos(a.goal) : next});
+    });
+    if (agents.empty())
+      return;
+    nav::plan_cooperative(coopCtx, ng, agents, blocked);
+
+    size_t actor = 0;
+    actorsQuery.each([&](const Position &, Action &a, const Team &)
+    {
+      const uint32_t agent = actor < agentOf.size() ? agentOf[actor] : nav::no_agent;
+      actor++;
+      if (agent == nav::no_agent)
+        return;
+      const nav::GridPos from = agents[agent].from;
+      const nav::GridPos step = nav::planned_step(coopCtx, agent);
+      a.action = step == from ? EA_NOP : move_towards(from, step);
+    });
+  });
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "ecsTypes.h"
+#include <flecs.h>
+
+namespace dungeon
+{
+  // first step of a shortest path over DungeonData, falls back to a greedy
+  // move when there is no path. Small maps answer from a compressed path
+  // database, larger ones from searches cached and shared by all monsters.
+  int path_move_towards(flecs::world &ecs, const Position &from, const Position &to);
+  // the same move, and remembers the goal for plan_cooperative_moves
+  void path_move(flecs::world &ecs, Action &a, const Position &from, const Position &to);
+  // builds the path database up front instead of on the first monster turn
+  void init_dungeon_paths(flecs::world &ecs);
+  // Replans the monster moves of this turn jointly with WHCA*, so monsters
+  // walk around and behind each other instead of bumping into each other.
+  // Moves onto an enemy stay attacks, the player and monsters that attack or
+  // do not move only take their tiles.
+  void plan_cooperative_moves(flecs::world &ecs);
+};
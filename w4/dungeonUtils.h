@@ -8,5 +8,7 @@ namespace dungeon
   constexpr char floor = ' ';
 
   Position find_walkable_tile(flecs::world &ecs);
+  // only samples tiles in the same component as reachable_from
+  Position find_walkable_tile(flecs::world &ecs, Position reachable_from);
   bool is_tile_walkable(flecs::world &ecs, Position pos);
 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -76,12 +77,16 @@ enum Actions
   EA_HEAL_SELF,
   EA_PASS,
   EA_NUM,
-  EA_AUTO_EXPLORE
+  EA_AUTO_EXPLORE,
+  EA_FOLLOW_PATH // becomes the next step of PathFollow in process_path_followers
 };
 
 struct Action
 {
   int action = 0;
+  // where a move is heading, lets the cooperative planner look past the next tile
+  bool hasGoal = false;
+  Position goal;
 };
 
 struct NumActions
@@ -149,6 +154,7 @@ struct DungeonData
   std::vector<char> tiles; // for pathfinding
   size_t width;
   size_t height;
+  uint32_t version = 0; // new on every write of the tiles, cached paths are checked against it
 };
 
 struct DijkstraMapData
@@ -178,4 +184,23 @@ struct IsExplored {
 
 struct AllyMapName {
   std::string value;
-};
\ No newline at end of file
+};
+
+// Path a monster walks one step per action. Behaviours only set the target,
+// process_path_followers redoes the path once it goes stale.
+struct PathFollow
+{
+  Position target; // tile to reach, or the threat to run from
+  bool flee = false;
+  int tolerance = 2; // tiles the target may move before the path is redone
+
+  bool planned = false;
+  bool pathFlee = false;
+  Position pathTarget; // target the stored path was found for
+  Position at; // tile the next step starts from
+  Position end;
+  uint32_t next = 0;
+  uint32_t length = 0;
+  uint32_t version = 0; // DungeonData version the path was found on
+  std::vector<uint8_t> steps; // neighbour_offsets indices, four per byte
+};
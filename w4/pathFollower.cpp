@@ -0,0 +1,273 @@
+#include "pathFollower.h"
+#include "aiUtils.h"
+#include "aStar.h"
+#include "components.h"
+#include "navGrid.h"
+#include "pathCache.h"
+#include <algorithm>
+#include <cstdlib>
+
+constexpr uint32_t walk_layer = 0;
+constexpr uint32_t no_request = uint32_t(-1);
+// a flee path runs to the tile farthest from the threat within this many tiles
+constexpr int flee_radius = 6;
+
+struct PathRequest
+{
+  nav::GridPos from;
+  nav::GridPos target;
+  bool flee;
+};
+
+void follow_path(Action &a, PathFollow &pf, const Position &target, bool flee)
+{
+  a.action = EA_FOLLOW_PATH;
+  pf.target = target;
+  pf.flee = flee;
+}
+
+static uint8_t path_step(const PathFollow &pf, uint32_t i)
+{
+  return uint8_t((pf.steps[i >> 2] >> ((i & 3) * 2)) & 3u);
+}
+
+static Position step_from(const Position &pos, uint8_t dir)
+{
+  return Position{pos.x + nav::neighbour_offsets[dir].x, pos.y + nav::neighbour_offsets[dir].y};
+}
+
+static void store_path(PathFollow &pf, const std::vector<nav::GridPos> &path, const Position &pos, uint32_t version)
+{
+  pf.planned = true;
+  pf.pathFlee = pf.flee;
+  pf.pathTarget = pf.target;
+  pf.version = version;
+  pf.at = pos;
+  pf.end = path.empty() ? pos : Position{path.back().x, path.back().y};
+  pf.next = 0;
+  pf.length = path.empty() ? 0 : uint32_t(path.size() - 1);
+  pf.steps.assign((pf.length + 3) / 4, 0);
+  for (uint32_t i = 0; i < pf.length; ++i)
+  {
+    const nav::GridPos delta{path[i + 1].x - path[i].x, path[i + 1].y - path[i].y};
+    uint8_t dir = 0;
+    while (dir < 3 && nav::neighbour_offsets[dir] != delta)
+      ++dir;
+    pf.steps[i >> 2] |= uint8_t(dir << ((i & 3) * 2));
+  }
+}
+
+// moves past the step taken last turn, a blocked step leaves the follower where it was
+static void sync_with_path(PathFollow &pf, const Position &pos)
+{
+  if (pf.next < pf.length && pos == step_from(pf.at, path_step(pf, pf.next)))
+  {
+    pf.at = pos;
+    pf.next++;
+  }
+}
+
+static bool is_stale(const PathFollow &pf, const Position &pos, uint32_t version, const nav::NavGrid &ng)
+{
+  if (!pf.planned || pf.version != version || pf.flee != pf.pathFlee || !(pos == pf.at))
+    return true;
+  const uint32_t remaining = pf.length - pf.next;
+  if (pf.flee && remaining == 0)
+    return true;
+  if (remaining > 0)
+  {
+    const Position nextPos = step_from(pf.at, path_step(pf, pf.next));
+    if (!ng.passable_at(nextPos.x, nextPos.y))
+      return true;
+  }
+  // the closer the end of the path, the less the target may have moved
+  const int drift = std::abs(pf.target.x - pf.pathTarget.x) + std::abs(pf.target.y - pf.pathTarget.y);
+  return drift > std::min(pf.tolerance, int(remaining / 2));
+}
+
+// the greedy moves are kept for targets without a path
+static void set_follow_action(Action &a, const PathFollow &pf, const Position &pos)
+{
+  if (pf.next < pf.length && pos == pf.at)
+  {
+    a.action = move_towards(pos, step_from(pos, path_step(pf, pf.next)));
+    a.hasGoal = true;
+    a.goal = pf.end;
+  }
+  else if (pf.flee)
+    a.action = inverse_move(move_towards(pos, pf.target));
+  else
+    a.action = pos == pf.target ? EA_NOP : move_towards(pos, pf.target);
+}
+
+// Dijkstra around from, ending on the tile farthest from the threat, the closest such tile on ties
+static std::vector<nav::GridPos> find_flee_path(nav::SearchContext &ctx, const nav::NavGrid &ng, nav::GridPos from,
+                                                nav::GridPos threat)
+{
+  const nav::SearchLimits lim{{std::max(from.x - flee_radius, 0), std::max(from.y - flee_radius, 0)},
+                              {std::min(from.x + flee_radius + 1, int(ng.width)),
+                               std::min(from.y + flee_radius + 1, int(ng.height))}};
+  nav::begin_search(ctx, ng);
+  const size_t start = ng.idx(from);
+  nav::add_start(ctx, start, 0.f, 0.f);
+  nav::run_a_star(ctx, ng, [](size_t) { return false; }, [](size_t) { return 0.f; }, lim);
+  size_t best = start;
+  float bestDist = nav::manhattan(from, threat);
+  for (int y = lim.min.y; y < lim.max.y; ++y)
+    for (int x = lim.min.x; x < lim.max.x; ++x)
+    {
+      const size_t idx = ng.idx(nav::GridPos{x, y});
+      if (!ctx.is_closed(idx))
+        continue;
+      const float d = nav::manhattan(nav::GridPos{x, y}, threat);
+      if (d > bestDist || (d == bestDist && ctx.g[idx] < ctx.g[best]))
+      {
+        best = idx;
+        bestDist = d;
+      }
+    }
+  return ctx.reconstruct_path(ng, best);
+}
+
+// One reverse Dijkstra from the target until every follower in [begin, end)
+// is settled, their paths are the prev chains back to the target. Walking
+// from a tile into cur pays for cur, as the forward search would.
+static void find_group_paths(nav::SearchContext &ctx, const nav::NavGrid &ng, nav::GridPos target,
+                             const std::vector<PathRequest> &requests, const uint32_t *begin, const uint32_t *end,
+                             std::vector<std::vector<nav::GridPos>> &paths)
+{
+  nav::begin_search(ctx, ng);
+  nav::add_start(ctx, ng.idx(target), 0.f, 0.f);
+  size_t left = size_t(end - begin);
+  auto is_goal = [&](size_t idx)
+  {
+    for (const uint32_t *req = begin; req != end; ++req)
+      if (ng.idx(requests[*req].from) == idx)
+        left--;
+    return left == 0;
+  };
+  while (!ctx.open.empty())
+  {
+    const nav::OpenNode cur = ctx.pop();
+    if (ctx.is_closed(cur.idx) || cur.g > ctx.g[cur.idx])
+      continue;
+    ctx.close(cur.idx);
+    if (is_goal(cur.idx))
+      break;
+    const nav::GridPos p = ng.pos(cur.idx);
+    const uint8_t mask = ng.neighbour_mask(p.x, p.y);
+    for (size_t dir = 0; dir < 4; ++dir)
+    {
+      if (!(mask & (1u << dir)))
+        continue;
+      const size_t nidx = ng.idx(nav::GridPos{p.x + nav::neighbour_offsets[dir].x,
+                                              p.y + nav::neighbour_offsets[dir].y});
+      if (ctx.is_closed(nidx))
+        continue;
+      const float gScore = cur.g + ng.cost(cur.idx);
+      if (ctx.relax(nidx, cur.idx, gScore))
+        ctx.push(nidx, gScore, gScore);
+    }
+  }
+  for (const uint32_t *req = begin; req != end; ++req)
+  {
+    std::vector<nav::GridPos> &path = paths[*req];
+    const size_t from = ng.idx(requests[*req].from);
+    if (!ctx.is_closed(from))
+      continue;
+    for (uint32_t cur = uint32_t(from); cur != nav::SearchContext::no_prev; cur = ctx.prev[cur])
+      path.push_back(ng.pos(cur));
+  }
+}
+
+static void find_paths(const DungeonData &dd, const nav::ComponentMap &components, const nav::NavGrid &ng,
+                       const std::vector<PathRequest> &requests, std::vector<std::vector<nav::GridPos>> &paths)
+{
+  static nav::SearchContext searchCtx;
+  static nav::PathCache pathCache;
+  static std::vector<uint32_t> order;
+
+  paths.resize(requests.size());
+  for (std::vector<nav::GridPos> &path : paths)
+    path.clear();
+  // unreachable targets get no path, the rest are grouped by target
+  order.clear();
+  for (uint32_t i = 0; i < requests.size(); ++i)
+  {
+    const PathRequest &req = requests[i];
+    if (req.flee)
+      paths[i] = find_flee_path(searchCtx, ng, req.from, req.target);
+    else if (nav::is_reachable(components, req.from, req.target))
+      order.push_back(i);
+  }
+  std::sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs)
+  {
+    const nav::GridPos &l = requests[lhs].target;
+    const nav::GridPos &r = requests[rhs].target;
+    return l.y != r.y ? l.y < r.y : l.x < r.x;
+  });
+  for (size_t first = 0; first < order.size();)
+  {
+    const nav::GridPos target = requests[order[first]].target;
+    size_t last = first + 1;
+    while (last < order.size() && requests[order[last]].target == target)
+      ++last;
+    if (last - first == 1)
+    {
+      const PathRequest &req = requests[order[first]];
+      paths[order[first]] =
+        nav::cached_path(pathCache, dd.version, req.from, req.target, walk_layer,
+                         [&](nav::GridPos path_from, nav::GridPos path_to)
+                         {
+                           return nav::find_path_a_star(searchCtx, ng, path_from, path_to);
+                         });
+    }
+    else
+      find_group_paths(searchCtx, ng, target, requests, order.data() + first, order.data() + last, paths);
+    first = last;
+  }
+}
+
+void process_path_followers(flecs::world &ecs)
+{
+  static auto dungeonQuery = ecs.query<const DungeonData, const nav::ComponentMap, const nav::NavGrid>();
+  // walked twice in the same order, the second time to store the new paths
+  static auto followersQuery = ecs.query<const Position, Action, PathFollow>();
+  static std::vector<PathRequest> requests;
+  static std::vector<uint32_t> requestOf; // per follower in query order
+  static std::vector<std::vector<nav::GridPos>> paths;
+
+  dungeonQuery.each([&](const DungeonData &dd, const nav::ComponentMap &components, const nav::NavGrid &ng)
+  {
+    requests.clear();
+    requestOf.clear();
+    followersQuery.each([&](const Position &pos, Action &a, PathFollow &pf)
+    {
+      requestOf.push_back(no_request);
+      if (a.action != EA_FOLLOW_PATH)
+        return;
+      sync_with_path(pf, pos);
+      if (!is_stale(pf, pos, dd.version, ng))
+      {
+        set_follow_action(a, pf, pos);
+        return;
+      }
+      requestOf.back() = uint32_t(requests.size());
+      requests.push_back(PathRequest{nav::to_grid_pos(pos), nav::to_grid_pos(pf.target), pf.flee});
+    });
+    if (requests.empty())
+      return;
+    find_paths(dd, components, ng, requests, paths);
+
+    size_t follower = 0;
+    followersQuery.each([&](const Position &pos, Action &a, PathFollow &pf)
+    {
+      const uint32_t req = follower < requestOf.size() ? requestOf[follower] : no_request;
+      follower++;
+      if (req == no_request)
+        return;
+      store_path(pf, paths[req], pos, dd.version);
+      set_follow_action(a, pf, pos);
+    });
+  });
+}
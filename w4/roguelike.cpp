@@ -6,6 +6,10 @@
 #include "blackboard.h"
 #include "math.h"
 #include "dungeonUtils.h"
+#include "dungeonPath.h"
+#include "components.h"
+#include "navGrid.h"
+#include "pathFollower.h"
 #include "dijkstraMapGen.h"
 #include "dmapFollower.h"
 
@@ -128,11 +132,17 @@ static void create_minotaur_beh(flecs::entity e)
 static Position find_free_dungeon_tile(flecs::world &ecs)
 {
   static auto findMonstersQuery = ecs.query<const Position, const Hitpoints>();
+  static auto playerQuery = ecs.query<const Position, const IsPlayer>();
   bool done = false;
   while (!done)
   {
     done = true;
     Position pos = dungeon::find_walkable_tile(ecs);
+    // once there is a player only spawn where it can be reached
+    playerQuery.each([&](const Position &pp, const IsPlayer &)
+    {
+      pos = dungeon::find_walkable_tile(ecs, pp);
+    });
     findMonstersQuery.each([&](const Position &p, const Hitpoints&)
     {
       if (p == pos)
@@ -160,6 +170,7 @@ static flecs::entity create_monster(flecs::world &ecs, Color col, const char *te
     .set(Team{1})
     .set(NumActions{1, 0})
     .set(MeleeDamage{20.f})
+    .set(PathFollow{})
     .set(Blackboard{});
 }
 
@@ -362,14 +373,15 @@ void init_roguelike(flecs::world &ecs)
         UnloadTexture(texture);
       });
 
+  // the player goes first, monsters spawn in its component
+  create_player(ecs, "swordsman_tex");
+
   create_hive_monster(create_monster(ecs, Color{0xee, 0x00, 0xee, 0xff}, "minotaur_tex"));
   create_hive_monster(create_monster(ecs, Color{0xee, 0x00, 0xee, 0xff}, "minotaur_tex"));
   create_hive_monster(create_monster(ecs, Color{0x11, 0x11, 0x11, 0xff}, "minotaur_tex"));
   create_hive(create_player_fleer(create_monster(ecs, Color{0, 255, 0, 255}, "minotaur_tex")));
   create_mage(create_monster(ecs, Color{0xFF, 0xFF, 0xFF, 0xFF}, "mage_tex"));
 
-  create_player(ecs, "swordsman_tex");
-
   ecs.entity("world")
     .set(TurnCounter{})
     .set(ActionLog{});
@@ -382,13 +394,18 @@ void init_dungeon(flecs::world &ecs, char *tiles, size_t w, size_t h)
   flecs::entity floorTex = ecs.entity("floor_tex")
     .set(Texture2D{LoadTexture("assets/floor.png")});
 
+  // every write of the tiles gets a new version, paths cached for an older map are never served
+  static uint32_t dungeonVersion = 0;
   std::vector<char> dungeonData;
   dungeonData.resize(w * h);
   for (size_t y = 0; y < h; ++y)
     for (size_t x = 0; x < w; ++x)
       dungeonData[y * w + x] = tiles[y * w + x];
   ecs.entity("dungeon")
-    .set(DungeonData{dungeonData, w, h});
+    .set(nav::build_components(nav::GridView{dungeonData.data(), w, h}))
+    .set(nav::build_nav_grid(nav::GridView{dungeonData.data(), w, h}))
+    .set(DungeonData{dungeonData, w, h, ++dungeonVersion});
+  dungeon::init_dungeon_paths(ecs);
 
   for (size_t y = 0; y < h; ++y)
     for (size_t x = 0; x < w; ++x)
@@ -454,11 +471,17 @@ static void push_to_log(flecs::world &ecs, const char *msg)
   });
 }
 
+// a move not resolved yet, its MovePos is still the tile it stands on
+static bool is_pending_move(const Action &a, const Position &pos, const MovePos &mpos)
+{
+  return a.action >= EA_MOVE_START && a.action < EA_MOVE_END && mpos == pos;
+}
+
 static void process_actions(flecs::world &ecs)
 {
   static auto processActions = ecs.query<Action, Position, MovePos, const MeleeDamage, const Team>();
   static auto processHeals = ecs.query<Action, Hitpoints>();
-  static auto checkAttacks = ecs.query<const MovePos, Hitpoints, const Team>();
+  static auto checkAttacks = ecs.query<const Action, const Position, const MovePos, Hitpoints, const Team>();
   // Process all actions
   ecs.defer([&]
   {
@@ -471,32 +494,50 @@ static void process_actions(flecs::world &ecs)
       hp.hitpoints += 10.f;
 
     });
-    processActions.each([&](flecs::entity entity, Action &a, Position &pos, MovePos &mpos, const MeleeDamage &dmg, const Team &team)
+    // A move onto a teammate that has not moved yet waits for it, so monsters
+    // planned to walk in a line all step together. Moves still waiting when a
+    // pass resolves nothing are stuck in a cycle and stay put.
+    bool resolved = true;
+    while (resolved)
     {
-      Position nextPos = move_pos(pos, a.action);
-      bool blocked = !dungeon::is_tile_walkable(ecs, nextPos);
-      checkAttacks.each([&](flecs::entity enemy, const MovePos &epos, Hitpoints &hp, const Team &enemy_team)
+      resolved = false;
+      processActions.each([&](flecs::entity entity, Action &a, Position &pos, MovePos &mpos, const MeleeDamage &dmg, const Team &team)
       {
-        if (entity != enemy && epos == nextPos)
+        if (!is_pending_move(a, pos, mpos))
+          return;
+        Position nextPos = move_pos(pos, a.action);
+        bool blocked = !dungeon::is_tile_walkable(ecs, nextPos);
+        bool waits = false;
+        checkAttacks.each([&](flecs::entity enemy, const Action &ea, const Position &eppos, const MovePos &epos, Hitpoints &hp, const Team &enemy_team)
         {
-          blocked = true;
-          if (team.team != enemy_team.team)
+          if (entity != enemy && epos == nextPos)
           {
-            push_to_log(ecs, "damaged entity");
-            hp.hitpoints -= dmg.damage;
+            if (team.team == enemy_team.team && is_pending_move(ea, eppos, epos))
+            {
+              waits = true;
+              return;
+            }
+            blocked = true;
+            if (team.team != enemy_team.team)
+            {
+              push_to_log(ecs, "damaged entity");
+              hp.hitpoints -= dmg.damage;
+            }
           }
-        }
+        });
+        if (blocked)
+          a.action = EA_NOP;
+        else if (!waits)
+          mpos = nextPos;
+        resolved |= blocked || !waits;
       });
-      if (blocked)
-        a.action = EA_NOP;
-      else
-        mpos = nextPos;
-    });
+    }
     // now move
     processActions.each([&](Action &a, Position &pos, MovePos &mpos, const MeleeDamage &, const Team&)
     {
       pos = mpos;
       a.action = EA_NOP;
+      a.hasGoal = false;
     });
   });
 
@@ -601,6 +642,8 @@ void process_turn(flecs::world &ecs)
         });
         process_dmap_followers(ecs);
       });
+      process_path_followers(ecs);
+      dungeon::plan_cooperative_moves(ecs);
       turnIncrementer.each([](TurnCounter &tc) { tc.count++; });
     }
     process_actions(ecs);
@@ -1,11 +1,12 @@
 #include "dijkstraMapGen.h"
 #include "ecsTypes.h"
 #include "dungeonUtils.h"
+#include "navGrid.h"
 
 template<typename Callable>
 static void query_dungeon_data(flecs::world &ecs, Callable c)
 {
-  static auto dungeonDataQuery = ecs.query<const DungeonData>();
+  static auto dungeonDataQuery = ecs.query<const DungeonData, const nav::NavGrid>();
 
   dungeonDataQuery.each(c);
 }
@@ -28,18 +29,19 @@ static void init_tiles(std::vector<float> &map, const DungeonData &dd)
 }
 
 // scan version, could be implemented as Dijkstra version as well
-static void process_dmap(std::vector<float> &map, const DungeonData &dd)
+// the nav grid border reads as wall, so neighbours need no bounds checks
+static void process_dmap(std::vector<float> &map, const DungeonData &dd, const nav::NavGrid &ng)
 {
   bool done = false;
-  auto getMapAt = [&](size_t x, size_t y, float def)
+  auto getMapAt = [&](int x, int y, float def)
   {
-    if (x < dd.width && y < dd.width && dd.tiles[y * dd.width + x] == dungeon::floor)
-      return map[y * dd.width + x];
+    if (ng.passable_at(x, y))
+      return map[size_t(y) * dd.width + size_t(x)];
     return def;
   };
-  auto getMinNei = [&](size_t x, size_t y)
+  auto getMinNei = [&](int x, int y)
   {
-    float val = map[y * dd.width + x];
+    float val = map[size_t(y) * dd.width + size_t(x)];
     val = std::min(val, getMapAt(x - 1, y + 0, val));
     val = std::min(val, getMapAt(x + 1, y + 0, val));
     val = std::min(val, getMapAt(x + 0, y - 1, val));
@@ -49,11 +51,11 @@ static void process_dmap(std::vector<float> &map, const DungeonData &dd)
   while (!done)
   {
     done = true;
-    for (size_t y = 0; y < dd.height; ++y)
-      for (size_t x = 0; x < dd.width; ++x)
+    for (int y = 0; y < int(dd.height); ++y)
+      for (int x = 0; x < int(dd.width); ++x)
       {
-        const size_t i = y * dd.width + x;
-        if (dd.tiles[i] != dungeon::floor)
+        const size_t i = size_t(y) * dd.width + size_t(x);
+        if (!ng.passable_at(x, y))
           continue;
         const float myVal = getMapAt(x, y, invalid_tile_value);
         const float minVal = getMinNei(x, y);
@@ -68,7 +70,7 @@ static void process_dmap(std::vector<float> &map, const DungeonData &dd)
 
 void dmaps::gen_player_approach_map(flecs::world &ecs, std::vector<float> &map)
 {
-  query_dungeon_data(ecs, [&](const DungeonData &dd)
+  query_dungeon_data(ecs, [&](const DungeonData &dd, const nav::NavGrid &ng)
   {
     init_tiles(map, dd);
     query_characters_positions(ecs, [&](const Position &pos, const Team &t)
@@ -76,7 +78,7 @@ void dmaps::gen_player_approach_map(flecs::world &ecs, std::vector<float> &map)
       if (t.team == 0) // player team hardcode
         map[pos.y * dd.width + pos.x] = 0.f;
     });
-    process_dmap(map, dd);
+    process_dmap(map, dd, ng);
   });
 }
 
@@ -86,23 +88,23 @@ void dmaps::gen_player_flee_map(flecs::world &ecs, std::vector<float> &map)
   for (float &v : map)
     if (v < invalid_tile_value)
       v *= -1.2f;
-  query_dungeon_data(ecs, [&](const DungeonData &dd)
+  query_dungeon_data(ecs, [&](const DungeonData &dd, const nav::NavGrid &ng)
   {
-    process_dmap(map, dd);
+    process_dmap(map, dd, ng);
   });
 }
 
 void dmaps::gen_hive_pack_map(flecs::world &ecs, std::vector<float> &map)
 {
   static auto hiveQuery = ecs.query<const Position, const Hive>();
-  query_dungeon_data(ecs, [&](const DungeonData &dd)
+  query_dungeon_data(ecs, [&](const DungeonData &dd, const nav::NavGrid &ng)
   {
     init_tiles(map, dd);
     hiveQuery.each([&](const Position &pos, const Hive &)
     {
       map[pos.y * dd.width + pos.x] = 0.f;
     });
-    process_dmap(map, dd);
+    process_dmap(map, dd, ng);
   });
 }
 
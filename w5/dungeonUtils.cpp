@@ -1,5 +1,6 @@
 #include "dungeonUtils.h"
 #include "raylib.h"
+#include "components.h"
 
 Position dungeon::find_walkable_tile(flecs::world &ecs)
 {
@@ -20,6 +21,31 @@ Position dungeon::find_walkable_tile(flecs::world &ecs)
   return res;
 }
 
+Position dungeon::find_walkable_tile(flecs::world &ecs, Position reachable_from)
+{
+  static auto dungeonQuery = ecs.query<const DungeonData, const nav::ComponentMap>();
+
+  Position res = reachable_from;
+  bool found = false;
+  dungeonQuery.each([&](const DungeonData &dd, const nav::ComponentMap &components)
+  {
+    const uint32_t comp = nav::component_of(components, nav::to_grid_pos(reachable_from));
+    if (comp == nav::ComponentMap::no_component)
+      return;
+    std::vector<Position> posList;
+    for (size_t y = 0; y < dd.height; ++y)
+      for (size_t x = 0; x < dd.width; ++x)
+        if (dd.tiles[y * dd.width + x] == dungeon::floor &&
+            nav::component_of(components, nav::GridPos{int(x), int(y)}) == comp)
+          posList.push_back(Position{int(x), int(y)});
+    if (posList.empty())
+      return;
+    found = true;
+    res = posList[size_t(GetRandomValue(0, int(posList.size()) - 1))];
+  });
+  return found ? res : find_walkable_tile(ecs);
+}
+
 bool dungeon::is_tile_walkable(flecs::world &ecs, Position pos)
 {
   static auto dungeonDataQuery = ecs.query<const DungeonData>();
@@ -0,0 +1,10 @@
+#pragma once
+#include "ecsTypes.h"
+#include <flecs.h>
+
+// behaviours call this instead of picking a move, the move is filled in later this turn
+void follow_path(Action &a, PathFollow &pf, const Position &target, bool flee = false);
+// Once per turn after the behaviours: stale paths are redone in one batch,
+// followers chasing the same target share a single reverse search, then every
+// EA_FOLLOW_PATH becomes the next step of its path.
+void process_path_followers(flecs::world &ecs);
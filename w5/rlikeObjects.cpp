@@ -12,11 +12,17 @@ flecs::entity create_hive(flecs::entity e)
 static Position find_free_dungeon_tile(flecs::world &ecs)
 {
   static auto findMonstersQuery = ecs.query<const Position, const Hitpoints>();
+  static auto playerQuery = ecs.query<const Position, const IsPlayer>();
   bool done = false;
   while (!done)
   {
     done = true;
     Position pos = dungeon::find_walkable_tile(ecs);
+    // once there is a player only spawn where it can be reached
+    playerQuery.each([&](const Position &pp, const IsPlayer &)
+    {
+      pos = dungeon::find_walkable_tile(ecs, pp);
+    });
     findMonstersQuery.each([&](const Position &p, const Hitpoints&)
     {
       if (p == pos)
@@ -43,6 +49,7 @@ flecs::entity create_monster(flecs::world &ecs, Color col, const char *texture_s
     .set(Team{1})
     .set(NumActions{1, 0})
     .set(MeleeDamage{20.f})
+    .set(PathFollow{})
     .set(Blackboard{});
 }
 
@@ -2,12 +2,16 @@
 
 #include "aiLibrary.h"
 #include "blackboard.h"
+#include "components.h"
 #include "dijkstraMapGen.h"
 #include "dmapBeh.h"
 #include "dmapFollower.h"
+#include "dungeonPath.h"
 #include "dungeonUtils.h"
 #include "ecsTypes.h"
 #include "math.h"
+#include "navGrid.h"
+#include "pathFollower.h"
 #include "raylib.h"
 #include "rlikeObjects.h"
 #include "stateMachine.h"
@@ -125,6 +129,9 @@ void init_roguelike(flecs::world &ecs) {
     UnloadTexture(texture);
   });
 
+  // the player goes first, monsters spawn in its component
+  create_player(ecs, "swordsman_tex");
+
   create_hive_monster(
       create_monster(ecs, Color{0xee, 0x00, 0xee, 0xff}, "minotaur_tex"));
   create_hive_monster(
@@ -134,8 +141,6 @@ void init_roguelike(flecs::world &ecs) {
   create_hive(create_player_fleer(
       create_monster(ecs, Color{0, 255, 0, 255}, "minotaur_tex")));
 
-  create_player(ecs, "swordsman_tex");
-
   ecs.entity("world").set(TurnCounter{}).set(ActionLog{});
 }
 
@@ -145,11 +150,17 @@ void init_dungeon(flecs::world &ecs, char *tiles, size_t w, size_t h) {
   flecs::entity floorTex =
       ecs.entity("floor_tex").set(Texture2D{LoadTexture("assets/floor.png")});
 
+  // every write of the tiles gets a new version, paths cached for an older map are never served
+  static uint32_t dungeonVersion = 0;
   std::vector<char> dungeonData;
   dungeonData.resize(w * h);
   for (size_t y = 0; y < h; ++y)
     for (size_t x = 0; x < w; ++x) dungeonData[y * w + x] = tiles[y * w + x];
-  ecs.entity("dungeon").set(DungeonData{dungeonData, w, h});
+  ecs.entity("dungeon")
+      .set(nav::build_components(nav::GridView{dungeonData.data(), w, h}))
+      .set(nav::build_nav_grid(nav::GridView{dungeonData.data(), w, h}))
+      .set(DungeonData{dungeonData, w, h, ++dungeonVersion});
+  dungeon::init_dungeon_paths(ecs);
 
   for (size_t y = 0; y < h; ++y)
     for (size_t x = 0; x < w; ++x) {
@@ -204,11 +215,18 @@ static void push_to_log(flecs::world &ecs, const char *msg) {
   });
 }
 
+// a move not resolved yet, its MovePos is still the tile it stands on
+static bool is_pending_move(const Action &a, const Position &pos,
+                            const MovePos &mpos) {
+  return a.action >= EA_MOVE_START && a.action < EA_MOVE_END && mpos == pos;
+}
+
 static void process_actions(flecs::world &ecs) {
   static auto processActions =
       ecs.query<Action, Position, MovePos, const MeleeDamage, const Team>();
   static auto processHeals = ecs.query<Action, Hitpoints>();
-  static auto checkAttacks = ecs.query<const MovePos, Hitpoints, const Team>();
+  static auto checkAttacks = ecs.query<const Action, const Position,
+                                       const MovePos, Hitpoints, const Team>();
   // Process all actions
   ecs.defer([&] {
     processHeals.each([&](Action &a, Hitpoints &hp) {
@@ -217,31 +235,48 @@ static void process_actions(flecs::world &ecs) {
       push_to_log(ecs, "Monster healed itself");
       hp.hitpoints += 10.f;
     });
-    processActions.each([&](flecs::entity entity, Action &a, Position &pos,
-                            MovePos &mpos, const MeleeDamage &dmg,
-                            const Team &team) {
-      Position nextPos = move_pos(pos, a.action);
-      bool blocked = !dungeon::is_tile_walkable(ecs, nextPos);
-      checkAttacks.each([&](flecs::entity enemy, const MovePos &epos,
-                            Hitpoints &hp, const Team &enemy_team) {
-        if (entity != enemy && epos == nextPos) {
-          blocked = true;
-          if (team.team != enemy_team.team) {
-            push_to_log(ecs, "damaged entity");
-            hp.hitpoints -= dmg.damage;
+    // A move onto a teammate that has not moved yet waits for it, so monsters
+    // planned to walk in a line all step together. Moves still waiting when a
+    // pass resolves nothing are stuck in a cycle and stay put.
+    bool resolved = true;
+    while (resolved) {
+      resolved = false;
+      processActions.each([&](flecs::entity entity, Action &a, Position &pos,
+                              MovePos &mpos, const MeleeDamage &dmg,
+                              const Team &team) {
+        if (!is_pending_move(a, pos, mpos)) return;
+        Position nextPos = move_pos(pos, a.action);
+        bool blocked = !dungeon::is_tile_walkable(ecs, nextPos);
+        bool waits = false;
+        checkAttacks.each([&](flecs::entity enemy, const Action &ea,
+                              const Position &eppos, const MovePos &epos,
+                              Hitpoints &hp, const Team &enemy_team) {
+          if (entity != enemy && epos == nextPos) {
+            if (team.team == enemy_team.team &&
+                is_pending_move(ea, eppos, epos)) {
+              waits = true;
+              return;
+            }
+            blocked = true;
+            if (team.team != enemy_team.team) {
+              push_to_log(ecs, "damaged entity");
+              hp.hitpoints -= dmg.damage;
+            }
           }
-        }
+        });
+        if (blocked)
+          a.action = EA_NOP;
+        else if (!waits)
+          mpos = nextPos;
+        resolved |= blocked || !waits;
       });
-      if (blocked)
-        a.action = EA_NOP;
-      else
-        mpos = nextPos;
-    });
+    }
     // now move
     processActions.each([&](Action &a, Position &pos, MovePos &mpos,
                             const MeleeDamage &, const Team &) {
       pos = mpos;
       a.action = EA_NOP;
+      a.hasGoal = false;
     });
   });
 
@@ -325,6 +360,8 @@ void process_turn(flecs::world &ecs) {
                                Blackboard &bb) { bt.update(ecs, e, bb); });
         process_dmap_followers(ecs);
       });
+      process_path_followers(ecs);
+      dungeon::plan_cooperative_moves(ecs);
       turnIncrementer.each([](TurnCounter &tc) { tc.count++; });
     }
     process_actions(ecs);
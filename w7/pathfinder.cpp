@@ -1,241 +1,154 @@
 #include "pathfinder.h"
-#include "dungeonUtils.h"
-#include "math.h"
+#include "hierarchicalSearch.h"
+#include "thetaStar.h"
 #include <algorithm>
 
-float heuristic(IVec2 lhs, IVec2 rhs)
-{
-  return sqrtf(sqr(float(lhs.x - rhs.x)) + sqr(float(lhs.y - rhs.y)));
-};
+// tiles of the field looked ahead for a straight line, bounds the line tests per seeker
+constexpr int flow_lookahead = 12;
+// main thread search time per frame when there is no core to spare for workers
+constexpr size_t path_sync_budget_us = 2000;
+constexpr size_t path_slice_us = 1000;
+// lazy Theta* searches per frame for agents left without waypoints while theirs is pending
+constexpr int sync_waypoint_searches = 2;
+constexpr const char *portals_cache_path = "dungeon_portals.bin";
+
+static nav::PathService path_service;
+static int sync_searches_left = 0;
 
-template<typename T>
-static size_t coord_to_idx(T x, T y, size_t w)
+static Position tile_to_world(nav::GridPos p)
 {
-  return size_t(y) * w + size_t(x);
+  return Position{float(p.x) * tile_size, float(p.y) * tile_size};
 }
 
-static std::vector<IVec2> reconstruct_path(std::vector<IVec2> prev, IVec2 to, size_t width)
+void prebuild_map(flecs::world &ecs)
 {
-  IVec2 curPos = to;
-  std::vector<IVec2> res = {curPos};
-  while (prev[coord_to_idx(curPos.x, curPos.y, width)] != IVec2{-1, -1})
+  auto mapQuery = ecs.query<const DungeonData>();
+
+  constexpr size_t splitTiles = 10;
+  ecs.defer([&]()
   {
-    curPos = prev[coord_to_idx(curPos.x, curPos.y, width)];
-    res.insert(res.begin(), curPos);
-  }
-  return res;
+    mapQuery.each([&](flecs::entity e, const DungeonData &dd)
+    {
+      const nav::GridView grid{dd.tiles.data(), dd.width, dd.height};
+      // the graph of the same map is read back from the last run, anything else rebuilds and replaces it
+      DungeonPortals dp;
+      if (!nav::load_portals(dp, grid, splitTiles, portals_cache_path))
+      {
+        dp = nav::build_portals(grid, splitTiles);
+        nav::save_portals(dp, grid, portals_cache_path);
+      }
+      e.set(std::move(dp));
+      e.set(FlowField{});
+      e.set(nav::build_components(grid));
+      const nav::NavGrid ng = nav::build_nav_grid(grid);
+      nav::set_path_service_map(path_service, ng);
+      e.set(ng);
+    });
+  });
+  // one core stays with the frame, on a single core searches run in sync_paths within its budget
+  const size_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+  nav::start_path_service(path_service, cores - 1, path_slice_us);
 }
 
-static std::vector<IVec2> find_path_a_star(const DungeonData &dd, IVec2 from, IVec2 to,
-                                           IVec2 lim_min, IVec2 lim_max)
+std::vector<IVec2> find_hierarchical_path(const DungeonData &dd, const DungeonPortals &dp, const DungeonComponents &dc,
+                                          IVec2 from, IVec2 to, uint8_t agent_size)
 {
-  if (from.x < 0 || from.y < 0 || from.x >= int(dd.width) || from.y >= int(dd.height))
+  static nav::HierarchicalContext ctx;
+  if (!nav::is_reachable(dc, nav::to_grid_pos(from), nav::to_grid_pos(to)))
     return std::vector<IVec2>();
-  size_t inpSize = dd.width * dd.height;
-
-  std::vector<float> g(inpSize, std::numeric_limits<float>::max());
-  std::vector<float> f(inpSize, std::numeric_limits<float>::max());
-  std::vector<IVec2> prev(inpSize, {-1,-1});
-
-  auto getG = [&](IVec2 p) -> float { return g[coord_to_idx(p.x, p.y, dd.width)]; };
-  auto getF = [&](IVec2 p) -> float { return f[coord_to_idx(p.x, p.y, dd.width)]; };
-
-  g[coord_to_idx(from.x, from.y, dd.width)] = 0;
-  f[coord_to_idx(from.x, from.y, dd.width)] = heuristic(from, to);
+  const nav::GridView grid{dd.tiles.data(), dd.width, dd.height};
+  return nav::convert_path<IVec2>(
+    nav::find_path_hierarchical(ctx, grid, dp, nav::to_grid_pos(from), nav::to_grid_pos(to), agent_size));
+}
 
-  std::vector<IVec2> openList = {from};
-  std::vector<IVec2> closedList;
+std::vector<Position> find_waypoints(const NavGrid &ng, const DungeonComponents &dc, const Position &from,
+                                     const Position &to)
+{
+  static nav::SearchContext ctx;
+  const nav::GridPos fromTile = nav::to_grid_pos(world_to_tile(from));
+  const nav::GridPos toTile = nav::to_grid_pos(world_to_tile(to));
+  if (!nav::is_reachable(dc, fromTile, toTile))
+    return std::vector<Position>();
+  std::vector<Position> res;
+  for (const nav::GridPos &p : nav::find_path_lazy_theta_star(ctx, ng, fromTile, toTile))
+    res.push_back(tile_to_world(p));
+  return res;
+}
 
-  while (!openList.empty())
-  {
-    size_t bestIdx = 0;
-    float bestScore = getF(openList[0]);
-    for (size_t i = 1; i < openList.size(); ++i)
-    {
-      float score = getF(openList[i]);
-      if (score < bestScore)
-      {
-        bestIdx = i;
-        bestScore = score;
-      }
-    }
-    if (openList[bestIdx] == to)
-      return reconstruct_path(prev, to, dd.width);
-    IVec2 curPos = openList[bestIdx];
-    openList.erase(openList.begin() + bestIdx);
-    if (std::find(closedList.begin(), closedList.end(), curPos) != closedList.end())
-      continue;
-    size_t idx = coord_to_idx(curPos.x, curPos.y, dd.width);
-    closedList.emplace_back(curPos);
-    auto checkNeighbour = [&](IVec2 p)
-    {
-      // out of bounds
-      if (p.x < lim_min.x || p.y < lim_min.y || p.x >= lim_max.x || p.y >= lim_max.y)
-        return;
-      size_t idx = coord_to_idx(p.x, p.y, dd.width);
-      // not empty
-      if (dd.tiles[idx] == dungeon::wall)
-        return;
-      float edgeWeight = 1.f;
-      float gScore = getG(curPos) + 1.f * edgeWeight; // we're exactly 1 unit away
-      if (gScore < getG(p))
-      {
-        prev[idx] = curPos;
-        g[idx] = gScore;
-        f[idx] = gScore + heuristic(p, to);
-      }
-      bool found = std::find(openList.begin(), openList.end(), p) != openList.end();
-      if (!found)
-        openList.emplace_back(p);
-    };
-    checkNeighbour({curPos.x + 1, curPos.y + 0});
-    checkNeighbour({curPos.x - 1, curPos.y + 0});
-    checkNeighbour({curPos.x + 0, curPos.y + 1});
-    checkNeighbour({curPos.x + 0, curPos.y - 1});
-  }
-  // empty path
-  return std::vector<IVec2>();
+bool find_waypoints_now(const NavGrid &ng, const DungeonComponents &dc, const Position &from, const Position &to,
+                        std::vector<Position> &out)
+{
+  if (sync_searches_left <= 0)
+    return false;
+  sync_searches_left--;
+  out = find_waypoints(ng, dc, from, to);
+  return true;
 }
 
+std::vector<Position> smooth_path(const NavGrid &ng, const std::vector<IVec2> &path)
+{
+  std::vector<nav::GridPos> tiles;
+  tiles.reserve(path.size());
+  for (const IVec2 &p : path)
+    tiles.push_back(nav::to_grid_pos(p));
+  std::vector<Position> res;
+  for (const nav::GridPos &p : nav::string_pull(ng, tiles))
+    res.push_back(tile_to_world(p));
+  return res;
+}
 
-void prebuild_map(flecs::world &ecs)
+nav::PathHandle request_waypoints(const Position &from, const Position &to, int priority)
 {
-  auto mapQuery = ecs.query<const DungeonData>();
+  return nav::request_path(path_service, nav::to_grid_pos(world_to_tile(from)), nav::to_grid_pos(world_to_tile(to)),
+                           priority, true);
+}
 
-  constexpr size_t splitTiles = 10;
-  ecs.defer([&]()
-  {
-    mapQuery.each([&](flecs::entity e, const DungeonData &dd)
-    {
-      // go through each super tile
-      const size_t width = dd.width / splitTiles;
-      const size_t height = dd.height / splitTiles;
+void cancel_waypoints(nav::PathHandle handle)
+{
+  nav::cancel_path(path_service, handle);
+}
 
-      auto check_border = [&](size_t xx, size_t yy,
-                              size_t dir_x, size_t dir_y,
-                              int offs_x, int offs_y,
-                              std::vector<PathPortal> &portals)
-      {
-        int spanFrom = -1;
-        int spanTo = -1;
-        for (size_t i = 0; i < splitTiles; ++i)
-        {
-          size_t x = xx * splitTiles + i * dir_x;
-          size_t y = yy * splitTiles + i * dir_y;
-          size_t nx = x + offs_x;
-          size_t ny = y + offs_y;
-          if (dd.tiles[y * dd.width + x] != dungeon::wall &&
-              dd.tiles[ny * dd.width + nx] != dungeon::wall)
-          {
-            if (spanFrom < 0)
-              spanFrom = i;
-            spanTo = i;
-          }
-          else if (spanFrom >= 0)
-          {
-            // write span
-            portals.push_back({xx * splitTiles + spanFrom * dir_x + offs_x,
-                               yy * splitTiles + spanFrom * dir_y + offs_y,
-                               xx * splitTiles + spanTo * dir_x,
-                               yy * splitTiles + spanTo * dir_y});
-            spanFrom = -1;
-          }
-        }
-        if (spanFrom >= 0)
-        {
-          portals.push_back({xx * splitTiles + spanFrom * dir_x + offs_x,
-                             yy * splitTiles + spanFrom * dir_y + offs_y,
-                             xx * splitTiles + spanTo * dir_x,
-                             yy * splitTiles + spanTo * dir_y});
-        }
-      };
+void sync_paths()
+{
+  sync_searches_left = sync_waypoint_searches;
+  nav::sync_path_service(path_service, path_sync_budget_us);
+}
 
-      std::vector<PathPortal> portals;
-      std::vector<std::vector<size_t>> tilePortalsIndices;
+nav::PathStatus take_waypoints(nav::PathHandle handle, std::vector<Position> &out)
+{
+  std::vector<nav::GridPos> path;
+  const nav::PathStatus status = nav::take_path(path_service, handle, path);
+  if (status != nav::PathStatus::Found && status != nav::PathStatus::NoPath)
+    return status;
+  out.clear();
+  for (const nav::GridPos &p : path)
+    out.push_back(tile_to_world(p));
+  return status;
+}
 
-      auto push_portals = [&](size_t x, size_t y,
-                              int offs_x, int offs_y,
-                              const std::vector<PathPortal> &new_portals)
-      {
-        for (const PathPortal &portal : new_portals)
-        {
-          size_t idx = portals.size();
-          portals.push_back(portal);
-          tilePortalsIndices[y * width + x].push_back(idx);
-          tilePortalsIndices[(y + offs_y) * width + x + offs_x].push_back(idx);
-        }
-      };
-      for (size_t y = 0; y < height; ++y)
-        for (size_t x = 0; x < width; ++x)
-        {
-          tilePortalsIndices.push_back(std::vector<size_t>{});
-          // check top
-          if (y > 0)
-          {
-            std::vector<PathPortal> topPortals;
-            check_border(x, y, 1, 0, 0, -1, topPortals);
-            push_portals(x, y, 0, -1, topPortals);
-          }
-          // left
-          if (x > 0)
-          {
-            std::vector<PathPortal> leftPortals;
-            check_border(x, y, 0, 1, -1, 0, leftPortals);
-            push_portals(x, y, -1, 0, leftPortals);
-          }
-        }
-      for (size_t tidx = 0; tidx < tilePortalsIndices.size(); ++tidx)
-      {
-        const std::vector<size_t> &indices = tilePortalsIndices[tidx];
-        size_t x = tidx % width;
-        size_t y = tidx / width;
-        IVec2 limMin{int((x + 0) * splitTiles), int((y + 0) * splitTiles)};
-        IVec2 limMax{int((x + 1) * splitTiles), int((y + 1) * splitTiles)};
-        for (size_t i = 0; i < indices.size(); ++i)
-        {
-          PathPortal &firstPortal = portals[indices[i]];
-          for (size_t j = i + 1; j < indices.size(); ++j)
-          {
-            PathPortal &secondPortal = portals[indices[j]];
-            // check path from i to j
-            // check each position (to find closest dist) (could be made more optimal)
-            bool noPath = false;
-            size_t minDist = 0xffffffff;
-            for (size_t fromY = std::max(firstPortal.startY, size_t(limMin.y));
-                        fromY <= std::min(firstPortal.endY, size_t(limMax.y - 1)) && !noPath; ++fromY)
-            {
-              for (size_t fromX = std::max(firstPortal.startX, size_t(limMin.x));
-                          fromX <= std::min(firstPortal.endX, size_t(limMax.x - 1)) && !noPath; ++fromX)
-              {
-                for (size_t toY = std::max(secondPortal.startY, size_t(limMin.y));
-                            toY <= std::min(secondPortal.endY, size_t(limMax.y - 1)) && !noPath; ++toY)
-                {
-                  for (size_t toX = std::max(secondPortal.startX, size_t(limMin.x));
-                              toX <= std::min(secondPortal.endX, size_t(limMax.x - 1)) && !noPath; ++toX)
-                  {
-                    IVec2 from{int(fromX), int(fromY)};
-                    IVec2 to{int(toX), int(toY)};
-                    std::vector<IVec2> path = find_path_a_star(dd, from, to, limMin, limMax);
-                    if (path.empty() && from != to)
-                    {
-                      noPath = true; // if we found that there's no path at all - we can break out
-                      break;
-                    }
-                    minDist = std::min(minDist, path.size());
-                  }
-                }
-              }
-            }
-            // write pathable data and length
-            if (noPath)
-              continue;
-            firstPortal.conns.push_back({indices[j], float(minDist)});
-            secondPortal.conns.push_back({indices[i], float(minDist)});
-          }
-        }
-      }
-      e.set(DungeonPortals{splitTiles, portals, tilePortalsIndices});
-    });
-  });
+void update_flow_field(FlowField &ff, const DungeonData &dd, const Position &target)
+{
+  const nav::GridView grid{dd.tiles.data(), dd.width, dd.height};
+  nav::update_flow_field(ff, grid, nav::to_grid_pos(world_to_tile(target)));
 }
 
+Position flow_steer_target(const FlowField &ff, const NavGrid &ng, const Position &from, const Position &target)
+{
+  const nav::GridPos start = nav::to_grid_pos(world_to_tile(from));
+  nav::GridPos dir = nav::flow_dir(ff, start);
+  if (dir.x == 0 && dir.y == 0)
+    return target;
+  // the next tile is always taken, past it the field is string pulled so the agent cuts across
+  nav::GridPos best{start.x + dir.x, start.y + dir.y};
+  for (int i = 1; i < flow_lookahead; ++i)
+  {
+    dir = nav::flow_dir(ff, best);
+    if (dir.x == 0 && dir.y == 0)
+      return target;
+    const nav::GridPos next{best.x + dir.x, best.y + dir.y};
+    if (!nav::has_clear_line(ng, start, next))
+      break;
+    best = next;
+  }
+  return tile_to_world(best);
+}
@@ -1,26 +1,69 @@
 #pragma once
 #include <flecs.h>
 #include <vector>
+#include "ecsTypes.h"
+#include "math.h"
+#include "portalGraph.h"
+#include "flowField.h"
+#include "components.h"
+#include "navGrid.h"
+#include "pathService.h"
 
-struct PortalConnection
-{
-  size_t connIdx;
-  float score;
-};
+using PortalConnection = nav::PortalConnection;
+using PathPortal = nav::PathPortal;
+using DungeonPortals = nav::DungeonPortals;
+using FlowField = nav::FlowField;
+using DungeonComponents = nav::ComponentMap;
+using NavGrid = nav::NavGrid;
 
-struct PathPortal
+constexpr float tile_size = 64.f;
+
+// waypoints from the path service, an agent steers at points[next]
+struct WaypointPath
 {
-  size_t startX, startY;
-  size_t endX, endY;
-  std::vector<PortalConnection> conns;
+  nav::PathHandle request = nav::invalid_path_handle;
+  IVec2 requestTo = IVec2{0, 0}; // target tile of the pending request
+  std::vector<Position> points;
+  size_t next = 0;
+  float repathIn = 0.f; // seconds until the next request
 };
 
-struct DungeonPortals
+// positions are top left corners of tile sized sprites
+inline IVec2 world_to_tile(const Position &p)
 {
-  size_t tileSplit;
-  std::vector<PathPortal> portals;
-  std::vector<std::vector<size_t>> tilePortalsIndices;
-};
+  return IVec2{int(floorf((p.x + tile_size * 0.5f) / tile_size)), int(floorf((p.y + tile_size * 0.5f) / tile_size))};
+}
 
 void prebuild_map(flecs::world &ecs);
 
+// empty without searching if the ends are in different components,
+// agents of agent_size x agent_size tiles are anchored at their top left tile
+std::vector<IVec2> find_hierarchical_path(const DungeonData &dd, const DungeonPortals &dp, const DungeonComponents &dc,
+                                          IVec2 from, IVec2 to, uint8_t agent_size = 1);
+
+// Lazy Theta* waypoints in world space, a handful of straight segments instead of
+// one point per tile. Empty if the ends are in different components.
+std::vector<Position> find_waypoints(const NavGrid &ng, const DungeonComponents &dc, const Position &from,
+                                     const Position &to);
+// find_waypoints for an agent whose request is still pending, only a couple of
+// these run per frame so a spawn burst stays on the workers, false once they are used up
+bool find_waypoints_now(const NavGrid &ng, const DungeonComponents &dc, const Position &from, const Position &to,
+                        std::vector<Position> &out);
+// the hierarchical path string pulled into waypoints
+std::vector<Position> smooth_path(const NavGrid &ng, const std::vector<IVec2> &path);
+
+// Paths computed off the main thread: a request returns a handle right away and
+// the string pulled waypoints show up after a later sync_paths. sync_paths is
+// the only place results are published, it runs once per frame before the
+// gameplay systems.
+nav::PathHandle request_waypoints(const Position &from, const Position &to, int priority);
+void cancel_waypoints(nav::PathHandle handle);
+void sync_paths();
+// Pending leaves out untouched
+nav::PathStatus take_waypoints(nav::PathHandle handle, std::vector<Position> &out);
+
+// moves the field goal to the target's tile, cheap when the target only stepped to a neighbour tile
+void update_flow_field(FlowField &ff, const DungeonData &dd, const Position &target);
+// farthest tile along the field reachable in a straight line, the target itself
+// once it is in sight at the end of the field or the agent is off the field
+Position flow_steer_target(const FlowField &ff, const NavGrid &ng, const Position &from, const Position &target);
@@ -7,8 +7,6 @@
 #include "dungeonUtils.h"
 #include "pathfinder.h"
 
-constexpr float tile_size = 64.f;
-
 static void register_roguelike_systems(flecs::world &ecs)
 {
   static auto playerPosQuery = ecs.query<const Position, const IsPlayer>();
@@ -79,32 +77,30 @@ static void register_roguelike_systems(flecs::world &ecs)
     });
 
   static auto cameraQuery = ecs.query<const Camera2D>();
-  ecs.system<const DungeonPortals, const DungeonData>()
-    .each([&](const DungeonPortals &dp, const DungeonData &dd)
+  ecs.system<const DungeonPortals, const DungeonData, const DungeonComponents, const NavGrid>()
+    .each([&](const DungeonPortals &dp, const DungeonData &dd, const DungeonComponents &dc, const NavGrid &ng)
     {
-      size_t w = dd.width;
       size_t ts = dp.tileSplit;
-      for (size_t y = 0; y < dd.height / ts; ++y)
+      for (size_t y = 0; y < dp.numClustersY; ++y)
         DrawLineEx(Vector2{0.f, y * ts * tile_size},
                    Vector2{dd.width * tile_size, y * ts * tile_size}, 1.f, GetColor(0xff000080));
-      for (size_t x = 0; x < dd.width / ts; ++x)
+      for (size_t x = 0; x < dp.numClustersX; ++x)
         DrawLineEx(Vector2{x * ts * tile_size, 0.f},
                    Vector2{x * ts * tile_size, dd.height * tile_size}, 1.f, GetColor(0xff000080));
       cameraQuery.each([&](Camera2D cam)
       {
         Vector2 mousePosition = GetScreenToWorld2D(GetMousePosition(), cam);
-        size_t wd = w / ts;
-        for (size_t y = 0; y < dd.height / ts; ++y)
+        for (size_t y = 0; y < dp.numClustersY; ++y)
         {
           if (mousePosition.y < y * ts * tile_size || mousePosition.y > (y + 1) * ts * tile_size)
             continue;
-          for (size_t x = 0; x < dd.width / ts; ++x)
+          for (size_t x = 0; x < dp.numClustersX; ++x)
           {
             if (mousePosition.x < x * ts * tile_size || mousePosition.x > (x + 1) * ts * tile_size)
               continue;
-            for (size_t idx : dp.tilePortalsIndices[y * wd + x])
+            for (uint32_t idx : nav::cluster_portals(dp, y * dp.numClustersX + x))
             {
-              const PathPortal &portal = dp.portals[idx];
+              const PathPortal portal = nav::get_portal(dp, idx);
               Rectangle rect{portal.startX * tile_size, portal.startY * tile_size,
                              (portal.endX - portal.startX + 1) * tile_size,
                              (portal.endY - portal.startY + 1) * tile_size};
@@ -112,8 +108,9 @@ static void register_roguelike_systems(flecs::world &ecs)
             }
           }
         }
-        for (const PathPortal &portal : dp.portals)
+        for (size_t idx = 0; idx < nav::num_portals(dp); ++idx)
         {
+          const PathPortal portal = nav::get_portal(dp, idx);
           Rectangle rect{portal.startX * tile_size, portal.startY * tile_size,
                          (portal.endX - portal.startX + 1) * tile_size,
                          (portal.endY - portal.startY + 1) * tile_size};
@@ -123,9 +120,9 @@ static void register_roguelike_systems(flecs::world &ecs)
               mousePosition.y < rect.y || mousePosition.y > rect.y + rect.height)
             continue;
           DrawRectangleLinesEx(rect, 4, WHITE);
-          for (const PortalConnection &conn : portal.conns)
+          for (const PortalConnection &conn : nav::portal_conns(dp, idx))
           {
-            const PathPortal &endPortal = dp.portals[conn.connIdx];
+            const PathPortal endPortal = nav::get_portal(dp, conn.connIdx);
             Vector2 toCenter{(endPortal.startX + endPortal.endX + 1) * tile_size * 0.5f,
                              (endPortal.startY + endPortal.endY + 1) * tile_size * 0.5f};
             DrawLineEx(fromCenter, toCenter, 1.f, WHITE);
@@ -135,6 +132,38 @@ static void register_roguelike_systems(flecs::world &ecs)
                      16, WHITE);
           }
         }
+        // hierarchical path from the player to the cursor
+        playerPosQuery.each([&](const Position &pp, const IsPlayer &)
+        {
+          const IVec2 from = world_to_tile(pp);
+          const IVec2 to{int(floorf(mousePosition.x / tile_size)), int(floorf(mousePosition.y / tile_size))};
+          const std::vector<IVec2> path = find_hierarchical_path(dd, dp, dc, from, to);
+          for (const IVec2 &p : path)
+            DrawRectangleRec(Rectangle{float(p.x) * tile_size, float(p.y) * tile_size, tile_size, tile_size},
+                             GetColor(0x44000088));
+          // what a follower would steer along
+          const std::vector<Position> waypoints = smooth_path(ng, path);
+          const Vector2 halfTile{tile_size * 0.5f, tile_size * 0.5f};
+          for (size_t i = 1; i < waypoints.size(); ++i)
+            DrawLineEx(Vector2{waypoints[i - 1].x + halfTile.x, waypoints[i - 1].y + halfTile.y},
+                       Vector2{waypoints[i].x + halfTile.x, waypoints[i].y + halfTile.y}, 3.f, YELLOW);
+        });
+      });
+    });
+  // the sync point of the path service, waypoints requested in earlier frames land here before anyone steers
+  ecs.system<const NavGrid>()
+    .kind(flecs::PreUpdate)
+    .each([&](const NavGrid &)
+    {
+      sync_paths();
+    });
+  // one reverse search toward the player serves every seeker
+  ecs.system<FlowField, const DungeonData>()
+    .each([&](FlowField &ff, const DungeonData &dd)
+    {
+      playerPosQuery.each([&](const Position &pp, const IsPlayer &)
+      {
+        update_flow_field(ff, dd, pp);
       });
     });
   steer::register_systems(ecs);
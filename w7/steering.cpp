@@ -1,5 +1,6 @@
 #include "steering.h"
 #include "ecsTypes.h"
+#include "pathfinder.h"
 
 struct Seeker {};
 struct Pursuer {};
@@ -42,7 +43,7 @@ flecs::entity steer::create_seeker(flecs::entity e)
 
 flecs::entity steer::create_pursuer(flecs::entity e)
 {
-  return create_steerer(e).add<Pursuer>();
+  return create_steerer(e).add<Pursuer>().set(WaypointPath{});
 }
 
 flecs::entity steer::create_evader(flecs::entity e)
@@ -83,14 +84,20 @@ void steer::register_systems(flecs::world &ecs)
   // reset steer dir
   ecs.system<SteerDir>().each([&](SteerDir &sd) { sd = {0.f, 0.f}; });
 
-  // seeker
+  // seeker, follows the flow field around walls
+  static auto flowFieldQuery = ecs.query<const FlowField, const NavGrid>();
   ecs.system<SteerDir, const MoveSpeed, const Velocity, const Position, const Seeker>()
     .each([&](SteerDir &sd, const MoveSpeed &ms, const Velocity &vel,
               const Position &p, const Seeker &)
     {
       playerPosQuery.each([&](const Position &pp, const Velocity &, const IsPlayer &)
       {
-        sd += SteerDir{normalize(pp - p) * ms.speed - vel};
+        Position target = pp;
+        flowFieldQuery.each([&](const FlowField &ff, const NavGrid &ng)
+        {
+          target = flow_steer_target(ff, ng, p, pp);
+        });
+        sd += SteerDir{normalize(target - p) * ms.speed - vel};
       });
     });
 
@@ -104,15 +111,57 @@ void steer::register_systems(flecs::world &ecs)
       });
     });
 
-  // pursuer
-  ecs.system<SteerDir, const MoveSpeed, const Velocity, const Position, const Pursuer>()
-    .each([&](SteerDir &sd, const MoveSpeed &ms, const Velocity &vel, const Position &p, const Pursuer &)
+  // pursuer, follows waypoints to the predicted position, they are searched off the main thread
+  static auto waypointGridQuery = ecs.query<const NavGrid, const DungeonComponents>();
+  ecs.system<SteerDir, WaypointPath, const MoveSpeed, const Velocity, const Position, const Pursuer>()
+    .each([&](SteerDir &sd, WaypointPath &wp, const MoveSpeed &ms, const Velocity &vel, const Position &p,
+              const Pursuer &)
     {
       playerPosQuery.each([&](const Position &pp, const Velocity &pvel, const IsPlayer &)
       {
         constexpr float predictTime = 4.f;
+        constexpr float repathTime = 0.5f;
         const Position targetPos = pp + pvel * predictTime;
-        sd += SteerDir{normalize(targetPos - p) * ms.speed - vel};
+        const IVec2 targetTile = world_to_tile(targetPos);
+        wp.repathIn -= ecs.delta_time();
+        // a search still running for a tile the target has left is dropped for a new one
+        if (wp.repathIn <= 0.f && (wp.request == nav::invalid_path_handle || wp.requestTo != targetTile))
+        {
+          if (wp.request != nav::invalid_path_handle)
+            cancel_waypoints(wp.request);
+          // closer pursuers are served first
+          wp.request = request_waypoints(p, targetPos, -int(length(pp - p) / tile_size));
+          wp.requestTo = targetTile;
+          wp.repathIn = repathTime;
+        }
+        if (wp.request != nav::invalid_path_handle &&
+            take_waypoints(wp.request, wp.points) != nav::PathStatus::Pending)
+        {
+          wp.request = nav::invalid_path_handle;
+          wp.next = 0;
+        }
+        constexpr float reachedDistSq = tile_size * tile_size * 0.25f;
+        while (wp.next < wp.points.size() && length_sq(wp.points[wp.next] - p) < reachedDistSq)
+          wp.next++;
+        // nothing left to follow while the service is still searching, lazy Theta* gives waypoints right away
+        const bool waiting = wp.next >= wp.points.size() && wp.request != nav::invalid_path_handle;
+        if (waiting)
+          waypointGridQuery.each([&](const NavGrid &ng, const DungeonComponents &dc)
+          {
+            if (find_waypoints_now(ng, dc, p, targetPos, wp.points))
+              wp.next = 1; // the first one is the tile the pursuer stands on
+          });
+        // no path or the path is walked, head straight for it
+        Position steerTo = targetPos;
+        if (wp.next < wp.points.size())
+          steerTo = wp.points[wp.next];
+        else if (waiting)
+          // this frame's searches are used up, the seekers' field leads toward the player meanwhile
+          flowFieldQuery.each([&](const FlowField &ff, const NavGrid &ng)
+          {
+            steerTo = flow_steer_target(ff, ng, p, pp);
+          });
+        sd += SteerDir{normalize(steerTo - p) * ms.speed - vel};
       });
     });
 